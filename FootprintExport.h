@@ -0,0 +1,337 @@
+// ==================================================================================
+// FOOTPRINT EXPORT
+// Closed-bar footprints (bid/ask volume per price, delta, POC, strategy events) as the
+// study saw them, appended to a columnar file for research tools. The study thread only
+// fills a pooled record and hands it over; a writer thread batches records into row
+// groups and does all file I/O, so bar processing never waits on the disk.
+//
+// File layout, little-endian:
+//   FootprintFileHeader
+//   row groups, each:
+//     FootprintGroupHeader
+//     bar columns, barCount values each, in FootprintBar field order:
+//       int64 timeMillis, int32 barIndex, int32 open/high/low/close ticks, int32 pocTicks,
+//       int32 delta, uint32 volume, uint32 events, uint32 flags, uint32 levelCount
+//     level columns, levelCount values each (bars' levels back to back, low to high):
+//       int32 priceTicks, uint32 bidVolume, uint32 askVolume
+// Event bits 0-15 are strategies (the study's own numbering), 16 and up FootprintEvents.
+// ==================================================================================
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static const uint32_t kFootprintFileMagic = 0x31504641;     // "AFP1"
+static const uint32_t kFootprintGroupMagic = 0x47504641;    // "AFPG"
+static const uint32_t kFootprintVersion = 1;
+static const int kFootprintPoolSize = 256;                  // Bars in flight before new ones are dropped
+static const int kFootprintGroupBars = 64;                  // Flush threshold
+static const int kFootprintFlushMillis = 1000;              // Longest a closed bar waits for its group
+
+enum FootprintFlags : uint32_t {
+    FOOTPRINT_APPROXIMATE = 1u << 0     // No per-price data: bar bid/ask volume spread over its range
+};
+
+enum FootprintEvents : uint32_t {
+    FOOTPRINT_EVENT_LONG_ENTRY = 1u << 16,
+    FOOTPRINT_EVENT_SHORT_ENTRY = 1u << 17
+};
+
+struct FootprintLevel {
+    int32_t priceTicks;
+    uint32_t bidVolume;
+    uint32_t askVolume;
+};
+
+struct FootprintBar {
+    int64_t timeMillis;         // Bar start, Unix epoch, chart time zone
+    int32_t barIndex;
+    int32_t openTicks;
+    int32_t highTicks;
+    int32_t lowTicks;
+    int32_t closeTicks;
+    int32_t pocTicks;           // Highest-volume level, the lower one on ties
+    int32_t delta;              // Ask volume - bid volume
+    uint32_t volume;
+    uint32_t events;            // Strategy event bits for the bar
+    uint32_t flags;             // FootprintFlags
+    std::vector<FootprintLevel> levels;     // Low to high, traded levels only
+};
+
+#pragma pack(push, 1)
+struct FootprintFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    double tickSize;
+    char symbol[32];
+};
+
+struct FootprintGroupHeader {
+    uint32_t magic;
+    uint32_t barCount;
+    uint32_t levelCount;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FootprintFileHeader) == 48, "footprint file header is part of the file format");
+static_assert(sizeof(FootprintGroupHeader) == 16, "footprint group header is part of the file format");
+
+class FootprintExporter {
+public:
+    FootprintExporter()
+    {
+        for (int r = 0; r < kFootprintPoolSize; r++)
+        {
+            m_pool.emplace_back(new FootprintBar());
+            m_pool.back()->levels.reserve(128);
+            m_free.push_back(m_pool.back().get());
+        }
+        m_pending.reserve(kFootprintPoolSize);
+        m_writing.reserve(kFootprintPoolSize);
+    }
+
+    FootprintExporter(const FootprintExporter&) = delete;
+    FootprintExporter& operator=(const FootprintExporter&) = delete;
+    ~FootprintExporter() { Close(); }
+
+    // Starts a new file, or appends to an existing one whose header has the same version, symbol
+    // and tick size. Any other existing file is left alone and Open fails; Error() says why.
+    bool Open(const std::string& path, const char* symbol, double tickSize)
+    {
+        Close();
+        m_error.clear();
+
+        FootprintFileHeader header = {};
+        header.magic = kFootprintFileMagic;
+        header.version = kFootprintVersion;
+        header.tickSize = tickSize;
+        std::strncpy(header.symbol, symbol ? symbol : "", sizeof(header.symbol) - 1);
+
+        if (FILE* existing = std::fopen(path.c_str(), "rb"))
+        {
+            FootprintFileHeader found = {};
+            size_t read = std::fread(&found, 1, sizeof(found), existing);
+            std::fclose(existing);
+            if (read != 0 && (read != sizeof(found) || found.magic != kFootprintFileMagic ||
+                              found.version != kFootprintVersion))
+            {
+                m_error = "not a footprint file of this version";
+                return false;
+            }
+            if (read != 0 && (found.tickSize != header.tickSize ||
+                              std::strncmp(found.symbol, header.symbol, sizeof(header.symbol)) != 0))
+            {
+                found.symbol[sizeof(found.symbol) - 1] = '\0';
+                m_error = std::string("written for ") + found.symbol + " at tick size " + std::to_string(found.tickSize);
+                return false;
+            }
+        }
+
+        m_file = std::fopen(path.c_str(), "ab");
+        if (!m_file)
+        {
+            m_error = "cannot open for writing";
+            return false;
+        }
+        // Groups go out in one write each; no bytes may linger in a stdio buffer after a failure
+        std::setvbuf(m_file, nullptr, _IONBF, 0);
+        std::fseek(m_file, 0, SEEK_END);
+        if (std::ftell(m_file) == 0 &&
+            (std::fwrite(&header, sizeof(header), 1, m_file) != 1 || std::fflush(m_file) != 0))
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+            m_error = "cannot write the file header";
+            return false;
+        }
+        m_path = path;
+        m_stopping = false;
+        m_broken = false;
+        m_thread = std::thread(&FootprintExporter::WriterLoop, this);
+        return true;
+    }
+
+    // Drains every queued bar, then stops the writer
+    void Close()
+    {
+        if (!m_thread.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+        std::fclose(m_file);
+        m_file = nullptr;
+        m_path.clear();
+    }
+
+    bool IsOpen() const { return m_file != nullptr; }
+    const std::string& Path() const { return m_path; }
+    const std::string& Error() const { return m_error; }    // Why the last Open failed
+
+    // Study thread: a record to fill, or nullptr while the writer is behind (the bar is dropped)
+    FootprintBar* Acquire()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty())
+        {
+            m_dropped++;
+            return nullptr;
+        }
+        FootprintBar* bar = m_free.back();
+        m_free.pop_back();
+        return bar;
+    }
+
+    // Study thread: queue a filled record; the writer is only woken once a group is ready
+    void Publish(FootprintBar* bar)
+    {
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending.push_back(bar);
+            wake = m_pending.size() >= static_cast<size_t>(kFootprintGroupBars);
+        }
+        if (wake) m_wake.notify_one();
+    }
+
+    unsigned long long BarsWritten() const { return m_written; }
+    unsigned long long BarsDropped() const { return m_dropped; }
+    unsigned long long BarsFailed() const { return m_failed; }     // Lost to write errors
+
+private:
+    void WriterLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;)
+        {
+            m_wake.wait_for(lock, std::chrono::milliseconds(kFootprintFlushMillis), [this] {
+                return m_stopping || m_pending.size() >= static_cast<size_t>(kFootprintGroupBars);
+            });
+            if (!m_pending.empty())
+            {
+                m_writing.swap(m_pending);
+                lock.unlock();
+                WriteGroup();
+                lock.lock();
+                for (FootprintBar* bar : m_writing) m_free.push_back(bar);
+                m_writing.clear();
+            }
+            if (m_stopping && m_pending.empty()) return;
+        }
+    }
+
+    // Writer thread: transposes the batch into columns and appends it as one row group
+    void WriteGroup()
+    {
+        size_t barCount = m_writing.size();
+        if (m_broken)
+        {
+            m_failed += barCount;
+            return;
+        }
+        size_t levelCount = 0;
+        for (const FootprintBar* bar : m_writing) levelCount += bar->levels.size();
+
+        FootprintGroupHeader header = {kFootprintGroupMagic, static_cast<uint32_t>(barCount),
+                                       static_cast<uint32_t>(levelCount), 0};
+        m_buffer.clear();
+        Append(&header, sizeof(header));
+
+        AppendColumn(&FootprintBar::timeMillis);
+        AppendColumn(&FootprintBar::barIndex);
+        AppendColumn(&FootprintBar::openTicks);
+        AppendColumn(&FootprintBar::highTicks);
+        AppendColumn(&FootprintBar::lowTicks);
+        AppendColumn(&FootprintBar::closeTicks);
+        AppendColumn(&FootprintBar::pocTicks);
+        AppendColumn(&FootprintBar::delta);
+        AppendColumn(&FootprintBar::volume);
+        AppendColumn(&FootprintBar::events);
+        AppendColumn(&FootprintBar::flags);
+        for (const FootprintBar* bar : m_writing)
+        {
+            uint32_t levels = static_cast<uint32_t>(bar->levels.size());
+            Append(&levels, sizeof(levels));
+        }
+
+        AppendLevelColumn(&FootprintLevel::priceTicks);
+        AppendLevelColumn(&FootprintLevel::bidVolume);
+        AppendLevelColumn(&FootprintLevel::askVolume);
+
+        // A short write is cut back to where the group started, so readers never meet a
+        // partial group; if that fails too, nothing more is appended behind it
+        long groupStart = std::ftell(m_file);
+        if (std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size() || std::fflush(m_file) != 0)
+        {
+            m_failed += barCount;
+            std::clearerr(m_file);
+            if (groupStart < 0 || !TruncateTo(groupStart)) m_broken = true;
+            return;
+        }
+        m_written += barCount;
+    }
+
+    // The stream's position is moved back with the file's end, so the next group's start is right
+    bool TruncateTo(long offset)
+    {
+#ifdef _WIN32
+        bool cut = _chsize_s(_fileno(m_file), offset) == 0;
+#else
+        bool cut = ftruncate(fileno(m_file), offset) == 0;
+#endif
+        return cut && std::fseek(m_file, offset, SEEK_SET) == 0;
+    }
+
+    template <typename T>
+    void AppendColumn(T FootprintBar::*field)
+    {
+        for (const FootprintBar* bar : m_writing) Append(&(bar->*field), sizeof(T));
+    }
+
+    template <typename T>
+    void AppendLevelColumn(T FootprintLevel::*field)
+    {
+        for (const FootprintBar* bar : m_writing)
+            for (const FootprintLevel& level : bar->levels) Append(&(level.*field), sizeof(T));
+    }
+
+    void Append(const void* data, size_t bytes)
+    {
+        const char* begin = static_cast<const char*>(data);
+        m_buffer.insert(m_buffer.end(), begin, begin + bytes);
+    }
+
+    std::vector<std::unique_ptr<FootprintBar>> m_pool;
+    std::vector<FootprintBar*> m_free;
+    std::vector<FootprintBar*> m_pending;       // Published, not yet taken by the writer
+    std::vector<FootprintBar*> m_writing;       // Writer-owned batch
+    std::vector<char> m_buffer;                 // Writer-owned row group
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_thread;
+    bool m_stopping = false;
+    bool m_broken = false;                      // A partial group could not be cut back
+    FILE* m_file = nullptr;
+    std::string m_path;
+    std::string m_error;
+    std::atomic<unsigned long long> m_written{0};
+    std::atomic<unsigned long long> m_dropped{0};
+    std::atomic<unsigned long long> m_failed{0};
+};
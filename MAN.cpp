@@ -10,6 +10,23 @@
 #include <numeric>
 #include <memory>
 #include <cmath>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <filesystem>
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "ProfileNodes.h"
+#include "StrategyBridge.h"
+#include "FootprintExport.h"
+#include "StudyProbes.h"
 
 SCDLLName("Advanced Order Flow Trading Bot v2.0")
 
@@ -21,12 +38,60 @@ struct TradeSignal {
     int direction;          // 1 = Long, -1 = Short, 0 = No Signal
     float confidence;       // 0.0 to 1.0
     std::string strategy;   // Strategy name
-    float entryPrice;
-    float stopLoss;
-    float target;
+    int entryTicks;         // Prices in integer ticks, converted at order submission
+    int stopTicks;
+    int targetTicks;
     std::string reason;
 };
 
+// One bar's candidate signals as columns, reused from bar to bar. Selection scans the
+// confidence column alone; names and reasons are only moved out for the winner.
+const int kMaxBarSignals = 16;
+
+struct SignalColumns {
+    alignas(64) float confidence[kMaxBarSignals];
+    alignas(64) int32_t direction[kMaxBarSignals];
+    int32_t entryTicks[kMaxBarSignals];
+    int32_t stopTicks[kMaxBarSignals];
+    int32_t targetTicks[kMaxBarSignals];
+    std::string strategy[kMaxBarSignals];   // Cold
+    std::string reason[kMaxBarSignals];
+    int count = 0;
+
+    void Clear() { count = 0; }
+    bool Empty() const { return count == 0; }
+
+    void Add(TradeSignal& signal)
+    {
+        if (count == kMaxBarSignals) return;
+        confidence[count] = signal.confidence;
+        direction[count] = signal.direction;
+        entryTicks[count] = signal.entryTicks;
+        stopTicks[count] = signal.stopTicks;
+        targetTicks[count] = signal.targetTicks;
+        strategy[count].swap(signal.strategy);
+        reason[count].swap(signal.reason);
+        count++;
+    }
+
+    // Highest confidence, the earliest on ties
+    int Best() const
+    {
+        int best = 0;
+        for (int s = 1; s < count; s++)
+            if (confidence[s] > confidence[best]) best = s;
+        return best;
+    }
+
+    TradeSignal Take(int s)
+    {
+        TradeSignal signal = {direction[s], confidence[s], "", entryTicks[s], stopTicks[s], targetTicks[s], ""};
+        signal.strategy.swap(strategy[s]);
+        signal.reason.swap(reason[s]);
+        return signal;
+    }
+};
+
 struct StrategyConfig {
     bool isEnabled;
     float weightMultiplier;
@@ -44,13 +109,7 @@ struct RiskMetrics {
     float profitFactor;
     float largestWin;
     float largestLoss;
-};
-
-struct VolumeProfileLevel {
-    float price;
-    float volume;
-    bool isHVN;
-    bool isLVN;
+    float peakBalance;      // Per study instance, so charts and headless symbols don't share it
 };
 
 struct OrderFlowData {
@@ -59,6 +118,498 @@ struct OrderFlowData {
     float volumeImbalance;
     float absorptionStrength;
     std::vector<VolumeProfileLevel> profileLevels;
+    std::vector<float> volumeAtTick;    // Profile scratch, indexed by tick offset from profileBaseTick
+    int profileBaseTick;
+};
+
+// Bar prices converted once per update to integer ticks. Strategies compare, measure
+// proximity and index the profile in ticks; only plotting and orders convert back.
+struct TickPriceSeries {
+    std::vector<int32_t> open;
+    std::vector<int32_t> high;
+    std::vector<int32_t> low;
+    std::vector<int32_t> close;
+};
+
+// Per tick level, the last few closed bars that traded it and what they did there, so level
+// strategies weigh retests and fresh levels with one lookup instead of scanning bars. Bars are
+// recorded in order up to the bar being evaluated, so a signal never sees later bars.
+const int kLevelTouchDepth = 8;             // Touches remembered per level
+const int kLevelTouchMargin = 256;          // Ticks added either side when the index grows
+const int kLevelTouchMaxLevels = 1 << 16;   // Past this the index restarts around the price
+
+enum TouchOutcome : uint8_t {
+    TOUCH_TRADED,           // Opened or closed on the level
+    TOUCH_REJECTED,         // Reached the level, opened and closed on the same side
+    TOUCH_BROKEN            // Opened on one side, closed on the other
+};
+
+struct LevelTouches {
+    int32_t bar[kLevelTouchDepth];          // Ring, newest at head - 1
+    float breakVolume[kLevelTouchDepth];    // Bar volume of TOUCH_BROKEN entries
+    uint8_t outcome[kLevelTouchDepth];      // TouchOutcome
+    uint8_t head;
+    uint8_t count;
+};
+
+struct LevelTouchIndex {
+    std::vector<LevelTouches> levels;       // Indexed by tick - baseTick
+    int baseTick = 0;
+    int nextBar = 0;                        // First closed bar not yet recorded
+};
+
+// A level's touches within the memory window before the evaluated bar
+struct TouchSummary {
+    int touches;
+    int rejections;
+    int breaks;
+    float lastBreakVolume;                  // 0 without a break
+};
+
+// Prior-session and round-number levels, tracked from closed bars and kept as a bitmap over a
+// tick window around price, so "nearest level within K ticks" is a couple of bit scans.
+const int kReferenceWindowWords = 64;
+const int kReferenceWindowTicks = kReferenceWindowWords * 64;
+const int kNoReferenceLevel = INT_MIN;
+
+enum ReferenceLevelKind {
+    REFERENCE_PRIOR_HIGH,
+    REFERENCE_PRIOR_LOW,
+    REFERENCE_SETTLEMENT,       // Last regular-session close of the prior day
+    REFERENCE_OVERNIGHT_HIGH,
+    REFERENCE_OVERNIGHT_LOW,
+    REFERENCE_SESSION_OPEN,
+    kReferenceLevelKinds
+};
+
+struct ReferenceLevels {
+    uint64_t bits[kReferenceWindowWords] = {};  // Bit n: baseTick + n is a level
+    int baseTick = 0;
+    int roundStepTicks = -1;                    // Round numbers in the bitmap, 0 none
+    bool dirty = true;                          // Levels changed since the bitmap was built
+    int level[kReferenceLevelKinds] = {kNoReferenceLevel, kNoReferenceLevel, kNoReferenceLevel,
+                                       kNoReferenceLevel, kNoReferenceLevel, kNoReferenceLevel};   // Ticks
+
+    // Session being built
+    bool inSession = false;
+    int sessionDate = 0;
+    int dayHigh = 0;
+    int dayLow = 0;
+    int dayClose = 0;
+    bool hasOvernight = false;
+    int overnightHigh = 0;
+    int overnightLow = 0;
+    int nextBar = 0;                            // First closed bar not yet recorded
+};
+
+static_assert(kReferenceLevelKinds == 6, "ReferenceLevels::level initializer lists every kind");
+
+// Numeric strategy and risk parameters. Resolved from the study inputs and then
+// overlaid with the active parameter profile, so the per-bar code never touches sc.Input.
+struct StrategyParameters {
+    // Risk management
+    int tradeQuantity;
+    int maxDailyTrades;
+    float maxDailyLoss;
+    float dailyProfitTarget;
+    float maxPortfolioHeat;
+    float positionRiskPercent;
+
+    // Liquidity absorption
+    int absorptionVolumeThreshold;
+    int absorptionStallTicks;
+    int absorptionConfirmationBars;
+
+    // Footprint features
+    float footprintFeatureWeight;   // 0 = footprint features off
+    float exhaustionVolumeRatio;
+
+    // Iceberg detection
+    int icebergMinHitVolume;
+    int icebergDetectionBars;
+    int icebergToleranceTicks;
+    int icebergClipWindowSeconds;
+    int icebergMinClipRepeats;
+    float icebergClipBoost;
+
+    // Delta analysis
+    int deltaMAPeriod;
+    int divergenceLookback;
+    float deltaExhaustionThreshold;
+
+    // Volume profile
+    float hvnMultiplier;
+    float lvnMultiplier;
+    int profileLookbackBars;
+    int levelProximityTicks;
+    float touchHistoryWeight;       // 0 = touch history off
+    int touchMemoryBars;
+
+    // Reference levels
+    float referenceLevelWeight;     // 0 = level service off
+    int referenceProximityTicks;
+    int roundNumberTicks;           // 0 = no round numbers
+
+    // Breakout & momentum
+    float breakoutVolumeMultiplier;
+    int breakoutLookback;
+    int momentumConfirmationBars;
+
+    // Order book filter
+    int bookDepthLevels;
+    float minBookImbalance;
+
+    // Flow toxicity
+    int vpinBucketVolume;
+    int vpinWindowBuckets;
+    float maxFadeVpin;
+
+    // Canonical bars
+    int canonicalBarType;           // CanonicalBarType
+    int canonicalVolumeBarSize;     // Contracts per volume bar
+    int canonicalRangeBarTicks;     // Ticks per range bar
+
+    // Strategy circuit breakers, 0 = off
+    int breakerMaxConsecutiveLosses;
+    float breakerMaxDrawdown;
+    float breakerMaxErrorPercent;
+    int breakerMaxSlippageTicks;
+
+    // Feed watchdog, 0 = check off
+    float staleSilenceSeconds;
+    float staleLagSeconds;
+};
+
+// Contract specification for the charted instrument. Sessions are in chart time (ET).
+// Tick conversions multiply by the precomputed reciprocal instead of dividing by sc.TickSize.
+struct InstrumentMetadata {
+    std::string root;
+    std::string currency;
+    float tickSize;
+    double invTickSize;     // 1 / tickSize
+    float tickValue;        // Currency per tick
+    float pointValue;       // Currency per 1.0 price move
+    int sessionOpen;        // Regular session open, seconds since midnight
+    int sessionClose;       // Regular session close, seconds since midnight
+    bool isKnown;           // false = resolved from chart settings only
+};
+
+// Runtime health of the study itself, measured once per study call and shown on the chart
+struct EngineHealth {
+    std::chrono::steady_clock::time_point updateStart;
+    float lastUpdateMicros;
+    float avgUpdateMicros;      // Exponential average over recent calls
+    float maxUpdateMicros;      // Worst call since the last full recalculation
+    int barsLastUpdate;
+    int logLinesLastUpdate;
+    int logLinesThisUpdate;
+    int orderTokens;            // Entries still allowed today
+    long long updateCount;
+    bool feedStale;
+};
+
+// Feed heartbeat. Each call only stores when new data last arrived (monotonic clock) and, when
+// the exchange timestamp moves, how far it trailed local time. The feed is stale after too long
+// without data or when data arrives too late; while stale no bar of a live update takes entries.
+struct FeedWatchdog {
+    double lastDataTime = 0.0;                          // sc.LatestDateTimeForLastBar of the newest data
+    int lastArraySize = 0;
+    float lastVolume = 0.0f;                            // Last bar's volume, moves between timestamp ticks
+    std::chrono::steady_clock::time_point lastArrival;
+    float arrivalLagSeconds = 0.0f;                     // Local time minus exchange time on arrival
+    bool stale = false;
+    long long staleEvents = 0;
+};
+
+// Study side of the shared-memory bridge to StrategyWorker. Live bars are published to the
+// worker and profile nodes come back asynchronously; the chart thread never waits on it.
+struct StrategyBridgeState {
+    BridgeMapping mapping;
+    std::string name;
+    uint32_t producerOwner = 0;     // Token held in the segment while this study is the producer
+    std::string failedName;         // Last name that could not be opened or claimed
+    std::chrono::steady_clock::time_point lastOpenAttempt;
+    uint32_t lastWorkerBeat = 0;
+    std::chrono::steady_clock::time_point lastBeatChange;
+    bool workerAlive = false;
+    uint32_t workerEpoch = 0;       // Worker run the published bars went to
+    int publishedFrom = -1;         // Bar window the worker currently holds
+    int publishedThrough = -1;
+    uint32_t sequence = 0;
+    uint32_t latestRequestId = 0;   // Only the newest request's levels are applied
+    std::vector<VolumeProfileLevel> pendingLevels;
+
+    ~StrategyBridgeState() { mapping.ReleaseProducer(producerOwner); }
+};
+
+// Top of the displayed book in integer ticks, refreshed once per study call. Levels are
+// compared against the previous snapshot and only changed ones move the running sums, so a
+// refresh is a few integer operations per changed level over fixed arrays.
+const int kMaxDepthLevels = 10;
+
+struct DepthFeatures {
+    int32_t bidTicks[kMaxDepthLevels];
+    int32_t askTicks[kMaxDepthLevels];
+    int32_t bidQuantity[kMaxDepthLevels];
+    int32_t askQuantity[kMaxDepthLevels];
+    int levelCount;             // Levels tracked per side
+    int64_t bidQuantitySum;     // Over the tracked levels
+    int64_t askQuantitySum;
+    int64_t bidTickVolume;      // Sum of quantity * ticks, for the depth-weighted mid
+    int64_t askTickVolume;
+    float imbalance;            // (bid - ask) / (bid + ask) over the tracked levels, -1..1
+    double micropriceTicks;     // Best bid and ask weighted by the opposite side's size
+    double weightedMidTicks;    // Midpoint of the two sides' depth-weighted prices
+    long long levelChanges;     // Levels rewritten since the study started
+    bool hasBook;               // Both sides had a best level at the last refresh
+};
+
+// Identical trade sizes repeating at one price and tape side, the fingerprint of iceberg
+// refills and sliced algo orders. Clusters live in an open-addressing table keyed by price,
+// size and side; a probe is bounded, so recording a trade is O(1) and never allocates.
+// A cluster expires once no repeat has printed within the clip window.
+const int kClusterTableSlots = 4096;       // Power of two
+const int kClusterProbeLimit = 16;
+const int kClusterFlagsPerSide = 8;
+
+struct TradeClusterSlot {
+    uint64_t key;           // Price ticks, size and side packed; 0 = empty
+    int64_t lastMillis;     // Time of the latest repeat
+    int32_t count;          // Repeats since the cluster (re)started
+};
+
+struct ClipClusterFlag {
+    int32_t priceTicks;
+    int32_t size;
+    int32_t count;
+    int64_t lastMillis;
+};
+
+// VPIN-style toxicity: classified volume is cut into equal-volume buckets and the metric is
+// the mean |buy - sell| / bucket volume over the last window of buckets. Fed per trade from
+// Time & Sales; without a tape (replay, history) closed bars' bid/ask volume stands in.
+const int kMaxVpinBuckets = 200;
+
+struct FlowToxicity {
+    float bucketImbalance[kMaxVpinBuckets];     // Ring of completed buckets
+    int windowBuckets;          // Ring size in use
+    int bucketCount;            // Completed buckets in the ring
+    int nextBucket;
+    double imbalanceSum;        // Over the ring
+    double bucketBuy;           // Volume in the bucket being filled
+    double bucketSell;
+    float vpin;                 // Valid once the ring is full
+    long long bucketsCompleted;
+    int barsFed;                // Bar fallback: bars before this index are in
+    bool fromTape;              // The tape has delivered trades; bars no longer feed it
+    bool toxic;                 // Last reported state, for logging transitions
+};
+
+// Canonical bars: volume or range bars the study builds itself, so volume thresholds mean the
+// same whatever chart type the study is on. Live trades come from Time & Sales. Chart bars the
+// tape did not cover stand in: a closed bar as four prints (open, nearer extreme, farther
+// extreme, close) with its volume split evenly, the forming bar as what changed since the last
+// call (new extremes, then the added volume at the close). Completed bars sit in a fixed ring,
+// each stamped with the chart bar it closed in, so evaluating a chart bar never sees a
+// canonical bar that closed after it.
+const int kCanonicalBarRing = 256;
+
+enum CanonicalBarType {
+    CANONICAL_CHART_BARS,       // Off: strategies read the chart's own bars
+    CANONICAL_VOLUME_BARS,
+    CANONICAL_RANGE_BARS
+};
+
+// A bar as the volume-threshold strategies see it, canonical or the chart's own
+struct CanonicalBar {
+    int32_t open;               // Ticks
+    int32_t high;
+    int32_t low;
+    int32_t close;
+    float volume;
+    float bidVolume;
+    float askVolume;
+    int32_t chartBar;           // Chart bar during which it closed
+};
+
+struct CanonicalBarSeries {
+    CanonicalBar bars[kCanonicalBarRing];   // Completed bars, ring
+    int nextSlot;
+    long long completed;
+    CanonicalBar forming;
+    bool hasForming;
+    int type;                   // CanonicalBarType the bars were built with
+    int size;                   // Contracts or ticks per bar
+    int barsFed;                // Chart bars before this index are in
+    int tapeBar;                // Chart bar the tape is feeding, -1 none; the bar fallback skips it
+    int partialBar;             // Chart bar fed while forming, -1 none, and what of it is in
+    int partialHigh;
+    int partialLow;
+    float partialBidVolume;
+    float partialAskVolume;
+};
+
+struct TradeTapeState {
+    c_SCTimeAndSalesArray timeSales;    // Reused for every pump
+    unsigned int lastSequence;          // Newest Time & Sales record consumed
+    int64_t lastTradeMillis;            // Tape clock
+    TradeClusterSlot clusters[kClusterTableSlots];
+    ClipClusterFlag flags[2][kClusterFlagsPerSide];     // Latest flagged clusters: [0] at bid, [1] at ask
+    int nextFlag[2];
+    long long tradesSeen;
+    long long clustersFlagged;
+    FlowToxicity toxicity;
+    CanonicalBarSeries canonicalBars;
+};
+
+// Closed bars go to the footprint exporter's writer thread once each, after the call's bar loop,
+// so the final pass over a bar that just closed is included. Strategy events are kept per bar
+// for the last kFootprintEventBars bars and travel with the bar when it is exported.
+const int kFootprintEventBars = 256;    // Power of two; longer catch-up batches lose older events
+
+struct FootprintExportState {
+    FootprintExporter exporter;
+    int barsExported;           // Bars before this index have been considered
+    int eventBar[kFootprintEventBars];      // Bar each slot's events belong to
+    uint32_t events[kFootprintEventBars];
+    bool openFailed;            // Not retried until the export is switched off and on
+    unsigned long long droppedReported;
+    unsigned long long failedReported;
+};
+
+// What a bar's footprint shows at its high and low, worked out from BuildFootprintBar's levels
+// once per closed bar, so the absorption and stop-run strategies see more than bar totals.
+// Measurements only; exhaustion is judged against the current ratio when a signal asks.
+const int kFootprintExtremeRows = 2;        // Levels at each end summed for the extreme delta
+
+enum FootprintFeatureFlags : uint8_t {
+    FOOTPRINT_FEATURES_COMPUTED = 1u << 0,
+    FOOTPRINT_UNFINISHED_HIGH = 1u << 1,    // Bid volume traded at the high
+    FOOTPRINT_UNFINISHED_LOW = 1u << 2,     // Ask volume traded at the low
+    FOOTPRINT_DIVERGENT_HIGH = 1u << 3,     // Sellers won the top of a bar buyers won
+    FOOTPRINT_DIVERGENT_LOW = 1u << 4       // Buyers won the bottom of a bar sellers won
+};
+
+struct FootprintFeatures {
+    uint8_t flags;              // FootprintFeatureFlags
+    uint16_t levelCount;        // 0 without per-price data; nothing else is set then
+    uint32_t volume;
+    uint32_t highVolume;        // Bid + ask at the highest level
+    uint32_t lowVolume;
+    int32_t highDelta;          // Ask - bid over the top kFootprintExtremeRows levels
+    int32_t lowDelta;
+};
+
+struct FootprintFeatureSeries {
+    std::vector<FootprintFeatures> bars;    // By bar index, closed bars only
+    FootprintFeatures live;                 // Forming bar, redone on every request
+    FootprintBar scratch;                   // BuildFootprintBar's output, levels kept between bars
+};
+
+// Per-strategy circuit breakers: a few counters per strategy, indexed like StrategyEventBit
+// (n = input 31+n). A breaker that trips sets the strategy's bit in trippedMask and the signal
+// registry skips masked strategies, so it is off from its next evaluation until the live bar
+// reaches a new trading day; a recalculation or reload keeps the counters. Only live entries
+// count, each trade attributed through its entry order to the strategy that opened it.
+const int kStrategyCount = 10;
+const int kBreakerMinOrders = 4;                                        // Attempts before the error rate is judged
+const uint32_t kFadeStrategyMask = (1u << 0) | (1u << 5) | (1u << 9);   // Absorption, HVN rejection, traps
+
+static const char* const s_StrategyNames[kStrategyCount] = {
+    "Liquidity Absorption", "Iceberg Detection", "Delta Divergence", "Volume Imbalance",
+    "Stop Run Anticipation", "HVN Rejection", "LVN Breakout", "Momentum Breakout",
+    "Cumulative Delta Trend", "Liquidity Traps"
+};
+
+enum BreakerReason : uint8_t {
+    BREAKER_NONE,
+    BREAKER_LOSS_STREAK,
+    BREAKER_DRAWDOWN,
+    BREAKER_ORDER_ERRORS,
+    BREAKER_SLIPPAGE
+};
+
+struct StrategyBreakers {
+    uint32_t trippedMask = 0;
+    uint8_t reason[kStrategyCount] = {};            // BreakerReason of the trip
+    uint16_t consecutiveLosses[kStrategyCount] = {};
+    uint16_t orderAttempts[kStrategyCount] = {};
+    uint16_t orderErrors[kStrategyCount] = {};
+    float realizedPnL[kStrategyCount] = {};
+    float peakPnL[kStrategyCount] = {};             // Best realized P&L of the day
+    int tradingDate = 0;                            // Live bar's trading day the counters belong to
+    int openStrategy = -1;                          // Strategy of the attributed entry, -1 none
+    int openOrderId = 0;                            // Its entry order, InternalOrderID
+    int openDirection = 0;
+    int openEntryTicks = 0;                         // Signal entry, for slippage
+    double pnlAtEntry = 0.0;                        // Position daily P&L when the entry was sent
+    bool fillSeen = false;                          // The entry order has filled
+};
+
+// Why each recent bar did or did not trade: where it stopped in the gate sequence, every
+// strategy's signal, the selected one and the context the gates saw. The ring is always on and
+// costs a record reset and a few stores per bar; it is only formatted when dumped, on request
+// (input 118) or after an anomaly on the live bar.
+const int kDecisionTraceBars = 128;         // Power of two
+const int kDecisionTraceAnomalyBars = 16;   // Dumped after an anomaly
+
+enum DecisionOutcome : uint8_t {
+    DECISION_PENDING,           // Not reached the end of the evaluation
+    DECISION_TRADING_OFF,       // Trading disabled for the day
+    DECISION_RISK_LIMIT,        // Daily loss limit or profit target hit on this bar
+    DECISION_OUTSIDE_HOURS,
+    DECISION_FLATTEN_TIME,
+    DECISION_TRADE_LIMIT,
+    DECISION_IN_POSITION,
+    DECISION_NO_SIGNAL,
+    DECISION_FEED_STALE,
+    DECISION_BOOK_BLOCKED,
+    DECISION_INVALID_SIGNAL,    // Best signal failed ValidateSignal
+    DECISION_ZERO_SIZE,
+    DECISION_ORDER_REJECTED,
+    DECISION_ENTERED,
+    DECISION_CATCH_UP           // Valid signal on an older bar of a catch-up batch, not traded
+};
+
+enum DecisionFlags : uint8_t {
+    DECISION_LIVE = 1 << 0,     // Bar of a live update: the book and toxicity fields apply
+    DECISION_TOXIC = 1 << 1     // Fades were held back
+};
+
+struct DecisionTrace {
+    int32_t barIndex;
+    uint8_t outcome;                        // DecisionOutcome
+    uint8_t flags;                          // DecisionFlags
+    uint16_t evaluatedMask;                 // Strategies run, bit n = input 31+n
+    uint16_t firedMask;                     // Strategies with a signal
+    int8_t selected;                        // Strategy of the best signal, -1 none
+    int8_t direction[kStrategyCount];
+    uint8_t confidence[kStrategyCount];     // Percent
+    int32_t entryTicks;                     // Best signal
+    int32_t stopTicks;
+    int32_t targetTicks;
+    float bookImbalance;
+    float vpin;
+    float dailyPnL;
+    int32_t dailyTrades;
+};
+
+struct DecisionTraceRing {
+    DecisionTrace records[kDecisionTraceBars];
+    DecisionTrace scratch;                  // Later passes over a bar that already entered
+    long long written = 0;                  // Records begun; the newest is (written - 1) % size
+};
+
+// Double-buffered parameter set. A reload is parsed into the inactive slot and published
+// with a single pointer store, so readers never observe a half-applied profile.
+struct ParameterProfileStore {
+    StrategyParameters slots[2] = {};
+    std::atomic<const StrategyParameters*> active{nullptr};
+    int activeSlot = 0;
+    std::string symbolRoot;
+    std::string loadedPath;
+    long long loadedWriteTime = 0;
+    std::chrono::steady_clock::time_point lastCheck;
 };
 
 // Strategy Function Declarations
@@ -72,6 +623,7 @@ TradeSignal CheckLVNBreakout(SCStudyInterfaceRef sc, int index);
 TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index);
 TradeSignal CheckCumulativeDeltaTrend(SCStudyInterfaceRef sc, int index);
 TradeSignal CheckLiquidityTraps(SCStudyInterfaceRef sc, int index);
+void CollectStrategySignals(SCStudyInterfaceRef sc, int index, uint32_t strategyMask, SignalColumns& signals);
 
 // Utility Functions
 void LogTrade(SCStudyInterfaceRef sc, const TradeSignal& signal, const std::string& action);
@@ -80,9 +632,140 @@ float CalculatePositionSize(SCStudyInterfaceRef sc, const TradeSignal& signal, c
 bool ValidateSignal(SCStudyInterfaceRef sc, const TradeSignal& signal);
 void ProcessVolumeProfile(SCStudyInterfaceRef sc);
 void UpdateOrderFlowData(SCStudyInterfaceRef sc);
+void UpdateOrderFlowDataAt(SCStudyInterfaceRef sc, int index);
+void ResetTradingDay(SCStudyInterfaceRef sc, RiskMetrics& metrics, std::map<std::string, int>& strategyCounts,
+                     const StrategyParameters& params);
 bool IsWithinTradingHours(SCStudyInterfaceRef sc);
+bool IsWithinTradingHoursAt(SCStudyInterfaceRef sc, int index);
 float CalculateVolatility(SCStudyInterfaceRef sc, int lookback);
-std::vector<float> FindSwingPoints(SCStudyInterfaceRef sc, int lookback, bool findHighs);
+std::vector<int> FindSwingPoints(SCStudyInterfaceRef sc, int lookback, bool findHighs);
+
+// Parameter Profile Functions
+std::string GetSymbolRoot(const char* symbol);
+void LoadParametersFromInputs(SCStudyInterfaceRef sc, StrategyParameters& params);
+bool ApplyParameterProfile(SCStudyInterfaceRef sc, const std::string& path, const std::string& symbolRoot,
+                           const char* regime, StrategyParameters& params);
+void RefreshParameterProfile(SCStudyInterfaceRef sc, bool forceRebuild);
+const StrategyParameters& GetStrategyParameters(SCStudyInterfaceRef sc);
+
+// Instrument Metadata Functions
+void ResolveInstrumentMetadata(SCStudyInterfaceRef sc, InstrumentMetadata& instrument);
+const InstrumentMetadata& GetInstrumentMetadata(SCStudyInterfaceRef sc);
+
+inline int PriceToTicks(const InstrumentMetadata& instrument, float price)
+{
+    double ticks = price * instrument.invTickSize;
+    return static_cast<int>(ticks >= 0.0 ? ticks + 0.5 : ticks - 0.5);
+}
+
+inline float TicksToPrice(const InstrumentMetadata& instrument, int ticks)
+{
+    return static_cast<float>(ticks * static_cast<double>(instrument.tickSize));
+}
+
+inline float PriceDistanceInTicks(const InstrumentMetadata& instrument, float distance)
+{
+    return static_cast<float>(distance * instrument.invTickSize);
+}
+
+// Engine Health Functions
+void LogMessage(SCStudyInterfaceRef sc, const SCString& message, int showLog);
+void BeginEngineUpdate(SCStudyInterfaceRef sc, EngineHealth& health);
+void EndEngineUpdate(SCStudyInterfaceRef sc, EngineHealth& health, int barsProcessed, int orderTokens);
+void DrawEngineHealth(SCStudyInterfaceRef sc, const EngineHealth& health);
+
+// Decision Trace Functions
+DecisionTrace& BeginDecisionTrace(DecisionTraceRing& ring, int barIndex);
+uint32_t TraceSignals(DecisionTrace& trace, const SignalColumns& signals, int best);
+void DumpDecisionTrace(SCStudyInterfaceRef sc, const DecisionTraceRing& ring, int bars, const char* reason);
+
+// Feed Watchdog Functions
+void NoteFeedArrival(SCStudyInterfaceRef sc, FeedWatchdog& watchdog);
+bool CheckFeedStale(SCStudyInterfaceRef sc, FeedWatchdog& watchdog, const StrategyParameters& params);
+
+// Bar Batch Functions
+// An incremental update carrying at least this many bars (feed gap, reconnect, backlog) is a
+// catch-up batch: its older bars only advance state and only the newest bar is traded.
+const int kCatchUpMinBars = 3;
+bool IsCatchUpBatch(SCStudyInterfaceRef sc, int firstIndex);
+void AdvanceBarBatch(SCStudyInterfaceRef sc, int firstIndex, int lastIndex, RiskMetrics& metrics,
+                     std::map<std::string, int>& strategyCounts);
+void DecideCatchUpBar(SCStudyInterfaceRef sc, int index, uint32_t strategyMask, const StrategyParameters& params,
+                      SignalColumns& signals, DecisionTraceRing& ring, FootprintExportState& exportState);
+// Lazy history evaluates signals for at most this many older bars per call when scrolled back
+const int kBackfillBarsPerCall = 1000;
+int GetLazySignalStart(SCStudyInterfaceRef sc);
+void BackfillVisibleSignals(SCStudyInterfaceRef sc);
+void PlotEntryMarker(SCStudyInterfaceRef sc, int index, int direction);
+
+// Strategy Worker Bridge Functions
+void ApplyProfileLevels(SCStudyInterfaceRef sc, const std::vector<VolumeProfileLevel>& levels, int barIndex);
+bool ConnectStrategyBridge(SCStudyInterfaceRef sc, StrategyBridgeState& bridge);
+void DrainStrategyBridge(SCStudyInterfaceRef sc, StrategyBridgeState& bridge);
+bool RequestProfileFromWorker(SCStudyInterfaceRef sc, StrategyBridgeState& bridge);
+
+// Depth Feature Functions
+void UpdateDepthFeatures(SCStudyInterfaceRef sc, DepthFeatures& depth, int levelCount);
+bool HasBookPressure(const DepthFeatures& depth, int direction, float minImbalance);
+
+// Time & Sales Functions
+void PumpTimeAndSales(SCStudyInterfaceRef sc, TradeTapeState& tape, const StrategyParameters& params);
+void RecordTradeClip(TradeTapeState& tape, int tradeType, int priceTicks, int size, int64_t timeMillis,
+                     const StrategyParameters& params);
+int GetClipClusterRepeats(SCStudyInterfaceRef sc, int tradeType, int priceTicks, int toleranceTicks, int index);
+void AddClassifiedVolume(FlowToxicity& toxicity, double buyVolume, double sellVolume, const StrategyParameters& params);
+void FeedToxicityFromBars(SCStudyInterfaceRef sc, FlowToxicity& toxicity, const StrategyParameters& params);
+bool IsFlowToxic(const FlowToxicity& toxicity, const StrategyParameters& params);
+
+// Canonical Bar Functions
+void ResetCanonicalBars(CanonicalBarSeries& series);
+bool SyncCanonicalBars(CanonicalBarSeries& series, const StrategyParameters& params);
+void AddCanonicalTrade(CanonicalBarSeries& series, int priceTicks, float bidVolume, float askVolume, int chartBar);
+void FeedCanonicalFromBars(SCStudyInterfaceRef sc, CanonicalBarSeries& series, int lastBar);
+const CanonicalBarSeries* GetCanonicalBars(SCStudyInterfaceRef sc, int index);
+int CountStrategyBars(SCStudyInterfaceRef sc, int index);
+bool GetStrategyBar(SCStudyInterfaceRef sc, int index, int back, CanonicalBar& bar);
+
+// Footprint Functions
+void BuildFootprintBar(SCStudyInterfaceRef sc, int index, FootprintBar& bar);
+void ExportClosedFootprints(SCStudyInterfaceRef sc, FootprintExportState& state);
+void NoteFootprintEvents(FootprintExportState& state, int index, uint32_t events);
+uint32_t StrategyEventBit(const std::string& strategy);
+
+// Footprint Feature Functions
+void ResetFootprintFeatures(FootprintFeatureSeries& series);
+FootprintFeatures ComputeFootprintFeatures(const FootprintBar& bar);
+const FootprintFeatures* GetFootprintFeatures(SCStudyInterfaceRef sc, int index);
+float ApplyFootprintFeatures(SCStudyInterfaceRef sc, int index, bool atHigh, bool reversal, float confidence);
+
+// Strategy Breaker Functions
+int StrategyIndexOf(const std::string& strategy);
+uint32_t EnabledStrategyMask(SCStudyInterfaceRef sc);
+void RecordStrategyOrder(SCStudyInterfaceRef sc, StrategyBreakers& breakers, const TradeSignal& signal,
+                         const s_SCNewOrder& order, int orderResult, const StrategyParameters& params);
+void UpdateStrategyBreakers(SCStudyInterfaceRef sc, StrategyBreakers& breakers, const StrategyParameters& params);
+void TripStrategyBreaker(SCStudyInterfaceRef sc, StrategyBreakers& breakers, int strategy, BreakerReason reason,
+                         float value);
+
+// Integer Tick Price Functions
+void UpdateTickPriceSeries(SCStudyInterfaceRef sc, TickPriceSeries& series, int startIndex);
+const TickPriceSeries& GetTickPriceSeries(SCStudyInterfaceRef sc);
+int GetIndexOfHighestTick(const std::vector<int32_t>& values, int startIndex, int endIndex);
+int GetIndexOfLowestTick(const std::vector<int32_t>& values, int startIndex, int endIndex);
+
+// Level Touch Functions
+void ResetLevelTouches(LevelTouchIndex& touches);
+void RecordBarTouches(LevelTouchIndex& touches, const TickPriceSeries& ticks, float volume, int bar);
+const LevelTouchIndex* GetLevelTouches(SCStudyInterfaceRef sc, int index);
+TouchSummary SummarizeTouches(const LevelTouchIndex& touches, int levelTicks, int index, int memoryBars);
+float ApplyTouchHistory(SCStudyInterfaceRef sc, int index, int levelTicks, bool holdSignal, float confidence);
+
+// Reference Level Functions
+void ResetReferenceLevels(ReferenceLevels& levels);
+void RecordReferenceBar(SCStudyInterfaceRef sc, ReferenceLevels& levels, const TickPriceSeries& ticks, int bar);
+const ReferenceLevels* GetReferenceLevels(SCStudyInterfaceRef sc, int index);
+bool FindNearestReferenceLevel(const ReferenceLevels& levels, int priceTicks, int withinTicks, int& levelTicks);
+float ApplyReferenceLevel(SCStudyInterfaceRef sc, int index, int levelTicks, float confidence);
 
 // ==================================================================================
 // MAIN STUDY FUNCTION
@@ -90,6 +773,7 @@ std::vector<float> FindSwingPoints(SCStudyInterfaceRef sc, int lookback, bool fi
 
 SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
 {
+    AOFB_PROBE(PROBE_STUDY_CALL);
     // ===============================================================================
     // STUDY CONFIGURATION & INITIALIZATION
     // ===============================================================================
@@ -102,6 +786,7 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         sc.GraphRegion = 0;
         sc.IsAutoTradingEnabled = 1;
         sc.MaintainVolumeAtPriceData = 1;
+        sc.UsesMarketDepthData = 1;
         sc.CalculationPrecedence = LOW_PREC_LEVEL;
 
         // ===============================================================================
@@ -170,6 +855,16 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         sc.Subgraph[9].DrawZeros = false;
         sc.Subgraph[9].LineWidth = 3;
 
+        sc.Subgraph[10].Name = "Engine Update Time (us)";
+        sc.Subgraph[10].DrawStyle = DRAWSTYLE_IGNORE;
+        sc.Subgraph[10].PrimaryColor = RGB(200, 200, 200);
+        sc.Subgraph[10].DrawZeros = false;
+
+        sc.Subgraph[11].Name = "Engine Bars Per Update";
+        sc.Subgraph[11].DrawStyle = DRAWSTYLE_IGNORE;
+        sc.Subgraph[11].PrimaryColor = RGB(200, 200, 200);
+        sc.Subgraph[11].DrawZeros = false;
+
         // ===============================================================================
         // MASTER SYSTEM CONTROLS
         // ===============================================================================
@@ -231,6 +926,26 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         sc.Input[15].SetFloatLimits(1.0f, 20.0f);
         sc.Input[15].SetDescription("Maximum allowed drawdown before shutdown");
 
+        sc.Input[16].Name = "Breaker: Consecutive Losses Per Strategy";
+        sc.Input[16].SetInt(0);
+        sc.Input[16].SetIntLimits(0, 50);
+        sc.Input[16].SetDescription("Losing trades in a row that switch a strategy off for the day (0 = off)");
+
+        sc.Input[17].Name = "Breaker: Drawdown Per Strategy ($)";
+        sc.Input[17].SetFloat(0.0f);
+        sc.Input[17].SetFloatLimits(0.0f, 10000.0f);
+        sc.Input[17].SetDescription("Drop from a strategy's best realized P&L of the day that switches it off (0 = off)");
+
+        sc.Input[18].Name = "Breaker: Order Error Rate (%)";
+        sc.Input[18].SetFloat(0.0f);
+        sc.Input[18].SetFloatLimits(0.0f, 100.0f);
+        sc.Input[18].SetDescription("Share of a strategy's entry orders rejected, judged from its 4th attempt (0 = off)");
+
+        sc.Input[19].Name = "Breaker: Max Entry Slippage (Ticks)";
+        sc.Input[19].SetInt(0);
+        sc.Input[19].SetIntLimits(0, 100);
+        sc.Input[19].SetDescription("Adverse fill distance from the signal entry that switches a strategy off (0 = off)");
+
         // ===============================================================================
         // TIME-BASED CONTROLS
         // ===============================================================================
@@ -307,6 +1022,45 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         sc.Input[40].SetYesNo(true);
         sc.Input[40].SetDescription("Detect and fade liquidity traps");
 
+        sc.Input[41].Name = "=== ORDER BOOK FILTER ===";
+        sc.Input[41].SetDescription("Entry timing from displayed market depth");
+
+        sc.Input[42].Name = "Require Book Pressure For Entries";
+        sc.Input[42].SetYesNo(false);
+        sc.Input[42].SetDescription("Live entries wait until the book imbalance and microprice lean their way");
+
+        sc.Input[43].Name = "Book Depth Levels";
+        sc.Input[43].SetInt(5);
+        sc.Input[43].SetIntLimits(1, kMaxDepthLevels);
+        sc.Input[43].SetDescription("Levels per side included in the imbalance and depth-weighted mid");
+
+        sc.Input[44].Name = "Min Book Imbalance";
+        sc.Input[44].SetFloat(0.2f);
+        sc.Input[44].SetFloatLimits(0.0f, 1.0f);
+        sc.Input[44].SetDescription("Bid/ask size imbalance required in the trade direction (0 = just not against)");
+
+        sc.Input[45].Name = "=== FLOW TOXICITY ===";
+        sc.Input[45].SetDescription("VPIN-style gate for the fade strategies");
+
+        sc.Input[46].Name = "Suppress Fades In Toxic Flow";
+        sc.Input[46].SetYesNo(false);
+        sc.Input[46].SetDescription("Skip absorption, HVN rejection and trap entries while VPIN is above the limit");
+
+        sc.Input[47].Name = "VPIN Bucket Volume";
+        sc.Input[47].SetInt(1000);
+        sc.Input[47].SetIntLimits(10, 1000000);
+        sc.Input[47].SetDescription("Contracts per equal-volume bucket");
+
+        sc.Input[48].Name = "VPIN Window (Buckets)";
+        sc.Input[48].SetInt(50);
+        sc.Input[48].SetIntLimits(5, kMaxVpinBuckets);
+        sc.Input[48].SetDescription("Buckets averaged into the metric");
+
+        sc.Input[49].Name = "Max VPIN For Fades";
+        sc.Input[49].SetFloat(0.6f);
+        sc.Input[49].SetFloatLimits(0.05f, 1.0f);
+        sc.Input[49].SetDescription("Fades are suspended while VPIN is above this");
+
         // ===============================================================================
         // STRATEGY PARAMETERS - LIQUIDITY ABSORPTION
         // ===============================================================================
@@ -329,6 +1083,16 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         sc.Input[53].SetIntLimits(1, 5);
         sc.Input[53].SetDescription("Bars needed to confirm absorption");
 
+        sc.Input[54].Name = "Footprint Feature Weight";
+        sc.Input[54].SetFloat(0.0f);
+        sc.Input[54].SetFloatLimits(0.0f, 0.2f);
+        sc.Input[54].SetDescription("Confidence per footprint feature (unfinished auction, exhaustion, extreme delta) behind an absorption or stop-run signal (0 = off)");
+
+        sc.Input[55].Name = "Exhaustion Volume Ratio";
+        sc.Input[55].SetFloat(0.25f);
+        sc.Input[55].SetFloatLimits(0.01f, 1.0f);
+        sc.Input[55].SetDescription("An extreme is exhausted when its volume is at most this fraction of the bar's average level volume");
+
         // ===============================================================================
         // STRATEGY PARAMETERS - ICEBERG DETECTION
         // ===============================================================================
@@ -351,6 +1115,21 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         sc.Input[63].SetIntLimits(0, 3);
         sc.Input[63].SetDescription("Price tolerance for iceberg level");
 
+        sc.Input[64].Name = "Iceberg Clip Window (Seconds)";
+        sc.Input[64].SetInt(30);
+        sc.Input[64].SetIntLimits(1, 600);
+        sc.Input[64].SetDescription("Longest gap between identical trade sizes that still counts as one cluster");
+
+        sc.Input[65].Name = "Iceberg Min Clip Repeats";
+        sc.Input[65].SetInt(4);
+        sc.Input[65].SetIntLimits(2, 50);
+        sc.Input[65].SetDescription("Identical trades at one price needed to flag a clip cluster");
+
+        sc.Input[66].Name = "Iceberg Clip Confidence Boost";
+        sc.Input[66].SetFloat(0.1f);
+        sc.Input[66].SetFloatLimits(0.0f, 0.4f);
+        sc.Input[66].SetDescription("Added to live iceberg signals confirmed by a clip cluster at the level");
+
         // ===============================================================================
         // STRATEGY PARAMETERS - DELTA ANALYSIS
         // ===============================================================================
@@ -400,6 +1179,16 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         sc.Input[84].SetIntLimits(1, 10);
         sc.Input[84].SetDescription("Price proximity to HVN/LVN for signal");
 
+        sc.Input[85].Name = "Level Touch History Weight";
+        sc.Input[85].SetFloat(0.0f);
+        sc.Input[85].SetFloatLimits(0.0f, 0.2f);
+        sc.Input[85].SetDescription("Confidence per prior hold or break at an HVN/LVN level, and for a fresh level (0 = off)");
+
+        sc.Input[86].Name = "Level Touch Memory (Bars)";
+        sc.Input[86].SetInt(390);
+        sc.Input[86].SetIntLimits(10, 10000);
+        sc.Input[86].SetDescription("Touches older than this many bars no longer count");
+
         // ===============================================================================
         // STRATEGY PARAMETERS - BREAKOUT & MOMENTUM
         // ===============================================================================
@@ -422,12 +1211,156 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         sc.Input[93].SetIntLimits(2, 10);
         sc.Input[93].SetDescription("Bars needed for momentum confirmation");
 
+        sc.Input[94].Name = "Reference Level Weight";
+        sc.Input[94].SetFloat(0.0f);
+        sc.Input[94].SetFloatLimits(0.0f, 0.2f);
+        sc.Input[94].SetDescription("Confidence added to stop-run and trap signals at a prior-session level or round number (0 = off)");
+
+        sc.Input[95].Name = "Reference Level Proximity (Ticks)";
+        sc.Input[95].SetInt(2);
+        sc.Input[95].SetIntLimits(0, 20);
+        sc.Input[95].SetDescription("How close the signal's level must be to a reference level");
+
+        sc.Input[96].Name = "Round Number Step (Ticks)";
+        sc.Input[96].SetInt(40);
+        sc.Input[96].SetIntLimits(0, 10000);
+        sc.Input[96].SetDescription("Spacing of round-number levels, e.g. 40 for ES 10-point levels (0 = none)");
+
+        // ===============================================================================
+        // PARAMETER PROFILES
+        // ===============================================================================
+        
+        sc.Input[100].Name = "=== PARAMETER PROFILES ===";
+        sc.Input[100].SetDescription("Per-instrument and per-regime parameter overrides");
+
+        sc.Input[101].Name = "Parameter Profile File";
+        sc.Input[101].SetPathAndFileName("");
+        sc.Input[101].SetDescription("INI file with [*], [ROOT] and [ROOT:regime] sections overriding the inputs above");
+
+        sc.Input[102].Name = "Parameter Regime";
+        sc.Input[102].SetCustomInputStrings("Default;Trend;Range;Volatile");
+        sc.Input[102].SetCustomInputIndex(0);
+        sc.Input[102].SetDescription("Regime section applied on top of the instrument section");
+
+        sc.Input[103].Name = "Enable Profile Hot Reload";
+        sc.Input[103].SetYesNo(true);
+        sc.Input[103].SetDescription("Re-read the profile file when it changes, without recalculating the chart");
+
+        // ===============================================================================
+        // CANONICAL BARS
+        // ===============================================================================
+
+        sc.Input[104].Name = "=== CANONICAL BARS ===";
+        sc.Input[104].SetDescription("Bars the study builds from trades, independent of the chart's bar type");
+
+        sc.Input[105].Name = "Strategy Bar Type";
+        sc.Input[105].SetCustomInputStrings("Chart Bars;Volume Bars;Range Bars");
+        sc.Input[105].SetCustomInputIndex(0);
+        sc.Input[105].SetDescription("Bars the absorption and volume imbalance thresholds are measured on");
+
+        sc.Input[106].Name = "Canonical Volume Bar Size";
+        sc.Input[106].SetInt(500);
+        sc.Input[106].SetIntLimits(1, 1000000);
+        sc.Input[106].SetDescription("Contracts per volume bar");
+
+        sc.Input[107].Name = "Canonical Range Bar Size (Ticks)";
+        sc.Input[107].SetInt(8);
+        sc.Input[107].SetIntLimits(1, 10000);
+        sc.Input[107].SetDescription("High-to-low ticks per range bar");
+
+        // ===============================================================================
+        // ENGINE HEALTH
+        // ===============================================================================
+        
+        sc.Input[110].Name = "=== ENGINE HEALTH ===";
+        sc.Input[110].SetDescription("Runtime load readout for the study itself");
+
+        sc.Input[111].Name = "Show Engine Health Overlay";
+        sc.Input[111].SetYesNo(true);
+        sc.Input[111].SetDescription("Draw update time, bars per update, log lines, order tokens and feed lag on the chart");
+
+        sc.Input[112].Name = "Engine Slow Update Threshold (ms)";
+        sc.Input[112].SetInt(50);
+        sc.Input[112].SetIntLimits(1, 1000);
+        sc.Input[112].SetDescription("Update time above which the overlay is drawn in the warning color");
+
+        sc.Input[113].Name = "Lazy Historical Signals";
+        sc.Input[113].SetYesNo(false);
+        sc.Input[113].SetDescription("On a full recalculation evaluate signals only near the visible range; scrolling back fills in older bars");
+
+        sc.Input[114].Name = "Lazy Signal Margin (Bars)";
+        sc.Input[114].SetInt(200);
+        sc.Input[114].SetIntLimits(0, 100000);
+        sc.Input[114].SetDescription("Bars left of the first visible bar that also get signals");
+
+        sc.Input[115].Name = "Enable Feed Watchdog";
+        sc.Input[115].SetYesNo(false);
+        sc.Input[115].SetDescription("Pause entries while market data is silent or late; the study is then called on a timer");
+
+        sc.Input[116].Name = "Feed Silence Limit (s)";
+        sc.Input[116].SetFloat(30.0f);
+        sc.Input[116].SetFloatLimits(0.0f, 3600.0f);
+        sc.Input[116].SetDescription("Seconds without new data after which the feed is stale (0 = no check)");
+
+        sc.Input[117].Name = "Feed Lag Limit (s)";
+        sc.Input[117].SetFloat(5.0f);
+        sc.Input[117].SetFloatLimits(0.0f, 3600.0f);
+        sc.Input[117].SetDescription("Delay of arriving data behind local time after which the feed is stale (0 = no check)");
+
+        sc.Input[118].Name = "Dump Decision Trace";
+        sc.Input[118].SetYesNo(false);
+        sc.Input[118].SetDescription("Write the last bars' gate and signal decisions to the log once; switches itself back off");
+
+        sc.Input[119].Name = "Dump Decision Trace On Anomaly";
+        sc.Input[119].SetYesNo(true);
+        sc.Input[119].SetDescription("Write the last bars' decisions after a rejected order, loss limit, circuit breaker or stale feed");
+
+        // ===============================================================================
+        // STRATEGY WORKER BRIDGE
+        // ===============================================================================
+
+        sc.Input[120].Name = "=== STRATEGY WORKER BRIDGE ===";
+        sc.Input[120].SetDescription("Offload heavy analytics to the StrategyWorker process");
+
+        sc.Input[121].Name = "Use Strategy Worker";
+        sc.Input[121].SetYesNo(false);
+        sc.Input[121].SetDescription("Publish live bars to the worker and apply the profile nodes it returns");
+
+        sc.Input[122].Name = "Strategy Worker Bridge Name";
+        sc.Input[122].SetString("AOFB_Bridge");
+        sc.Input[122].SetDescription("Shared-memory name; must match the name passed to StrategyWorker. One chart per name");
+
+        sc.Input[123].Name = "=== FOOTPRINT EXPORT ===";
+        sc.Input[123].SetDescription("Closed-bar footprints for external analytics");
+
+        sc.Input[124].Name = "Export Footprint Bars";
+        sc.Input[124].SetYesNo(false);
+        sc.Input[124].SetDescription("Append each closed bar's footprint, delta, POC and strategy events to <symbol>.afp");
+
+        sc.Input[125].Name = "Footprint Export Folder";
+        sc.Input[125].SetString("");
+        sc.Input[125].SetDescription("Folder for the export file; empty = the Sierra Chart data folder");
+
         // Initialize persistent data structures
-        sc.SetPersistentPointer(1, new std::vector<float>());      // HVN Levels
-        sc.SetPersistentPointer(2, new std::vector<float>());      // LVN Levels
+        sc.SetPersistentPointer(1, new std::vector<int>());        // HVN Levels (ticks)
+        sc.SetPersistentPointer(2, new std::vector<int>());        // LVN Levels (ticks)
         sc.SetPersistentPointer(3, new RiskMetrics());             // Risk tracking
         sc.SetPersistentPointer(4, new std::map<std::string, int>()); // Strategy counters
         sc.SetPersistentPointer(5, new OrderFlowData());           // Order flow data
+        sc.SetPersistentPointer(6, new ParameterProfileStore());   // Active strategy parameters
+        sc.SetPersistentPointer(7, new InstrumentMetadata());      // Instrument contract specification
+        sc.SetPersistentPointer(8, new TickPriceSeries());         // Bar prices in integer ticks
+        sc.SetPersistentPointer(9, new EngineHealth());            // Study runtime health
+        sc.SetPersistentPointer(10, new StrategyBridgeState());    // Strategy worker bridge
+        sc.SetPersistentPointer(11, new DepthFeatures());          // Order book features
+        sc.SetPersistentPointer(12, new TradeTapeState());         // Time & Sales consumers
+        sc.SetPersistentPointer(13, new FootprintExportState());   // Footprint export writer
+        sc.SetPersistentPointer(14, new StrategyBreakers());       // Per-strategy circuit breakers
+        sc.SetPersistentPointer(15, new FeedWatchdog());           // Feed heartbeat
+        sc.SetPersistentPointer(16, new DecisionTraceRing());      // Recent bar decisions
+        sc.SetPersistentPointer(17, new LevelTouchIndex());        // Touches per tick level
+        sc.SetPersistentPointer(18, new ReferenceLevels());        // Prior-session and round-number levels
+        sc.SetPersistentPointer(19, new FootprintFeatureSeries()); // Footprint features per bar
 
         // Initialize persistent variables
         sc.SetPersistentFloat(1, 0.0f);  // Daily P&L
@@ -447,11 +1380,25 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
     
     if (sc.LastCallToFunction)
     {
-        delete (std::vector<float>*)sc.GetPersistentPointer(1);
-        delete (std::vector<float>*)sc.GetPersistentPointer(2);
+        delete (std::vector<int>*)sc.GetPersistentPointer(1);
+        delete (std::vector<int>*)sc.GetPersistentPointer(2);
         delete (RiskMetrics*)sc.GetPersistentPointer(3);
         delete (std::map<std::string, int>*)sc.GetPersistentPointer(4);
         delete (OrderFlowData*)sc.GetPersistentPointer(5);
+        delete (ParameterProfileStore*)sc.GetPersistentPointer(6);
+        delete (InstrumentMetadata*)sc.GetPersistentPointer(7);
+        delete (TickPriceSeries*)sc.GetPersistentPointer(8);
+        delete (EngineHealth*)sc.GetPersistentPointer(9);
+        delete (StrategyBridgeState*)sc.GetPersistentPointer(10);
+        delete (DepthFeatures*)sc.GetPersistentPointer(11);
+        delete (TradeTapeState*)sc.GetPersistentPointer(12);
+        delete (FootprintExportState*)sc.GetPersistentPointer(13);
+        delete (StrategyBreakers*)sc.GetPersistentPointer(14);
+        delete (FeedWatchdog*)sc.GetPersistentPointer(15);
+        delete (DecisionTraceRing*)sc.GetPersistentPointer(16);
+        delete (LevelTouchIndex*)sc.GetPersistentPointer(17);
+        delete (ReferenceLevels*)sc.GetPersistentPointer(18);
+        delete (FootprintFeatureSeries*)sc.GetPersistentPointer(19);
         return;
     }
 
@@ -460,48 +1407,153 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
     // ===============================================================================
 
     // Get persistent data
-    std::vector<float>* hvnLevels = (std::vector<float>*)sc.GetPersistentPointer(1);
-    std::vector<float>* lvnLevels = (std::vector<float>*)sc.GetPersistentPointer(2);
+    std::vector<int>* hvnLevels = (std::vector<int>*)sc.GetPersistentPointer(1);
+    std::vector<int>* lvnLevels = (std::vector<int>*)sc.GetPersistentPointer(2);
     RiskMetrics* riskMetrics = (RiskMetrics*)sc.GetPersistentPointer(3);
     std::map<std::string, int>* strategyCounts = (std::map<std::string, int>*)sc.GetPersistentPointer(4);
     OrderFlowData* orderFlowData = (OrderFlowData*)sc.GetPersistentPointer(5);
+    ParameterProfileStore* profileStore = (ParameterProfileStore*)sc.GetPersistentPointer(6);
+    InstrumentMetadata* instrument = (InstrumentMetadata*)sc.GetPersistentPointer(7);
+    TickPriceSeries* tickPrices = (TickPriceSeries*)sc.GetPersistentPointer(8);
+    EngineHealth* engineHealth = (EngineHealth*)sc.GetPersistentPointer(9);
+    StrategyBridgeState* bridge = (StrategyBridgeState*)sc.GetPersistentPointer(10);
+    DepthFeatures* depthFeatures = (DepthFeatures*)sc.GetPersistentPointer(11);
+    TradeTapeState* tradeTape = (TradeTapeState*)sc.GetPersistentPointer(12);
+    FootprintExportState* footprintExport = (FootprintExportState*)sc.GetPersistentPointer(13);
+    StrategyBreakers* breakers = (StrategyBreakers*)sc.GetPersistentPointer(14);
+    FeedWatchdog* feedWatchdog = (FeedWatchdog*)sc.GetPersistentPointer(15);
+    DecisionTraceRing* decisionTrace = (DecisionTraceRing*)sc.GetPersistentPointer(16);
+    LevelTouchIndex* levelTouches = (LevelTouchIndex*)sc.GetPersistentPointer(17);
+    ReferenceLevels* referenceLevels = (ReferenceLevels*)sc.GetPersistentPointer(18);
+    FootprintFeatureSeries* footprintFeatures = (FootprintFeatureSeries*)sc.GetPersistentPointer(19);
+
+    if (!hvnLevels || !lvnLevels || !riskMetrics || !strategyCounts || !orderFlowData || !profileStore ||
+        !instrument || !tickPrices || !engineHealth || !bridge || !depthFeatures || !tradeTape ||
+        !footprintExport || !breakers || !feedWatchdog || !decisionTrace || !levelTouches ||
+        !referenceLevels || !footprintFeatures) return;
+
+    BeginEngineUpdate(sc, *engineHealth);
 
-    if (!hvnLevels || !lvnLevels || !riskMetrics || !strategyCounts || !orderFlowData) return;
+    if (sc.IsFullRecalculation || instrument->tickSize <= 0.0f)
+        ResolveInstrumentMetadata(sc, *instrument);
+
+    // Resolve parameters once per call; a changed profile file is picked up here without a recalculation
+    RefreshParameterProfile(sc, sc.IsFullRecalculation != 0);
+    const StrategyParameters& params = GetStrategyParameters(sc);
 
     int loopStart = sc.UpdateStartIndex;
     if (loopStart < 0) loopStart = 0;
-    for (int i = loopStart; i < sc.ArraySize; ++i)
+
+    // Convert this update's bars to integer ticks once; everything downstream compares ticks
+    UpdateTickPriceSeries(sc, *tickPrices, loopStart);
+    if (sc.IsFullRecalculation)
     {
-        // Daily reset logic
-        if (sc.IsNewTradingDay(i))
+        ResetLevelTouches(*levelTouches);
+        ResetReferenceLevels(*referenceLevels);
+        ResetFootprintFeatures(*footprintFeatures);
+        ResetCanonicalBars(tradeTape->canonicalBars);
+        decisionTrace->written = 0;     // Its bar indexes belong to the old arrays
+        bridge->publishedFrom = -1;     // The worker's copy too: the next request re-seeds it
+        bridge->publishedThrough = -1;
+    }
+
+    // Heartbeat: note fresh data, then judge the feed; a stale feed pauses live entries
+    bool watchFeed = sc.Input[115].GetYesNo() != 0;
+    NoteFeedArrival(sc, *feedWatchdog);
+    long long staleEventsBefore = feedWatchdog->staleEvents;
+    bool feedStale = watchFeed && CheckFeedStale(sc, *feedWatchdog, params);
+    engineHealth->feedStale = feedStale;
+
+    // The book is a snapshot of now, so it is read once per call and gates this call's entries
+    UpdateDepthFeatures(sc, *depthFeatures, params.bookDepthLevels);
+    bool requireBookPressure = sc.Input[42].GetYesNo() != 0;
+
+    // Trades printed since the last call, each handed to the tape consumers once
+    PumpTimeAndSales(sc, *tradeTape, params);
+    FeedToxicityFromBars(sc, tradeTape->toxicity, params);
+    bool suppressToxicFades = sc.Input[46].GetYesNo() != 0;
+    bool flowToxic = suppressToxicFades && IsFlowToxic(tradeTape->toxicity, params);
+    if (suppressToxicFades && flowToxic != tradeTape->toxicity.toxic)
+    {
+        tradeTape->toxicity.toxic = flowToxic;
+        if (sc.Input[4].GetYesNo())
         {
-            riskMetrics->dailyPnL = 0.0f;
-            riskMetrics->tradesTotal = 0;
-            riskMetrics->tradesWin = 0;
-            riskMetrics->tradesLoss = 0;
-            sc.SetPersistentInt(1, 0); // Reset daily trade count
-            sc.SetPersistentInt(2, 1); // Enable trading for new day
-            sc.SetPersistentFloat(4, 0.0f); // Reset cumulative delta
-            strategyCounts->clear();
-            if (sc.Input[4].GetYesNo())
-            {
-                SCString logMsg;
-                logMsg.Format("=== NEW TRADING DAY === Risk limits reset. Max Loss: $%.2f, Target: $%.2f", 
-                             sc.Input[11].GetFloat(), sc.Input[12].GetFloat());
-                sc.AddMessageToLog(logMsg, 0);
-            }
+            SCString logMsg;
+            logMsg.Format("FLOW TOXICITY: VPIN %.2f %s %.2f, fades %s", tradeTape->toxicity.vpin,
+                          flowToxic ? "above" : "back under", params.maxFadeVpin, flowToxic ? "suspended" : "resumed");
+            LogMessage(sc, logMsg, 0);
+        }
+    }
+
+    // Fills and exits since the last call feed the breakers; tripped strategies are masked out
+    uint32_t trippedBefore = breakers->trippedMask;
+    UpdateStrategyBreakers(sc, *breakers, params);
+    uint32_t strategyMask = EnabledStrategyMask(sc) & ~breakers->trippedMask;
+
+    // Apply whatever the worker finished since the last call
+    bool useWorker = ConnectStrategyBridge(sc, *bridge);
+    if (useWorker) DrainStrategyBridge(sc, *bridge);
+
+    // A catch-up batch advances its older bars one by one and decides each without trading it;
+    // the profile, risk snapshot and order entry below then run once, for the newest bar
+    SignalColumns signals;
+    int decisionStart = loopStart;
+    if (IsCatchUpBatch(sc, loopStart))
+    {
+        for (int i = loopStart; i < sc.ArraySize - 1; ++i)
+        {
+            AdvanceBarBatch(sc, i, i, *riskMetrics, *strategyCounts);
+            DecideCatchUpBar(sc, i, strategyMask, params, signals, *decisionTrace, *footprintExport);
         }
+        decisionStart = sc.ArraySize - 1;
+    }
+
+    // Lazy history: a full recalculation evaluates signals only from just left of the visible
+    // range, older bars only advance state. Persistent int 4 is the oldest evaluated bar.
+    bool lazySignals = sc.Input[113].GetYesNo() != 0;
+    if (sc.IsFullRecalculation)
+    {
+        int signalStart = lazySignals ? GetLazySignalStart(sc) : loopStart;
+        if (signalStart > loopStart)
+        {
+            AdvanceBarBatch(sc, loopStart, signalStart - 1, *riskMetrics, *strategyCounts);
+            decisionStart = signalStart;
+        }
+        sc.SetPersistentInt(4, decisionStart);
+    }
+    else if (lazySignals)
+    {
+        BackfillVisibleSignals(sc);
+    }
+    // Keep getting called while visible history is still unevaluated, so scrolling fills it in
+    // without ticks, and while the watchdog runs, so a silent feed is noticed without ticks
+    bool backfillPending = lazySignals && GetLazySignalStart(sc) < sc.GetPersistentInt(4);
+    sc.UpdateAlways = backfillPending || watchFeed;
+
+    const char* anomaly = nullptr;      // Live-bar event that dumps the decision trace
+    for (int i = decisionStart; i < sc.ArraySize; ++i)
+    {
+        bool isLiveBar = i == sc.ArraySize - 1;
+        DecisionTrace& trace = BeginDecisionTrace(*decisionTrace, i);
+
+        // Daily reset logic
+        if (sc.IsNewTradingDay(i))
+            ResetTradingDay(sc, *riskMetrics, *strategyCounts, params);
 
         // Update risk metrics
         UpdateRiskMetrics(sc, *riskMetrics);
+        trace.dailyPnL = riskMetrics->dailyPnL;
 
         // Check if trading is disabled for the day
+        trace.outcome = DECISION_TRADING_OFF;
         int tradingEnabled = sc.GetPersistentInt(2);
         if (!tradingEnabled) continue;
 
         // Risk limit checks
-        if (riskMetrics->dailyPnL <= -sc.Input[11].GetFloat() || riskMetrics->dailyPnL >= sc.Input[12].GetFloat())
+        if (riskMetrics->dailyPnL <= -params.maxDailyLoss || riskMetrics->dailyPnL >= params.dailyProfitTarget)
         {
+            trace.outcome = DECISION_RISK_LIMIT;
+            if (isLiveBar) anomaly = "daily risk limit";
             sc.SetPersistentInt(2, 0); // Disable trading
             s_SCPositionData positionData;
             sc.GetTradePosition(positionData);
@@ -510,16 +1562,17 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
             if (sc.Input[4].GetYesNo())
             {
                 SCString logMsg;
-                if (riskMetrics->dailyPnL <= -sc.Input[11].GetFloat())
+                if (riskMetrics->dailyPnL <= -params.maxDailyLoss)
                     logMsg.Format("DAILY LOSS LIMIT HIT: $%.2f. Trading disabled for remainder of session.", riskMetrics->dailyPnL);
                 else
                     logMsg.Format("DAILY PROFIT TARGET HIT: $%.2f. Trading disabled for remainder of session.", riskMetrics->dailyPnL);
-                sc.AddMessageToLog(logMsg, 0);
+                LogMessage(sc, logMsg, 0);
             }
             continue;
         }
 
         // Time-based trading controls
+        trace.outcome = DECISION_OUTSIDE_HOURS;
         if (!IsWithinTradingHours(sc)) continue;
 
         // Force flatten positions at end of day
@@ -527,13 +1580,14 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         SCDateTime flattenTime = sc.Input[23].GetTime();
         if (currentTime.GetTime() >= flattenTime.GetTime())
         {
+            trace.outcome = DECISION_FLATTEN_TIME;
             s_SCPositionData positionData;
             sc.GetTradePosition(positionData);
             if (positionData.PositionQuantity != 0)
             {
                 sc.FlattenPosition();
                 if (sc.Input[4].GetYesNo())
-                    sc.AddMessageToLog("FORCE FLATTEN: End of trading session", 0);
+                    LogMessage(sc, "FORCE FLATTEN: End of trading session", 0);
             }
             continue;
         }
@@ -545,11 +1599,13 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
 
         // Check daily trade limit
         int dailyTrades = sc.GetPersistentInt(1);
-        if (dailyTrades >= sc.Input[3].GetInt())
+        trace.dailyTrades = dailyTrades;
+        if (dailyTrades >= params.maxDailyTrades)
         {
-            if (sc.Input[4].GetYesNo() && dailyTrades == sc.Input[3].GetInt())
+            trace.outcome = DECISION_TRADE_LIMIT;
+            if (sc.Input[4].GetYesNo() && dailyTrades == params.maxDailyTrades)
             {
-                sc.AddMessageToLog("DAILY TRADE LIMIT REACHED. No new positions until tomorrow.", 0);
+                LogMessage(sc, "DAILY TRADE LIMIT REACHED. No new positions until tomorrow.", 0);
             }
             continue;
         }
@@ -558,103 +1614,76 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         if (sc.IsNewBar(i))
         {
             UpdateOrderFlowData(sc);
-            ProcessVolumeProfile(sc);
+
+            // Live bars go to the worker; history and a missing or saturated worker stay local
+            bool offloaded = useWorker && !sc.IsFullRecalculation && i == sc.ArraySize - 1 &&
+                             RequestProfileFromWorker(sc, *bridge);
+            if (!offloaded)
+                ProcessVolumeProfile(sc);
         }
 
         // Skip if already in position (unless we want to add to positions)
+        trace.outcome = DECISION_IN_POSITION;
         if (hasPosition) continue;
 
         // ===============================================================================
         // STRATEGY SIGNAL GENERATION
         // ===============================================================================
-        std::vector<TradeSignal> signals;
-        bool runAllStrategies = sc.Input[5].GetYesNo();
-        if (runAllStrategies || sc.Input[31].GetYesNo())
-        {
-            TradeSignal signal = CheckLiquidityAbsorption(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[32].GetYesNo())
-        {
-            TradeSignal signal = CheckIcebergDetection(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[33].GetYesNo())
-        {
-            TradeSignal signal = CheckDeltaDivergence(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[34].GetYesNo())
-        {
-            TradeSignal signal = CheckVolumeImbalance(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[35].GetYesNo())
-        {
-            TradeSignal signal = CheckStopRunAnticipation(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[36].GetYesNo())
-        {
-            TradeSignal signal = CheckHVNRejection(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[37].GetYesNo())
-        {
-            TradeSignal signal = CheckLVNBreakout(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[38].GetYesNo())
-        {
-            TradeSignal signal = CheckMomentumBreakout(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[39].GetYesNo())
-        {
-            TradeSignal signal = CheckCumulativeDeltaTrend(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
-        }
-        if (runAllStrategies || sc.Input[40].GetYesNo())
+        signals.Clear();
+
+        // Fades stand aside on any bar that can send an order while the flow is toxic
+        uint32_t evaluateMask = (flowToxic && !sc.IsFullRecalculation) ? strategyMask & ~kFadeStrategyMask : strategyMask;
+        CollectStrategySignals(sc, i, evaluateMask, signals);
+        trace.outcome = DECISION_NO_SIGNAL;
+        trace.evaluatedMask = static_cast<uint16_t>(evaluateMask);
+        if (!sc.IsFullRecalculation)
         {
-            TradeSignal signal = CheckLiquidityTraps(sc, i);
-            if (signal.direction != 0) signals.push_back(signal);
+            trace.flags = DECISION_LIVE | (flowToxic ? DECISION_TOXIC : 0);
+            trace.bookImbalance = depthFeatures->imbalance;
+            trace.vpin = tradeTape->toxicity.vpin;
         }
 
         // ===============================================================================
         // SIGNAL PROCESSING AND EXECUTION
         // ===============================================================================
-        if (!signals.empty())
+        if (!signals.Empty())
         {
-            TradeSignal bestSignal = *std::max_element(signals.begin(), signals.end(),
-                [](const TradeSignal& a, const TradeSignal& b) {
-                    return a.confidence < b.confidence;
-                });
-            if (ValidateSignal(sc, bestSignal))
+            int best = signals.Best();
+            NoteFootprintEvents(*footprintExport, i, TraceSignals(trace, signals, best));
+            TradeSignal bestSignal = signals.Take(best);
+            bool bookAllows = !requireBookPressure || sc.IsFullRecalculation ||
+                              HasBookPressure(*depthFeatures, bestSignal.direction, params.minBookImbalance);
+            bool feedAllows = !feedStale || sc.IsFullRecalculation;
+            trace.outcome = !feedAllows ? DECISION_FEED_STALE : !bookAllows ? DECISION_BOOK_BLOCKED : DECISION_INVALID_SIGNAL;
+            if (feedAllows && bookAllows && ValidateSignal(sc, bestSignal))
             {
+                trace.outcome = DECISION_ZERO_SIZE;
                 float positionSize = CalculatePositionSize(sc, bestSignal, *riskMetrics);
                 if (positionSize > 0)
                 {
+                    AOFB_PROBE(PROBE_ORDER_ENTRY);
                     s_SCNewOrder order;
                     order.OrderQuantity = static_cast<int>(positionSize);
                     order.OrderType = SCT_ORDERTYPE_MARKET;
                     order.TimeInForce = SCT_TIF_GOOD_TILL_CANCELED;
-                    order.Stop1Offset = std::abs(bestSignal.entryPrice - bestSignal.stopLoss);
-                    order.Target1Offset = std::abs(bestSignal.target - bestSignal.entryPrice);
+                    order.Stop1Offset = TicksToPrice(*instrument, std::abs(bestSignal.entryTicks - bestSignal.stopTicks));
+                    order.Target1Offset = TicksToPrice(*instrument, std::abs(bestSignal.targetTicks - bestSignal.entryTicks));
                     int orderResult = 0;
                     if (bestSignal.direction == 1)
-                    {
                         orderResult = sc.BuyEntry(order);
-                        sc.Subgraph[9][i] = sc.Low[i] - sc.TickSize;
-                        sc.Subgraph[9].DataColor[i] = sc.Subgraph[9].PrimaryColor;
-                    }
                     else if (bestSignal.direction == -1)
-                    {
                         orderResult = sc.SellEntry(order);
-                        sc.Subgraph[9][i] = sc.High[i] + sc.TickSize;
-                        sc.Subgraph[9].DataColor[i] = sc.Subgraph[9].SecondaryColor;
+                    PlotEntryMarker(sc, i, bestSignal.direction);
+                    trace.outcome = orderResult > 0 ? DECISION_ENTERED : DECISION_ORDER_REJECTED;
+                    if (!sc.IsFullRecalculation && orderResult != 0)
+                    {
+                        RecordStrategyOrder(sc, *breakers, bestSignal, order, orderResult, params);
+                        if (orderResult <= 0) anomaly = "order rejected";
                     }
                     if (orderResult > 0)
                     {
+                        NoteFootprintEvents(*footprintExport, i, bestSignal.direction == 1 ?
+                                            FOOTPRINT_EVENT_LONG_ENTRY : FOOTPRINT_EVENT_SHORT_ENTRY);
                         sc.SetPersistentInt(1, dailyTrades + 1);
                         (*strategyCounts)[bestSignal.strategy]++;
                         LogTrade(sc, bestSignal, "ENTRY");
@@ -666,19 +1695,47 @@ SCSFExport scsf_AdvancedOrderFlowBot(SCStudyInterfaceRef sc)
         // sc.Subgraph[0][i] = sc.Close[i];
     }
     // END MAIN PER-BAR LOOP
-}
 
+    // Bars that closed since the last call leave for the export writer with their events
+    ExportClosedFootprints(sc, *footprintExport);
 
-// ===============================================================================
-// UTILITY FUNCTION IMPLEMENTATIONS
+    // Post-mortem: recent decisions go to the log on request, or after a live anomaly
+    if (!sc.IsFullRecalculation && !anomaly)
+    {
+        if (breakers->trippedMask != trippedBefore) anomaly = "circuit breaker";
+        else if (feedWatchdog->staleEvents != staleEventsBefore) anomaly = "feed stale";
+    }
+    if (sc.Input[118].GetYesNo())
+    {
+        sc.Input[118].SetYesNo(false);
+        DumpDecisionTrace(sc, *decisionTrace, kDecisionTraceBars, "requested");
+    }
+    else if (anomaly && !sc.IsFullRecalculation && sc.Input[119].GetYesNo())
+    {
+        DumpDecisionTrace(sc, *decisionTrace, kDecisionTraceAnomalyBars, anomaly);
+    }
+
+    EndEngineUpdate(sc, *engineHealth, sc.ArraySize - loopStart, params.maxDailyTrades - sc.GetPersistentInt(1));
+    if (sc.Input[111].GetYesNo())
+        DrawEngineHealth(sc, *engineHealth);
+}
+
+
+// ===============================================================================
+// UTILITY FUNCTION IMPLEMENTATIONS
 // ===============================================================================
 
 void UpdateOrderFlowData(SCStudyInterfaceRef sc)
 {
+    UpdateOrderFlowDataAt(sc, sc.Index);
+}
+
+void UpdateOrderFlowDataAt(SCStudyInterfaceRef sc, int index)
+{
+    AOFB_PROBE(PROBE_ORDER_FLOW);
     OrderFlowData* orderFlowData = (OrderFlowData*)sc.GetPersistentPointer(5);
     if (!orderFlowData) return;
     
-    int index = sc.Index;
     if (index < 1) return;
     
     // Calculate current bar delta
@@ -693,7 +1750,7 @@ void UpdateOrderFlowData(SCStudyInterfaceRef sc)
     sc.Subgraph[0][index] = newCumulativeDelta;
     
     // Calculate delta moving average
-    sc.SimpleMovAvg(sc.Subgraph[0], sc.Subgraph[1], sc.Input[71].GetInt());
+    sc.SimpleMovAvg(sc.Subgraph[0], sc.Subgraph[1], index, GetStrategyParameters(sc).deltaMAPeriod);
     
     // Calculate volume imbalance
     float totalVolume = sc.AskVolume[index] + sc.BidVolume[index];
@@ -703,10 +1760,11 @@ void UpdateOrderFlowData(SCStudyInterfaceRef sc)
     }
     
     // Calculate absorption strength
-    float priceRange = sc.High[index] - sc.Low[index];
-    if (priceRange > 0 && totalVolume > 0)
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int rangeTicks = (index < static_cast<int>(ticks.high.size())) ? ticks.high[index] - ticks.low[index] : 0;
+    if (rangeTicks > 0 && totalVolume > 0)
     {
-        orderFlowData->absorptionStrength = totalVolume / (priceRange / sc.TickSize);
+        orderFlowData->absorptionStrength = totalVolume / rangeTicks;
     }
     
     // Update order flow data structure
@@ -716,85 +1774,48 @@ void UpdateOrderFlowData(SCStudyInterfaceRef sc)
 
 void ProcessVolumeProfile(SCStudyInterfaceRef sc)
 {
-    std::vector<float>* hvnLevels = (std::vector<float>*)sc.GetPersistentPointer(1);
-    std::vector<float>* lvnLevels = (std::vector<float>*)sc.GetPersistentPointer(2);
+    AOFB_PROBE(PROBE_VOLUME_PROFILE);
     OrderFlowData* orderFlowData = (OrderFlowData*)sc.GetPersistentPointer(5);
-    
-    if (!hvnLevels || !lvnLevels || !orderFlowData) return;
-    
-    int lookbackBars = sc.Input[83].GetInt();
+    if (!orderFlowData) return;
+
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int lookbackBars = params.profileLookbackBars;
     int startIndex = std::max(0, sc.Index - lookbackBars);
-    
-    // Clear previous levels
-    hvnLevels->clear();
-    lvnLevels->clear();
-    orderFlowData->profileLevels.clear();
-    
-    // Build volume profile
-    std::map<float, float> volumeAtPrice;
-    
-    for (int i = startIndex; i <= sc.Index; i++)
-    {
-        if (i < 0 || i >= sc.ArraySize) continue;
-        
-        float volume = sc.Volume[i];
-        float high = sc.High[i];
-        float low = sc.Low[i];
-        
-        // Distribute volume across price levels within the bar
-        int numLevels = std::max(1, static_cast<int>((high - low) / sc.TickSize));
-        float volumePerLevel = volume / numLevels;
-        
-        for (int level = 0; level < numLevels; level++)
-        {
-            float price = low + (level * sc.TickSize);
-            volumeAtPrice[price] += volumePerLevel;
-        }
-    }
-    
-    if (volumeAtPrice.empty()) return;
-    
-    // Calculate average volume
-    float totalVolume = 0;
-    for (const auto& pair : volumeAtPrice)
-    {
-        totalVolume += pair.second;
-    }
-    float avgVolume = totalVolume / volumeAtPrice.size();
-    
-    // Identify HVN and LVN levels
-    float hvnThreshold = avgVolume * sc.Input[81].GetFloat();
-    float lvnThreshold = avgVolume * sc.Input[82].GetFloat();
-    
-    for (const auto& pair : volumeAtPrice)
+    int endIndex = std::min(sc.Index, static_cast<int>(ticks.low.size()) - 1);
+
+    // Build into a local list and apply through the same path as worker results
+    std::vector<VolumeProfileLevel> levels;
+    orderFlowData->profileBaseTick = BuildProfileNodes(ticks.low, ticks.high, sc.Volume, startIndex, endIndex,
+                                                       params.hvnMultiplier, params.lvnMultiplier,
+                                                       orderFlowData->volumeAtTick, levels);
+
+    ApplyProfileLevels(sc, levels, sc.Index);
+}
+
+void ResetTradingDay(SCStudyInterfaceRef sc, RiskMetrics& metrics, std::map<std::string, int>& strategyCounts,
+                     const StrategyParameters& params)
+{
+    metrics.dailyPnL = 0.0f;
+    metrics.tradesTotal = 0;
+    metrics.tradesWin = 0;
+    metrics.tradesLoss = 0;
+    sc.SetPersistentInt(1, 0); // Reset daily trade count
+    sc.SetPersistentInt(2, 1); // Enable trading for new day
+    sc.SetPersistentFloat(4, 0.0f); // Reset cumulative delta
+    strategyCounts.clear();
+    if (sc.Input[4].GetYesNo())
     {
-        float price = pair.first;
-        float volume = pair.second;
-        
-        VolumeProfileLevel level;
-        level.price = price;
-        level.volume = volume;
-        level.isHVN = (volume >= hvnThreshold);
-        level.isLVN = (volume <= lvnThreshold);
-        
-        orderFlowData->profileLevels.push_back(level);
-        
-        if (level.isHVN)
-        {
-            hvnLevels->push_back(price);
-            sc.Subgraph[6][sc.Index] = price;
-        }
-        
-        if (level.isLVN)
-        {
-            lvnLevels->push_back(price);
-            sc.Subgraph[7][sc.Index] = price;
-        }
+        SCString logMsg;
+        logMsg.Format("=== NEW TRADING DAY === Risk limits reset. Max Loss: $%.2f, Target: $%.2f", 
+                     params.maxDailyLoss, params.dailyProfitTarget);
+        LogMessage(sc, logMsg, 0);
     }
 }
 
 void UpdateRiskMetrics(SCStudyInterfaceRef sc, RiskMetrics& metrics)
 {
+    AOFB_PROBE(PROBE_RISK);
     s_SCPositionData positionData;
     sc.GetTradePosition(positionData);
     
@@ -823,13 +1844,12 @@ void UpdateRiskMetrics(SCStudyInterfaceRef sc, RiskMetrics& metrics)
     }
     
     // Track maximum drawdown
-    static float peakBalance = accountBalance;
-    if (accountBalance > peakBalance)
+    if (accountBalance > metrics.peakBalance)
     {
-        peakBalance = accountBalance;
+        metrics.peakBalance = accountBalance;
     }
     
-    float currentDrawdown = (peakBalance - accountBalance) / peakBalance * 100.0f;
+    float currentDrawdown = (metrics.peakBalance - accountBalance) / metrics.peakBalance * 100.0f;
     if (currentDrawdown > metrics.maxDrawdown)
     {
         metrics.maxDrawdown = currentDrawdown;
@@ -838,8 +1858,9 @@ void UpdateRiskMetrics(SCStudyInterfaceRef sc, RiskMetrics& metrics)
 
 float CalculatePositionSize(SCStudyInterfaceRef sc, const TradeSignal& signal, const RiskMetrics& metrics)
 {
-    float riskPerTrade = sc.Input[14].GetFloat() / 100.0f; // Convert percentage to decimal
-    float baseQuantity = sc.Input[2].GetInt();
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    float riskPerTrade = params.positionRiskPercent / 100.0f; // Convert percentage to decimal
+    float baseQuantity = params.tradeQuantity;
     
     // Calculate risk amount in dollars
     s_SCPositionData positionData;
@@ -849,11 +1870,12 @@ float CalculatePositionSize(SCStudyInterfaceRef sc, const TradeSignal& signal, c
     float riskAmount = accountBalance * riskPerTrade;
     
     // Calculate position size based on stop loss distance
-    float stopDistance = std::abs(signal.entryPrice - signal.stopLoss);
-    if (stopDistance <= 0) return baseQuantity;
+    int stopDistanceTicks = std::abs(signal.entryTicks - signal.stopTicks);
+    if (stopDistanceTicks <= 0) return baseQuantity;
     
-    float pointValue = sc.Input[94].GetFloat();
-    float calculatedSize = riskAmount / (stopDistance * pointValue);
+    float tickValue = GetInstrumentMetadata(sc).tickValue;
+    if (tickValue <= 0) return baseQuantity;
+    float calculatedSize = riskAmount / (stopDistanceTicks * tickValue);
     
     // Apply confidence scaling
     calculatedSize *= signal.confidence;
@@ -865,174 +1887,2622 @@ float CalculatePositionSize(SCStudyInterfaceRef sc, const TradeSignal& signal, c
     return calculatedSize;
 }
 
-bool ValidateSignal(SCStudyInterfaceRef sc, const TradeSignal& signal)
+bool ValidateSignal(SCStudyInterfaceRef sc, const TradeSignal& signal)
+{
+    // Basic validation checks
+    if (signal.direction == 0) return false;
+    if (signal.confidence < 0.5f) return false;
+    if (signal.entryTicks <= 0) return false;
+    if (signal.stopTicks <= 0) return false;
+    if (signal.targetTicks <= 0) return false;
+    
+    // Check if stop loss is in correct direction
+    if (signal.direction == 1 && signal.stopTicks >= signal.entryTicks) return false;
+    if (signal.direction == -1 && signal.stopTicks <= signal.entryTicks) return false;
+    
+    // Check if target is in correct direction
+    if (signal.direction == 1 && signal.targetTicks <= signal.entryTicks) return false;
+    if (signal.direction == -1 && signal.targetTicks >= signal.entryTicks) return false;
+    
+    // Check risk-reward ratio (minimum 1:1.5), exact in ticks: reward / risk >= 3 / 2
+    int risk = std::abs(signal.entryTicks - signal.stopTicks);
+    int reward = std::abs(signal.targetTicks - signal.entryTicks);
+    if (reward * 2 < risk * 3) return false;
+    
+    // Check portfolio heat limits
+    RiskMetrics* riskMetrics = (RiskMetrics*)sc.GetPersistentPointer(3);
+    if (riskMetrics && riskMetrics->portfolioHeat > GetStrategyParameters(sc).maxPortfolioHeat) return false;
+    
+    return true;
+}
+
+void LogTrade(SCStudyInterfaceRef sc, const TradeSignal& signal, const std::string& action)
+{
+    if (!sc.Input[4].GetYesNo()) return; // Detailed logging disabled
+    
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    SCString logMsg;
+    logMsg.Format("%s - %s: %s | Entry: %.2f | Stop: %.2f | Target: %.2f | Confidence: %.2f | Reason: %s",
+                  action.c_str(),
+                  signal.strategy.c_str(),
+                  (signal.direction == 1) ? "LONG" : "SHORT",
+                  TicksToPrice(instrument, signal.entryTicks),
+                  TicksToPrice(instrument, signal.stopTicks),
+                  TicksToPrice(instrument, signal.targetTicks),
+                  signal.confidence,
+                  signal.reason.c_str());
+    
+    LogMessage(sc, logMsg, 0);
+}
+
+bool IsWithinTradingHours(SCStudyInterfaceRef sc)
+{
+    return IsWithinTradingHoursAt(sc, sc.Index);
+}
+
+bool IsWithinTradingHoursAt(SCStudyInterfaceRef sc, int index)
+{
+    SCDateTime currentTime = sc.BaseDateTimeIn[index];
+    SCDateTime tradingStart = sc.Input[21].GetTime();
+    SCDateTime tradingEnd = sc.Input[22].GetTime();
+    
+    // Check if within trading hours
+    bool withinTradingHours = (currentTime.GetTime() >= tradingStart.GetTime() && 
+                              currentTime.GetTime() <= tradingEnd.GetTime());
+    
+    if (!withinTradingHours || !sc.Input[1].GetYesNo()) return false;
+    
+    // Avoid trading near the instrument's regular session open/close
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    SCDateTime marketOpen = instrument.sessionOpen;
+    SCDateTime marketClose = instrument.sessionClose;
+    
+    bool avoidOpenTime = (currentTime.GetTime() < (marketOpen.GetTime() + sc.Input[24].GetInt() * 60));
+    bool avoidCloseTime = (currentTime.GetTime() > (marketClose.GetTime() - sc.Input[25].GetInt() * 60));
+    
+    return !(avoidOpenTime || avoidCloseTime);
+}
+
+float CalculateVolatility(SCStudyInterfaceRef sc, int lookback)
+{
+    AOFB_PROBE(PROBE_VOLATILITY);
+    if (sc.Index < lookback) return 0.0f;
+    
+    std::vector<float> returns;
+    for (int i = sc.Index - lookback + 1; i <= sc.Index; i++)
+    {
+        if (i > 0 && sc.Close[i-1] > 0)
+        {
+            float return_val = (sc.Close[i] - sc.Close[i-1]) / sc.Close[i-1];
+            returns.push_back(return_val);
+        }
+    }
+    
+    if (returns.empty()) return 0.0f;
+    
+    // Calculate standard deviation
+    float mean = std::accumulate(returns.begin(), returns.end(), 0.0f) / returns.size();
+    float variance = 0.0f;
+    
+    for (float ret : returns)
+    {
+        variance += (ret - mean) * (ret - mean);
+    }
+    variance /= returns.size();
+    
+    return std::sqrt(variance);
+}
+
+std::vector<int> FindSwingPoints(SCStudyInterfaceRef sc, int lookback, bool findHighs)
+{
+    AOFB_PROBE(PROBE_SWING_POINTS);
+    std::vector<int> swingPoints;
+    
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    const std::vector<int32_t>& values = findHighs ? ticks.high : ticks.low;
+    int lastIndex = std::min(sc.Index, static_cast<int>(values.size()) - 1);
+    
+    for (int i = lookback; i <= lastIndex - lookback; i++)
+    {
+        bool isSwingPoint = true;
+        int currentValue = values[i];
+        
+        // Check if current point is higher/lower than surrounding points
+        for (int j = i - lookback; j <= i + lookback; j++)
+        {
+            if (j == i) continue;
+            
+            int compareValue = values[j];
+            
+            if (findHighs && compareValue >= currentValue)
+            {
+                isSwingPoint = false;
+                break;
+            }
+            else if (!findHighs && compareValue <= currentValue)
+            {
+                isSwingPoint = false;
+                break;
+            }
+        }
+        
+        if (isSwingPoint)
+        {
+            swingPoints.push_back(currentValue);
+        }
+    }
+    
+    return swingPoints;
+}
+
+// ===============================================================================
+// ENGINE HEALTH IMPLEMENTATION
+// ===============================================================================
+
+void LogMessage(SCStudyInterfaceRef sc, const SCString& message, int showLog)
+{
+    EngineHealth* health = (EngineHealth*)sc.GetPersistentPointer(9);
+    if (health) health->logLinesThisUpdate++;
+    
+    sc.AddMessageToLog(message, showLog);
+}
+
+void BeginEngineUpdate(SCStudyInterfaceRef sc, EngineHealth& health)
+{
+    if (sc.IsFullRecalculation) health.maxUpdateMicros = 0.0f;
+    
+    health.logLinesThisUpdate = 0;
+    health.updateStart = std::chrono::steady_clock::now();
+}
+
+void EndEngineUpdate(SCStudyInterfaceRef sc, EngineHealth& health, int barsProcessed, int orderTokens)
+{
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - health.updateStart;
+    float micros = std::chrono::duration<float, std::micro>(elapsed).count();
+    
+    health.lastUpdateMicros = micros;
+    health.avgUpdateMicros = (health.updateCount == 0) ? micros : health.avgUpdateMicros * 0.9f + micros * 0.1f;
+    health.maxUpdateMicros = std::max(health.maxUpdateMicros, micros);
+    health.barsLastUpdate = barsProcessed;
+    health.logLinesLastUpdate = health.logLinesThisUpdate;
+    health.orderTokens = std::max(0, orderTokens);
+    health.updateCount++;
+    
+    // Full recalculations would swamp the series, so only live updates are recorded
+    int lastIndex = sc.ArraySize - 1;
+    if (lastIndex >= 0 && !sc.IsFullRecalculation)
+    {
+        sc.Subgraph[10][lastIndex] = micros;
+        sc.Subgraph[11][lastIndex] = static_cast<float>(barsProcessed);
+    }
+}
+
+void DrawEngineHealth(SCStudyInterfaceRef sc, const EngineHealth& health)
+{
+    double feedLagSeconds = (sc.CurrentSystemDateTime.GetAsDouble() - sc.LatestDateTimeForLastBar.GetAsDouble()) * 86400.0;
+    bool isSlow = health.lastUpdateMicros > sc.Input[112].GetInt() * 1000.0f;
+    bool isCatchingUp = health.barsLastUpdate >= kCatchUpMinBars && !sc.IsFullRecalculation;
+    
+    SCString text;
+    text.Format("ENGINE  update %.0f us (avg %.0f, max %.0f)  bars %d  log %d  tokens %d  lag %.1f s%s",
+                health.lastUpdateMicros, health.avgUpdateMicros, health.maxUpdateMicros,
+                health.barsLastUpdate, health.logLinesLastUpdate, health.orderTokens,
+                std::max(0.0, feedLagSeconds), health.feedStale ? "  STALE" : (isSlow || isCatchingUp) ? "  BEHIND" : "");
+    
+    s_UseTool tool;
+    tool.Clear();
+    tool.ChartNumber = sc.ChartNumber;
+    tool.DrawingType = DRAWING_TEXT;
+    tool.LineNumber = 79001;
+    tool.AddMethod = UTAM_ADD_OR_ADJUST;
+    tool.Region = sc.GraphRegion;
+    tool.UseRelativeVerticalValues = 1;
+    tool.BeginDateTime = 2;     // Percent from the left edge when using relative values
+    tool.BeginValue = 97;       // Percent from the bottom of the region
+    tool.FontSize = 9;
+    tool.FontBold = 0;
+    tool.Color = (isSlow || isCatchingUp || health.feedStale) ? RGB(255, 80, 80) : RGB(160, 160, 160);
+    tool.Text = text;
+    
+    sc.UseTool(tool);
+}
+
+// ===============================================================================
+// FEED WATCHDOG IMPLEMENTATION
+// ===============================================================================
+
+// Every call: a few compares, and a clock read and stores only when something new arrived
+void NoteFeedArrival(SCStudyInterfaceRef sc, FeedWatchdog& watchdog)
+{
+    if (sc.ArraySize <= 0) return;
+
+    double dataTime = sc.LatestDateTimeForLastBar.GetAsDouble();
+    float volume = sc.Volume[sc.ArraySize - 1];
+    bool timeMoved = dataTime != watchdog.lastDataTime;
+    if (!timeMoved && sc.ArraySize == watchdog.lastArraySize && volume == watchdog.lastVolume) return;
+
+    watchdog.lastArrival = std::chrono::steady_clock::now();
+    watchdog.lastArraySize = sc.ArraySize;
+    watchdog.lastVolume = volume;
+    if (timeMoved)
+    {
+        watchdog.lastDataTime = dataTime;
+        watchdog.arrivalLagSeconds = static_cast<float>((sc.CurrentSystemDateTime.GetAsDouble() - dataTime) * 86400.0);
+    }
+}
+
+// Silence is measured on the monotonic clock, so wall clock steps cannot fake or hide it.
+// Limits come from the parameter set, so a profile can give each symbol its own.
+bool CheckFeedStale(SCStudyInterfaceRef sc, FeedWatchdog& watchdog, const StrategyParameters& params)
+{
+    float silenceSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - watchdog.lastArrival).count();
+    bool silent = params.staleSilenceSeconds > 0.0f && silenceSeconds > params.staleSilenceSeconds;
+    bool lagging = params.staleLagSeconds > 0.0f && watchdog.arrivalLagSeconds > params.staleLagSeconds;
+    bool stale = silent || lagging;
+    if (stale == watchdog.stale) return stale;
+
+    watchdog.stale = stale;
+    if (stale) watchdog.staleEvents++;
+    if (sc.Input[4].GetYesNo())
+    {
+        SCString logMsg;
+        if (!stale)
+            logMsg.Format("FEED RESUMED: data arriving %.1f s behind local time, entries allowed", watchdog.arrivalLagSeconds);
+        else if (silent)
+            logMsg.Format("FEED STALE: no data for %.1f s, entries paused", silenceSeconds);
+        else
+            logMsg.Format("FEED STALE: data arriving %.1f s late, entries paused", watchdog.arrivalLagSeconds);
+        LogMessage(sc, logMsg, 0);
+    }
+    return stale;
+}
+
+// ===============================================================================
+// DECISION TRACE IMPLEMENTATION
+// ===============================================================================
+
+// The live bar is evaluated on every update and keeps a single record showing its latest pass;
+// once a pass entered, later passes write to the scratch record so the entry stays visible
+DecisionTrace& BeginDecisionTrace(DecisionTraceRing& ring, int barIndex)
+{
+    DecisionTrace* trace = nullptr;
+    if (ring.written > 0)
+    {
+        DecisionTrace& last = ring.records[(ring.written - 1) & (kDecisionTraceBars - 1)];
+        if (last.barIndex == barIndex)
+            trace = (last.outcome == DECISION_ENTERED) ? &ring.scratch : &last;
+    }
+    if (!trace) trace = &ring.records[ring.written++ & (kDecisionTraceBars - 1)];
+
+    *trace = DecisionTrace();
+    trace->barIndex = barIndex;
+    trace->selected = -1;
+    return *trace;
+}
+
+// Records every strategy's signal and the selected one; returns the strategies that fired
+uint32_t TraceSignals(DecisionTrace& trace, const SignalColumns& signals, int best)
+{
+    uint32_t signalEvents = 0;
+    for (int s = 0; s < signals.count; s++)
+    {
+        int n = StrategyIndexOf(signals.strategy[s]);
+        if (n < 0) continue;
+        signalEvents |= 1u << n;
+        trace.direction[n] = static_cast<int8_t>(signals.direction[s]);
+        trace.confidence[n] = static_cast<uint8_t>(std::min(1.0f, signals.confidence[s]) * 100.0f + 0.5f);
+        if (s == best) trace.selected = static_cast<int8_t>(n);
+    }
+    trace.firedMask = static_cast<uint16_t>(signalEvents);
+    trace.entryTicks = signals.entryTicks[best];
+    trace.stopTicks = signals.stopTicks[best];
+    trace.targetTicks = signals.targetTicks[best];
+    return signalEvents;
+}
+
+// One log line per bar, oldest first
+void DumpDecisionTrace(SCStudyInterfaceRef sc, const DecisionTraceRing& ring, int bars, const char* reason)
+{
+    static const char* const s_OutcomeNames[] = {
+        "pending", "trading off", "risk limit", "outside hours", "flatten time", "trade limit",
+        "in position", "no signal", "feed stale", "book blocked", "invalid signal", "zero size",
+        "order rejected", "ENTERED", "catch-up"
+    };
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    long long count = std::min<long long>(std::min(bars, kDecisionTraceBars), ring.written);
+
+    SCString logMsg;
+    logMsg.Format("DECISION TRACE (%s): last %lld bars", reason, count);
+    LogMessage(sc, logMsg, 0);
+
+    for (long long k = ring.written - count; k < ring.written; k++)
+    {
+        const DecisionTrace& trace = ring.records[k & (kDecisionTraceBars - 1)];
+        if (trace.barIndex < 0 || trace.barIndex >= sc.ArraySize) continue;
+        int seconds = sc.BaseDateTimeIn[trace.barIndex].GetTime();
+        char line[768];
+        int length = std::snprintf(line, sizeof(line), "  bar %d %02d:%02d:%02d  %s  run %03x  pnl $%.2f  trades %d",
+                                   trace.barIndex, seconds / 3600, seconds / 60 % 60, seconds % 60,
+                                   s_OutcomeNames[trace.outcome], trace.evaluatedMask, trace.dailyPnL, trace.dailyTrades);
+        if (trace.flags & DECISION_LIVE)
+            length += std::snprintf(line + length, sizeof(line) - length, "  book %+.2f  vpin %.2f%s", trace.bookImbalance,
+                                    trace.vpin, (trace.flags & DECISION_TOXIC) ? " toxic" : "");
+        for (int n = 0; n < kStrategyCount && length < static_cast<int>(sizeof(line)); n++)
+        {
+            if (!(trace.firedMask & (1u << n))) continue;
+            length += std::snprintf(line + length, sizeof(line) - length, "  | %s %s %d%%%s", s_StrategyNames[n],
+                                    trace.direction[n] > 0 ? "L" : "S", trace.confidence[n], n == trace.selected ? " *" : "");
+        }
+        if (trace.selected >= 0 && length < static_cast<int>(sizeof(line)))
+            std::snprintf(line + length, sizeof(line) - length, "  | entry %.2f stop %.2f target %.2f",
+                          TicksToPrice(instrument, trace.entryTicks), TicksToPrice(instrument, trace.stopTicks),
+                          TicksToPrice(instrument, trace.targetTicks));
+        LogMessage(sc, line, 0);
+    }
+}
+
+// ===============================================================================
+// BAR BATCH IMPLEMENTATION
+// ===============================================================================
+
+bool IsCatchUpBatch(SCStudyInterfaceRef sc, int firstIndex)
+{
+    return !sc.IsFullRecalculation && sc.ArraySize - firstIndex >= kCatchUpMinBars;
+}
+
+// Older bars of a batch are already history: entries on them could not be filled at their
+// prices, so they only roll the trading day and accumulate order flow, bar by bar
+void AdvanceBarBatch(SCStudyInterfaceRef sc, int firstIndex, int lastIndex, RiskMetrics& metrics,
+                     std::map<std::string, int>& strategyCounts)
+{
+    AOFB_PROBE(PROBE_BAR_BATCH);
+    const StrategyParameters& params = GetStrategyParameters(sc);
+
+    for (int i = firstIndex; i <= lastIndex; ++i)
+    {
+        if (sc.IsNewTradingDay(i))
+            ResetTradingDay(sc, metrics, strategyCounts, params);
+        if (sc.IsNewBar(i))
+            UpdateOrderFlowDataAt(sc, i);
+    }
+}
+
+// An older bar of a catch-up batch gets the decision it would have had live: its strategy
+// plots, entry marker, footprint events and trace record. Its price is gone, so no order.
+// It passes the main loop's gates in the same order, without their actions (disabling
+// trading, flattening, logging), and the trace records the gate it stopped at.
+void DecideCatchUpBar(SCStudyInterfaceRef sc, int index, uint32_t strategyMask, const StrategyParameters& params,
+                      SignalColumns& signals, DecisionTraceRing& ring, FootprintExportState& exportState)
+{
+    DecisionTrace& trace = BeginDecisionTrace(ring, index);
+    s_SCPositionData positionData;
+    sc.GetTradePosition(positionData);
+    int dailyTrades = sc.GetPersistentInt(1);
+    trace.dailyPnL = positionData.DailyProfitLoss;
+    trace.dailyTrades = dailyTrades;
+
+    trace.outcome = DECISION_TRADING_OFF;
+    if (!sc.GetPersistentInt(2)) return;
+    trace.outcome = DECISION_RISK_LIMIT;
+    if (trace.dailyPnL <= -params.maxDailyLoss || trace.dailyPnL >= params.dailyProfitTarget) return;
+    trace.outcome = DECISION_OUTSIDE_HOURS;
+    if (!IsWithinTradingHoursAt(sc, index)) return;
+    trace.outcome = DECISION_FLATTEN_TIME;
+    SCDateTime flattenTime = sc.Input[23].GetTime();
+    if (sc.BaseDateTimeIn[index].GetTime() >= flattenTime.GetTime()) return;
+    trace.outcome = DECISION_TRADE_LIMIT;
+    if (dailyTrades >= params.maxDailyTrades) return;
+    trace.outcome = DECISION_IN_POSITION;
+    if (positionData.PositionQuantity != 0) return;
+
+    signals.Clear();
+    CollectStrategySignals(sc, index, strategyMask, signals);
+    trace.evaluatedMask = static_cast<uint16_t>(strategyMask);
+    trace.outcome = DECISION_NO_SIGNAL;
+    if (signals.Empty()) return;
+
+    int best = signals.Best();
+    NoteFootprintEvents(exportState, index, TraceSignals(trace, signals, best));
+    TradeSignal bestSignal = signals.Take(best);
+    trace.outcome = DECISION_INVALID_SIGNAL;
+    if (!ValidateSignal(sc, bestSignal)) return;
+
+    PlotEntryMarker(sc, index, bestSignal.direction);
+    trace.outcome = DECISION_CATCH_UP;
+}
+
+// First bar that gets signals on a lazy full recalculation
+int GetLazySignalStart(SCStudyInterfaceRef sc)
+{
+    int start = sc.IndexOfFirstVisibleBar - sc.Input[114].GetInt();
+    if (start > sc.ArraySize - 1) start = sc.ArraySize - 1;
+    return start > 0 ? start : 0;
+}
+
+// The chart was scrolled left of the oldest evaluated bar: evaluate the bars in between, up to
+// kBackfillBarsPerCall per call. History only gets its strategy plots and entry markers; no
+// orders, trade counts or footprint events. Levels are the current profile's, not the bar's.
+void BackfillVisibleSignals(SCStudyInterfaceRef sc)
+{
+    AOFB_PROBE(PROBE_BACKFILL);
+    int signalsFrom = sc.GetPersistentInt(4);
+    int wanted = GetLazySignalStart(sc);
+    if (wanted >= signalsFrom) return;
+
+    int first = std::max(wanted, signalsFrom - kBackfillBarsPerCall);
+    SignalColumns signals;
+    for (int i = first; i < signalsFrom; ++i)
+    {
+        signals.Clear();
+        CollectStrategySignals(sc, i, EnabledStrategyMask(sc), signals);
+        if (signals.Empty()) continue;
+
+        TradeSignal bestSignal = signals.Take(signals.Best());
+        if (ValidateSignal(sc, bestSignal))
+            PlotEntryMarker(sc, i, bestSignal.direction);
+    }
+    sc.SetPersistentInt(4, first);
+}
+
+void PlotEntryMarker(SCStudyInterfaceRef sc, int index, int direction)
+{
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    const TickPriceSeries* tickPrices = (const TickPriceSeries*)sc.GetPersistentPointer(8);
+    if (!tickPrices) return;
+
+    if (direction == 1)
+    {
+        sc.Subgraph[9][index] = TicksToPrice(instrument, tickPrices->low[index] - 1);
+        sc.Subgraph[9].DataColor[index] = sc.Subgraph[9].PrimaryColor;
+    }
+    else if (direction == -1)
+    {
+        sc.Subgraph[9][index] = TicksToPrice(instrument, tickPrices->high[index] + 1);
+        sc.Subgraph[9].DataColor[index] = sc.Subgraph[9].SecondaryColor;
+    }
+}
+
+// ===============================================================================
+// STRATEGY WORKER BRIDGE IMPLEMENTATION
+// ===============================================================================
+
+void ApplyProfileLevels(SCStudyInterfaceRef sc, const std::vector<VolumeProfileLevel>& levels, int barIndex)
+{
+    std::vector<int>* hvnLevels = (std::vector<int>*)sc.GetPersistentPointer(1);
+    std::vector<int>* lvnLevels = (std::vector<int>*)sc.GetPersistentPointer(2);
+    OrderFlowData* orderFlowData = (OrderFlowData*)sc.GetPersistentPointer(5);
+
+    if (!hvnLevels || !lvnLevels || !orderFlowData) return;
+
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+
+    hvnLevels->clear();
+    lvnLevels->clear();
+    orderFlowData->profileLevels = levels;
+
+    for (const VolumeProfileLevel& level : levels)
+    {
+        if (level.isHVN)
+        {
+            hvnLevels->push_back(level.priceTicks);
+            sc.Subgraph[6][barIndex] = TicksToPrice(instrument, level.priceTicks);
+        }
+
+        if (level.isLVN)
+        {
+            lvnLevels->push_back(level.priceTicks);
+            sc.Subgraph[7][barIndex] = TicksToPrice(instrument, level.priceTicks);
+        }
+    }
+}
+
+bool ConnectStrategyBridge(SCStudyInterfaceRef sc, StrategyBridgeState& bridge)
+{
+    if (!sc.Input[121].GetYesNo())
+    {
+        if (bridge.mapping.Segment())
+        {
+            bridge.mapping.ReleaseProducer(bridge.producerOwner);
+            bridge.mapping.Close();
+        }
+        bridge.workerAlive = false;
+        return false;
+    }
+
+    std::string name = sc.Input[122].GetString();
+    if (!bridge.mapping.Segment() || name != bridge.name)
+    {
+        // A failed name is retried every few seconds and reported once, not on every call
+        std::chrono::steady_clock::time_point attempt = std::chrono::steady_clock::now();
+        if (!bridge.mapping.Segment() && name == bridge.failedName &&
+            attempt - bridge.lastOpenAttempt < std::chrono::seconds(5))
+            return false;
+        bridge.lastOpenAttempt = attempt;
+
+        bridge.mapping.ReleaseProducer(bridge.producerOwner);
+        bridge.name = name;
+        bridge.publishedFrom = -1;
+        bridge.publishedThrough = -1;
+        bridge.workerAlive = false;
+        bridge.producerOwner = (static_cast<uint32_t>(sc.ChartNumber) << 16) ^
+                               static_cast<uint32_t>(sc.StudyGraphInstanceID) ^ 0x80000000u;
+
+        bool opened = bridge.mapping.Open(name.c_str(), true);
+        bool claimed = opened && bridge.mapping.ClaimProducer(bridge.producerOwner);
+        if (!claimed)
+        {
+            if (opened) bridge.mapping.Close();
+            if (name != bridge.failedName)
+            {
+                SCString logMsg;
+                logMsg.Format("STRATEGY WORKER: %s '%s', analytics stay on the chart thread",
+                              opened ? "another chart already feeds bridge" : "cannot open bridge", name.c_str());
+                LogMessage(sc, logMsg, 1);
+            }
+            bridge.failedName = name;
+            return false;
+        }
+        bridge.failedName.clear();
+
+        // Whatever is already in the segment belongs to an earlier study instance or worker
+        BridgeSegment* segment = bridge.mapping.Segment();
+        BridgeMessage stale;
+        while (segment->toStudy.TryPop(stale)) {}
+        bridge.pendingLevels.clear();
+        bridge.lastWorkerBeat = segment->workerHeartbeat.load(std::memory_order_relaxed);
+        bridge.lastBeatChange = std::chrono::steady_clock::time_point();
+        bridge.workerEpoch = segment->workerEpoch.load(std::memory_order_acquire);
+    }
+
+    BridgeSegment* segment = bridge.mapping.Segment();
+    segment->studyHeartbeat.fetch_add(1, std::memory_order_relaxed);
+
+    // A worker restarted within the heartbeat window still has no history: send it all again,
+    // and drop whatever the previous run was still answering
+    uint32_t workerEpoch = segment->workerEpoch.load(std::memory_order_acquire);
+    if (workerEpoch != bridge.workerEpoch)
+    {
+        bridge.workerEpoch = workerEpoch;
+        bridge.publishedFrom = -1;
+        bridge.publishedThrough = -1;
+        bridge.latestRequestId++;
+        bridge.pendingLevels.clear();
+        if (bridge.workerAlive)
+        {
+            SCString logMsg;
+            logMsg.Format("STRATEGY WORKER: restarted on bridge '%s', resending history", name.c_str());
+            LogMessage(sc, logMsg, 0);
+        }
+    }
+
+    // The worker counts up on every poll; two seconds without a change means it is gone
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    uint32_t workerBeat = segment->workerHeartbeat.load(std::memory_order_relaxed);
+    if (workerBeat != bridge.lastWorkerBeat)
+    {
+        bridge.lastWorkerBeat = workerBeat;
+        bridge.lastBeatChange = now;
+    }
+
+    bool alive = (now - bridge.lastBeatChange) < std::chrono::seconds(2);
+    if (alive != bridge.workerAlive)
+    {
+        bridge.workerAlive = alive;
+        bridge.publishedFrom = -1;  // A (re)started worker has no history
+        bridge.publishedThrough = -1;
+
+        SCString logMsg;
+        logMsg.Format("STRATEGY WORKER: %s on bridge '%s'", alive ? "connected" : "lost", name.c_str());
+        LogMessage(sc, logMsg, 0);
+    }
+    return alive;
+}
+
+void DrainStrategyBridge(SCStudyInterfaceRef sc, StrategyBridgeState& bridge)
+{
+    BridgeSegment* segment = bridge.mapping.Segment();
+    if (!segment) return;
+
+    BridgeMessage message;
+    while (segment->toStudy.TryPop(message))
+    {
+        if (message.type == BRIDGE_MSG_PROFILE_LEVEL)
+        {
+            if (message.level.requestId != bridge.latestRequestId) continue;
+
+            VolumeProfileLevel level;
+            level.priceTicks = message.level.priceTicks;
+            level.volume = message.level.volume;
+            level.isHVN = message.level.isHVN != 0;
+            level.isLVN = message.level.isLVN != 0;
+            bridge.pendingLevels.push_back(level);
+        }
+        else if (message.type == BRIDGE_MSG_PROFILE_END)
+        {
+            if (message.end.requestId == bridge.latestRequestId && message.end.workerEpoch == bridge.workerEpoch &&
+                static_cast<int>(bridge.pendingLevels.size()) == message.end.levelCount)
+            {
+                ApplyProfileLevels(sc, bridge.pendingLevels, message.end.endIndex);
+            }
+            bridge.pendingLevels.clear();
+        }
+    }
+}
+
+bool RequestProfileFromWorker(SCStudyInterfaceRef sc, StrategyBridgeState& bridge)
+{
+    BridgeSegment* segment = bridge.mapping.Segment();
+    if (!segment) return false;
+
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int startIndex = std::max(0, sc.Index - params.profileLookbackBars);
+    int endIndex = std::min(sc.Index, static_cast<int>(ticks.low.size()) - 1);
+    if (endIndex < startIndex) return false;
+
+    // The last bar sent was still forming, so it is sent again with its final values
+    bool reset = (bridge.publishedFrom < 0 || startIndex < bridge.publishedFrom);
+    int firstBar = reset ? startIndex : std::max(startIndex, bridge.publishedThrough);
+    uint32_t needed = static_cast<uint32_t>(endIndex - firstBar + 1) + (reset ? 2 : 1);
+
+    // All or nothing: a full ring falls back to the local calculation for this bar
+    if (segment->toWorker.FreeSlots() < needed) return false;
+
+    BridgeMessage message = {};
+    if (reset)
+    {
+        message.type = BRIDGE_MSG_RESET;
+        message.sequence = bridge.sequence++;
+        segment->toWorker.TryPush(message);
+        bridge.publishedFrom = startIndex;
+    }
+
+    message.type = BRIDGE_MSG_BAR;
+    for (int bar = firstBar; bar <= endIndex; bar++)
+    {
+        message.sequence = bridge.sequence++;
+        message.bar.barIndex = bar;
+        message.bar.openTicks = ticks.open[bar];
+        message.bar.highTicks = ticks.high[bar];
+        message.bar.lowTicks = ticks.low[bar];
+        message.bar.closeTicks = ticks.close[bar];
+        message.bar.volume = sc.Volume[bar];
+        message.bar.bidVolume = sc.BidVolume[bar];
+        message.bar.askVolume = sc.AskVolume[bar];
+        message.bar.dateTime = sc.BaseDateTimeIn[bar].GetAsDouble();
+        segment->toWorker.TryPush(message);
+    }
+    bridge.publishedThrough = endIndex;
+
+    BridgeMessage request = {};
+    request.type = BRIDGE_MSG_PROFILE_REQUEST;
+    request.sequence = bridge.sequence++;
+    request.request.requestId = ++bridge.latestRequestId;
+    request.request.startIndex = startIndex;
+    request.request.endIndex = endIndex;
+    request.request.hvnMultiplier = params.hvnMultiplier;
+    request.request.lvnMultiplier = params.lvnMultiplier;
+    segment->toWorker.TryPush(request);
+
+    bridge.pendingLevels.clear();
+    return true;
+}
+
+// ===============================================================================
+// DEPTH FEATURE IMPLEMENTATION
+// ===============================================================================
+
+// Replaces one level, moving the running sums by the difference
+static inline void SetDepthLevel(int32_t& ticks, int32_t& quantity, int32_t newTicks, int32_t newQuantity,
+                                 int64_t& quantitySum, int64_t& tickVolume)
+{
+    quantitySum += static_cast<int64_t>(newQuantity) - quantity;
+    tickVolume += static_cast<int64_t>(newQuantity) * newTicks - static_cast<int64_t>(quantity) * ticks;
+    ticks = newTicks;
+    quantity = newQuantity;
+}
+
+void UpdateDepthFeatures(SCStudyInterfaceRef sc, DepthFeatures& depth, int levelCount)
+{
+    AOFB_PROBE(PROBE_DEPTH);
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    if (levelCount < 1) levelCount = 1;
+    if (levelCount > kMaxDepthLevels) levelCount = kMaxDepthLevels;
+
+    // Levels no longer tracked leave the sums
+    for (int level = levelCount; level < depth.levelCount; level++)
+    {
+        SetDepthLevel(depth.bidTicks[level], depth.bidQuantity[level], 0, 0, depth.bidQuantitySum, depth.bidTickVolume);
+        SetDepthLevel(depth.askTicks[level], depth.askQuantity[level], 0, 0, depth.askQuantitySum, depth.askTickVolume);
+    }
+    depth.levelCount = levelCount;
+
+    s_MarketDepthEntry entry;
+    for (int level = 0; level < levelCount; level++)
+    {
+        int32_t ticks = 0;
+        int32_t quantity = 0;
+        if (sc.GetBidMarketDepthEntryAtLevel(entry, level) && entry.Quantity > 0)
+        {
+            ticks = PriceToTicks(instrument, entry.Price);
+            quantity = static_cast<int32_t>(entry.Quantity);
+        }
+        if (ticks != depth.bidTicks[level] || quantity != depth.bidQuantity[level])
+        {
+            SetDepthLevel(depth.bidTicks[level], depth.bidQuantity[level], ticks, quantity,
+                          depth.bidQuantitySum, depth.bidTickVolume);
+            depth.levelChanges++;
+        }
+
+        ticks = 0;
+        quantity = 0;
+        if (sc.GetAskMarketDepthEntryAtLevel(entry, level) && entry.Quantity > 0)
+        {
+            ticks = PriceToTicks(instrument, entry.Price);
+            quantity = static_cast<int32_t>(entry.Quantity);
+        }
+        if (ticks != depth.askTicks[level] || quantity != depth.askQuantity[level])
+        {
+            SetDepthLevel(depth.askTicks[level], depth.askQuantity[level], ticks, quantity,
+                          depth.askQuantitySum, depth.askTickVolume);
+            depth.levelChanges++;
+        }
+    }
+
+    depth.hasBook = depth.bidQuantity[0] > 0 && depth.askQuantity[0] > 0;
+    if (!depth.hasBook)
+    {
+        depth.imbalance = 0.0f;
+        depth.micropriceTicks = 0.0;
+        depth.weightedMidTicks = 0.0;
+        return;
+    }
+
+    depth.imbalance = static_cast<float>(static_cast<double>(depth.bidQuantitySum - depth.askQuantitySum) /
+                                         static_cast<double>(depth.bidQuantitySum + depth.askQuantitySum));
+
+    // The microprice moves toward the thinner side, which is the side more likely to trade through
+    double bestBidSize = depth.bidQuantity[0];
+    double bestAskSize = depth.askQuantity[0];
+    depth.micropriceTicks = (depth.bidTicks[0] * bestAskSize + depth.askTicks[0] * bestBidSize) /
+                            (bestBidSize + bestAskSize);
+    depth.weightedMidTicks = 0.5 * (static_cast<double>(depth.bidTickVolume) / depth.bidQuantitySum +
+                                    static_cast<double>(depth.askTickVolume) / depth.askQuantitySum);
+}
+
+// Longs need bid-heavy depth and a microprice at or above the mid, shorts the mirror image.
+// Without a book (history, replay, depth not subscribed) the filter stays open.
+bool HasBookPressure(const DepthFeatures& depth, int direction, float minImbalance)
+{
+    if (!depth.hasBook) return true;
+
+    double midTicks = 0.5 * (depth.bidTicks[0] + depth.askTicks[0]);
+    if (direction == 1)
+        return depth.imbalance >= minImbalance && depth.micropriceTicks >= midTicks;
+    if (direction == -1)
+        return depth.imbalance <= -minImbalance && depth.micropriceTicks <= midTicks;
+    return false;
+}
+
+// ===============================================================================
+// TIME & SALES IMPLEMENTATION
+// ===============================================================================
+
+// Sequence numbers start over after a reconnect or a data reload, and a full recalculation may
+// bring other records: the tape is consumed again from its oldest record, and what was built
+// from it so far goes, so no print is counted twice
+static void RestartTradeTape(TradeTapeState& tape)
+{
+    tape.lastSequence = 0;
+    tape.lastTradeMillis = 0;
+    std::fill(std::begin(tape.clusters), std::end(tape.clusters), TradeClusterSlot());
+    std::fill(&tape.flags[0][0], &tape.flags[0][0] + 2 * kClusterFlagsPerSide, ClipClusterFlag());
+    tape.nextFlag[0] = tape.nextFlag[1] = 0;
+    bool toxic = tape.toxicity.toxic;
+    tape.toxicity = FlowToxicity();
+    tape.toxicity.toxic = toxic;
+}
+
+void PumpTimeAndSales(SCStudyInterfaceRef sc, TradeTapeState& tape, const StrategyParameters& params)
+{
+    AOFB_PROBE(PROBE_TAPE);
+    sc.GetTimeAndSales(tape.timeSales);
+    int count = tape.timeSales.Size();
+    if (sc.IsFullRecalculation || (count > 0 && tape.timeSales[count - 1].Sequence < tape.lastSequence))
+        RestartTradeTape(tape);
+    if (count == 0) return;
+
+    // Walk back to the first record not yet consumed; only new prints are visited
+    int first = count;
+    while (first > 0 && tape.timeSales[first - 1].Sequence > tape.lastSequence) first--;
+
+    // Canonical bars take the live bar's trades once the chart bars before it are in, unless
+    // the bar fallback already started the live bar. Earlier prints were counted from their bars,
+    // except late ones of the bar that just closed while the tape fed it, which the fallback
+    // skips: they go to that bar. Time & Sales is stamped in UTC, bars in chart time.
+    CanonicalBarSeries& canonical = tape.canonicalBars;
+    int liveBar = sc.ArraySize - 1;
+    bool feedCanonical = !sc.IsFullRecalculation && liveBar >= 0 && SyncCanonicalBars(canonical, params);
+    int lateBar = -1;
+    if (feedCanonical)
+    {
+        if (canonical.tapeBar >= 0 && canonical.tapeBar == liveBar - 1) lateBar = canonical.tapeBar;
+        FeedCanonicalFromBars(sc, canonical, liveBar - 1);
+        feedCanonical = canonical.tapeBar == liveBar || (canonical.barsFed == liveBar && canonical.partialBar != liveBar);
+    }
+    double liveBarStart = liveBar >= 0 ? sc.BaseDateTimeIn[liveBar].GetAsDouble() : 0.0;
+    double lateBarStart = lateBar >= 0 ? sc.BaseDateTimeIn[lateBar].GetAsDouble() : 0.0;
+    double chartTimeAdjustment = sc.TimeScaleAdjustment.GetAsDouble();
+
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    for (int t = first; t < count; t++)
+    {
+        const s_TimeAndSales& trade = tape.timeSales[t];
+        tape.lastSequence = trade.Sequence;
+        if (trade.Type != SC_TS_BID && trade.Type != SC_TS_ASK) continue;
+
+        int64_t timeMillis = static_cast<int64_t>(trade.DateTime.GetAsDouble() * 86400000.0 + 0.5);
+        tape.lastTradeMillis = timeMillis;
+        tape.tradesSeen++;
+        RecordTradeClip(tape, trade.Type, PriceToTicks(instrument, trade.Price), static_cast<int>(trade.Volume),
+                        timeMillis, params);
+
+        double volume = static_cast<double>(trade.Volume);
+        tape.toxicity.fromTape = true;
+        AddClassifiedVolume(tape.toxicity, trade.Type == SC_TS_ASK ? volume : 0.0,
+                            trade.Type == SC_TS_BID ? volume : 0.0, params);
+
+        double chartTime = trade.DateTime.GetAsDouble() + chartTimeAdjustment;
+        int chartBar = -1;
+        if (feedCanonical && chartTime >= liveBarStart) chartBar = liveBar;
+        else if (lateBar >= 0 && chartTime >= lateBarStart && chartTime < sc.BaseDateTimeIn[lateBar + 1].GetAsDouble())
+            chartBar = lateBar;
+        if (chartBar >= 0)
+        {
+            float size = static_cast<float>(trade.Volume);
+            if (chartBar == liveBar) canonical.tapeBar = liveBar;
+            AddCanonicalTrade(canonical, PriceToTicks(instrument, trade.Price), trade.Type == SC_TS_BID ? size : 0.0f,
+                              trade.Type == SC_TS_ASK ? size : 0.0f, chartBar);
+        }
+    }
+}
+
+static inline uint64_t TradeClipKey(int tradeType, int priceTicks, int size)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(priceTicks)) << 32) |
+           (static_cast<uint64_t>(size & 0x7FFFFFFF) << 1) | (tradeType == SC_TS_ASK ? 1u : 0u);
+}
+
+void RecordTradeClip(TradeTapeState& tape, int tradeType, int priceTicks, int size, int64_t timeMillis,
+                     const StrategyParameters& params)
+{
+    // Single lots print constantly and fingerprint nothing
+    if (size <= 1) return;
+
+    uint64_t key = TradeClipKey(tradeType, priceTicks, size);
+    int64_t windowMillis = static_cast<int64_t>(params.icebergClipWindowSeconds) * 1000;
+    unsigned int home = static_cast<unsigned int>((key * 0x9E3779B97F4A7C15ull) >> 52) & (kClusterTableSlots - 1);
+
+    // A key only ever lives within its probe window, so the whole window is searched for it.
+    // Failing that the key takes an empty slot, then an expired one, then the stalest live one.
+    TradeClusterSlot* match = nullptr;
+    TradeClusterSlot* victim = nullptr;
+    int victimRank = 3;
+    for (int probe = 0; probe < kClusterProbeLimit; probe++)
+    {
+        TradeClusterSlot& slot = tape.clusters[(home + probe) & (kClusterTableSlots - 1)];
+        if (slot.key == key)
+        {
+            match = &slot;
+            break;
+        }
+        int rank = slot.key == 0 ? 0 : (timeMillis - slot.lastMillis > windowMillis ? 1 : 2);
+        if (rank < victimRank || (rank == victimRank && slot.lastMillis < victim->lastMillis))
+        {
+            victim = &slot;
+            victimRank = rank;
+        }
+    }
+
+    TradeClusterSlot& slot = match ? *match : *victim;
+    if (!match || timeMillis - slot.lastMillis > windowMillis)
+    {
+        slot.key = key;
+        slot.count = 0;
+    }
+    slot.count++;
+    slot.lastMillis = timeMillis;
+    if (slot.count < params.icebergMinClipRepeats) return;
+
+    // Flagged: refresh this cluster's entry in the side's short list, or take the oldest entry
+    int side = tradeType == SC_TS_ASK ? 1 : 0;
+    for (int f = 0; f < kClusterFlagsPerSide; f++)
+    {
+        ClipClusterFlag& flag = tape.flags[side][f];
+        if (flag.count > 0 && flag.priceTicks == priceTicks && flag.size == size)
+        {
+            flag.count = slot.count;
+            flag.lastMillis = timeMillis;
+            return;
+        }
+    }
+    ClipClusterFlag& flag = tape.flags[side][tape.nextFlag[side]];
+    tape.nextFlag[side] = (tape.nextFlag[side] + 1) % kClusterFlagsPerSide;
+    flag.priceTicks = priceTicks;
+    flag.size = size;
+    flag.count = slot.count;
+    flag.lastMillis = timeMillis;
+    tape.clustersFlagged++;
+}
+
+// Spreads the volume over as many buckets as it fills, keeping its buy/sell mix in each
+void AddClassifiedVolume(FlowToxicity& toxicity, double buyVolume, double sellVolume, const StrategyParameters& params)
+{
+    int windowBuckets = std::max(1, std::min(params.vpinWindowBuckets, kMaxVpinBuckets));
+    if (windowBuckets != toxicity.windowBuckets)
+    {
+        toxicity.windowBuckets = windowBuckets;
+        toxicity.bucketCount = 0;
+        toxicity.nextBucket = 0;
+        toxicity.imbalanceSum = 0.0;
+        toxicity.vpin = 0.0f;
+    }
+
+    double bucketVolume = std::max(1, params.vpinBucketVolume);
+    while (buyVolume + sellVolume > 0.0)
+    {
+        double total = buyVolume + sellVolume;
+        double room = bucketVolume - (toxicity.bucketBuy + toxicity.bucketSell);
+        if (total < room)
+        {
+            toxicity.bucketBuy += buyVolume;
+            toxicity.bucketSell += sellVolume;
+            break;
+        }
+
+        // Fill the bucket with this volume's mix and replace the oldest imbalance in the ring
+        double share = room / total;
+        toxicity.bucketBuy += buyVolume * share;
+        toxicity.bucketSell += sellVolume * share;
+        buyVolume -= buyVolume * share;
+        sellVolume -= sellVolume * share;
+
+        float imbalance = static_cast<float>(std::fabs(toxicity.bucketBuy - toxicity.bucketSell) / bucketVolume);
+        if (toxicity.bucketCount == windowBuckets)
+            toxicity.imbalanceSum -= toxicity.bucketImbalance[toxicity.nextBucket];
+        else
+            toxicity.bucketCount++;
+        toxicity.bucketImbalance[toxicity.nextBucket] = imbalance;
+        toxicity.imbalanceSum += imbalance;
+        toxicity.nextBucket = (toxicity.nextBucket + 1) % windowBuckets;
+        toxicity.bucketBuy = 0.0;
+        toxicity.bucketSell = 0.0;
+        toxicity.bucketsCompleted++;
+
+        // Re-sum once per lap so the running total cannot drift
+        if (toxicity.nextBucket == 0)
+        {
+            toxicity.imbalanceSum = 0.0;
+            for (int b = 0; b < toxicity.bucketCount; b++) toxicity.imbalanceSum += toxicity.bucketImbalance[b];
+        }
+        toxicity.vpin = static_cast<float>(toxicity.imbalanceSum / toxicity.bucketCount);
+    }
+}
+
+// Closed bars' bid/ask volume, each bar once, until the tape takes over
+void FeedToxicityFromBars(SCStudyInterfaceRef sc, FlowToxicity& toxicity, const StrategyParameters& params)
+{
+    AOFB_PROBE(PROBE_TOXICITY);
+    if (toxicity.fromTape) return;
+    if (sc.IsFullRecalculation && sc.UpdateStartIndex == 0)
+        toxicity = FlowToxicity();
+
+    // The forming bar is left for the next call, once it has closed
+    for (; toxicity.barsFed < sc.ArraySize - 1; toxicity.barsFed++)
+        AddClassifiedVolume(toxicity, sc.AskVolume[toxicity.barsFed], sc.BidVolume[toxicity.barsFed], params);
+}
+
+bool IsFlowToxic(const FlowToxicity& toxicity, const StrategyParameters& params)
+{
+    return toxicity.bucketCount >= toxicity.windowBuckets && toxicity.windowBuckets > 0 &&
+           toxicity.vpin > params.maxFadeVpin;
+}
+
+// Most repeats of any live clip cluster within tolerance of the level, 0 when none. The tape
+// describes the present, so only the live bar is confirmed.
+int GetClipClusterRepeats(SCStudyInterfaceRef sc, int tradeType, int priceTicks, int toleranceTicks, int index)
+{
+    TradeTapeState* tape = (TradeTapeState*)sc.GetPersistentPointer(12);
+    if (!tape || index != sc.ArraySize - 1) return 0;
+
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    int64_t windowMillis = static_cast<int64_t>(params.icebergClipWindowSeconds) * 1000;
+    int side = tradeType == SC_TS_ASK ? 1 : 0;
+    int best = 0;
+    for (int f = 0; f < kClusterFlagsPerSide; f++)
+    {
+        const ClipClusterFlag& flag = tape->flags[side][f];
+        if (flag.count > best && std::abs(flag.priceTicks - priceTicks) <= toleranceTicks &&
+            tape->lastTradeMillis - flag.lastMillis <= windowMillis)
+            best = flag.count;
+    }
+    return best;
+}
+
+// ===============================================================================
+// CANONICAL BAR IMPLEMENTATION
+// ===============================================================================
+
+void ResetCanonicalBars(CanonicalBarSeries& series)
+{
+    series = CanonicalBarSeries();
+    series.type = -1;
+    series.tapeBar = -1;
+    series.partialBar = -1;
+}
+
+// Starts the bars over when the type or size changed; false while canonical bars are off
+bool SyncCanonicalBars(CanonicalBarSeries& series, const StrategyParameters& params)
+{
+    int type = params.canonicalBarType;
+    int size = 0;
+    if (type == CANONICAL_VOLUME_BARS) size = params.canonicalVolumeBarSize;
+    else if (type == CANONICAL_RANGE_BARS) size = params.canonicalRangeBarTicks;
+    if (type != series.type || size != series.size)
+    {
+        ResetCanonicalBars(series);
+        series.type = type;
+        series.size = size;
+    }
+    return type != CANONICAL_CHART_BARS && size > 0;
+}
+
+static void OpenCanonicalBar(CanonicalBarSeries& series, int priceTicks)
+{
+    series.forming = CanonicalBar{priceTicks, priceTicks, priceTicks, priceTicks, 0.0f, 0.0f, 0.0f, -1};
+    series.hasForming = true;
+}
+
+static void CompleteCanonicalBar(CanonicalBarSeries& series, int chartBar)
+{
+    series.forming.chartBar = chartBar;
+    series.bars[series.nextSlot] = series.forming;
+    series.nextSlot = (series.nextSlot + 1) % kCanonicalBarRing;
+    series.completed++;
+    series.hasForming = false;
+}
+
+// One print. A volume bar closes on exactly its size, a larger print is split over as many
+// bars as it fills; a range bar closes at its edge once price goes past it, and a jump walks
+// through the gap one bar at a time, each next bar opening a tick beyond the last.
+void AddCanonicalTrade(CanonicalBarSeries& series, int priceTicks, float bidVolume, float askVolume, int chartBar)
+{
+    if (series.size <= 0) return;
+
+    if (series.type == CANONICAL_VOLUME_BARS)
+    {
+        float size = static_cast<float>(series.size);
+        float volume = bidVolume + askVolume;
+        if (volume <= 0.0f && series.hasForming)
+        {
+            series.forming.high = std::max(series.forming.high, priceTicks);
+            series.forming.low = std::min(series.forming.low, priceTicks);
+            series.forming.close = priceTicks;
+        }
+        while (volume > 0.0f)
+        {
+            if (!series.hasForming) OpenCanonicalBar(series, priceTicks);
+            CanonicalBar& bar = series.forming;
+            float take = std::min(volume, size - bar.volume);
+            float share = take / volume;
+            bar.high = std::max(bar.high, priceTicks);
+            bar.low = std::min(bar.low, priceTicks);
+            bar.close = priceTicks;
+            bar.volume += take;
+            bar.bidVolume += bidVolume * share;
+            bar.askVolume += askVolume * share;
+            bidVolume -= bidVolume * share;
+            askVolume -= askVolume * share;
+            volume -= take;
+            if (bar.volume >= size) CompleteCanonicalBar(series, chartBar);
+        }
+        return;
+    }
+
+    if (!series.hasForming) OpenCanonicalBar(series, priceTicks);
+    while (priceTicks > series.forming.low + series.size)
+    {
+        int edge = series.forming.low + series.size;
+        series.forming.high = edge;
+        series.forming.close = edge;
+        CompleteCanonicalBar(series, chartBar);
+        OpenCanonicalBar(series, edge + 1);
+    }
+    while (priceTicks < series.forming.high - series.size)
+    {
+        int edge = series.forming.high - series.size;
+        series.forming.low = edge;
+        series.forming.close = edge;
+        CompleteCanonicalBar(series, chartBar);
+        OpenCanonicalBar(series, edge - 1);
+    }
+    CanonicalBar& bar = series.forming;
+    bar.high = std::max(bar.high, priceTicks);
+    bar.low = std::min(bar.low, priceTicks);
+    bar.close = priceTicks;
+    bar.volume += bidVolume + askVolume;
+    bar.bidVolume += bidVolume;
+    bar.askVolume += askVolume;
+}
+
+// Without a bid/ask split a chart bar's volume counts half to each side
+static void ChartBarSideVolume(SCStudyInterfaceRef sc, int bar, float& bidVolume, float& askVolume)
+{
+    bidVolume = sc.BidVolume[bar];
+    askVolume = sc.AskVolume[bar];
+    if (bidVolume + askVolume <= 0.0f) bidVolume = askVolume = sc.Volume[bar] * 0.5f;
+}
+
+// What the forming chart bar added since it was last fed: new extremes, the one farther from
+// the close first, then the added volume at the close
+static void FeedChartBarChanges(SCStudyInterfaceRef sc, CanonicalBarSeries& series, const TickPriceSeries& ticks, int bar)
+{
+    if (series.partialBar != bar)
+    {
+        series.partialBar = bar;
+        series.partialHigh = series.partialLow = ticks.open[bar];
+        series.partialBidVolume = series.partialAskVolume = 0.0f;
+        AddCanonicalTrade(series, ticks.open[bar], 0.0f, 0.0f, bar);
+    }
+
+    int high = ticks.high[bar];
+    int low = ticks.low[bar];
+    bool lowFirst = ticks.close[bar] - low > high - ticks.close[bar];
+    for (int pass = 0; pass < 2; pass++)
+    {
+        if ((pass == 0) == lowFirst && low < series.partialLow)
+        {
+            AddCanonicalTrade(series, low, 0.0f, 0.0f, bar);
+            series.partialLow = low;
+        }
+        else if ((pass == 0) != lowFirst && high > series.partialHigh)
+        {
+            AddCanonicalTrade(series, high, 0.0f, 0.0f, bar);
+            series.partialHigh = high;
+        }
+    }
+
+    float bidVolume, askVolume;
+    ChartBarSideVolume(sc, bar, bidVolume, askVolume);
+    AddCanonicalTrade(series, ticks.close[bar], std::max(0.0f, bidVolume - series.partialBidVolume),
+                      std::max(0.0f, askVolume - series.partialAskVolume), bar);
+    series.partialBidVolume = std::max(series.partialBidVolume, bidVolume);
+    series.partialAskVolume = std::max(series.partialAskVolume, askVolume);
+}
+
+// Chart bars through lastBar, except one the tape fed. The forming bar is fed as far as it
+// has got and stays current; a bar fed while forming gets its remainder once it has closed.
+void FeedCanonicalFromBars(SCStudyInterfaceRef sc, CanonicalBarSeries& series, int lastBar)
+{
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int liveBar = static_cast<int>(ticks.close.size()) - 1;
+    lastBar = std::min(lastBar, liveBar);
+    for (; series.barsFed <= lastBar; series.barsFed++)
+    {
+        int bar = series.barsFed;
+        if (bar == series.tapeBar) continue;
+        if (bar == liveBar || bar == series.partialBar)
+        {
+            FeedChartBarChanges(sc, series, ticks, bar);
+            if (bar == liveBar) break;
+            continue;
+        }
+
+        float bidVolume, askVolume;
+        ChartBarSideVolume(sc, bar, bidVolume, askVolume);
+        bool upBar = ticks.close[bar] >= ticks.open[bar];
+        const int path[4] = {ticks.open[bar], upBar ? ticks.low[bar] : ticks.high[bar],
+                             upBar ? ticks.high[bar] : ticks.low[bar], ticks.close[bar]};
+        for (int print = 0; print < 4; print++)
+            AddCanonicalTrade(series, path[print], bidVolume * 0.25f, askVolume * 0.25f, bar);
+    }
+}
+
+// Canonical bars fed through the chart bar at index, or nullptr when the strategies read chart
+// bars. The ring only holds the last kCanonicalBarRing bars, so a chart bar before the oldest of
+// them (lazy history scrolled far left) is measured on the chart bar itself
+const CanonicalBarSeries* GetCanonicalBars(SCStudyInterfaceRef sc, int index)
+{
+    TradeTapeState* tape = (TradeTapeState*)sc.GetPersistentPointer(12);
+    if (!tape || !SyncCanonicalBars(tape->canonicalBars, GetStrategyParameters(sc))) return nullptr;
+
+    CanonicalBarSeries& series = tape->canonicalBars;
+    FeedCanonicalFromBars(sc, series, index);
+    if (series.completed > kCanonicalBarRing && series.bars[series.nextSlot].chartBar > index) return nullptr;
+    return &series;
+}
+
+// Strategy bars to evaluate at chart bar index: the chart bar itself, or every canonical bar
+// that closed during it, possibly none. A canonical bar is acted on once, where it closes.
+int CountStrategyBars(SCStudyInterfaceRef sc, int index)
+{
+    const CanonicalBarSeries* series = GetCanonicalBars(sc, index);
+    if (!series) return 1;
+
+    int available = static_cast<int>(std::min<long long>(series->completed, kCanonicalBarRing));
+    int count = 0;
+    for (int n = 0; n < available; n++)
+    {
+        int chartBar = series->bars[(series->nextSlot - 1 - n + kCanonicalBarRing) % kCanonicalBarRing].chartBar;
+        if (chartBar > index) continue;
+        if (chartBar < index) break;
+        count++;
+    }
+    return count;
+}
+
+// The bar back bars before the newest strategy bar closed by the end of chart bar index: chart
+// bars, or canonical bars newest first. False when there is no such bar.
+bool GetStrategyBar(SCStudyInterfaceRef sc, int index, int back, CanonicalBar& bar)
+{
+    const CanonicalBarSeries* series = GetCanonicalBars(sc, index);
+    if (!series)
+    {
+        int chartBar = index - back;
+        const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+        if (chartBar < 0 || chartBar >= static_cast<int>(ticks.close.size())) return false;
+        bar = CanonicalBar{ticks.open[chartBar], ticks.high[chartBar], ticks.low[chartBar], ticks.close[chartBar],
+                           sc.Volume[chartBar], sc.BidVolume[chartBar], sc.AskVolume[chartBar], chartBar};
+        return true;
+    }
+
+    int available = static_cast<int>(std::min<long long>(series->completed, kCanonicalBarRing));
+    int newest = -1;
+    for (int n = 0; n < available; n++)
+    {
+        const CanonicalBar& entry = series->bars[(series->nextSlot - 1 - n + kCanonicalBarRing) % kCanonicalBarRing];
+        if (entry.chartBar > index) continue;
+        if (newest < 0) newest = n;
+        if (n - newest == back)
+        {
+            bar = entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ===============================================================================
+// FOOTPRINT IMPLEMENTATION
+// ===============================================================================
+
+// Per-price bid/ask volume from the chart's volume-at-price data. Without it (headless,
+// VAP off) the bar's bid and ask volume are spread evenly over its range, as the profile
+// does, and the bar is flagged approximate.
+void BuildFootprintBar(SCStudyInterfaceRef sc, int index, FootprintBar& bar)
+{
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    bar.timeMillis = std::llround((sc.BaseDateTimeIn[index].GetAsDouble() - 25569.0) * 86400000.0);
+    bar.barIndex = index;
+    bar.openTicks = ticks.open[index];
+    bar.highTicks = ticks.high[index];
+    bar.lowTicks = ticks.low[index];
+    bar.closeTicks = ticks.close[index];
+    bar.events = 0;
+    bar.flags = 0;
+    bar.levels.clear();
+
+    int vapCount = sc.VolumeAtPriceForBars ? sc.VolumeAtPriceForBars->GetSizeAtBarIndex(index) : 0;
+    for (int v = 0; v < vapCount; v++)
+    {
+        s_VolumeAtPriceV2* vap = nullptr;
+        if (!sc.VolumeAtPriceForBars->GetVAPElementAtIndex(index, v, &vap) || !vap) continue;
+        if (vap->BidVolume == 0 && vap->AskVolume == 0) continue;
+        bar.levels.push_back({static_cast<int32_t>(vap->PriceInTicks), static_cast<uint32_t>(vap->BidVolume),
+                              static_cast<uint32_t>(vap->AskVolume)});
+    }
+
+    if (bar.levels.empty())
+    {
+        bar.flags |= FOOTPRINT_APPROXIMATE;
+        uint32_t rows = static_cast<uint32_t>(std::max(1, bar.highTicks - bar.lowTicks + 1));
+        uint32_t bidVolume = static_cast<uint32_t>(sc.BidVolume[index]);
+        uint32_t askVolume = static_cast<uint32_t>(sc.AskVolume[index]);
+        for (uint32_t row = 0; row < rows; row++)
+        {
+            uint32_t bid = bidVolume / rows + (row < bidVolume % rows ? 1 : 0);
+            uint32_t ask = askVolume / rows + (row < askVolume % rows ? 1 : 0);
+            if (bid == 0 && ask == 0) continue;
+            bar.levels.push_back({bar.lowTicks + static_cast<int32_t>(row), bid, ask});
+        }
+    }
+
+    int64_t delta = 0;
+    uint64_t volume = 0;
+    uint32_t pocVolume = 0;
+    bar.pocTicks = bar.closeTicks;
+    for (const FootprintLevel& level : bar.levels)
+    {
+        delta += static_cast<int64_t>(level.askVolume) - level.bidVolume;
+        volume += static_cast<uint64_t>(level.askVolume) + level.bidVolume;
+        if (level.askVolume + level.bidVolume > pocVolume)
+        {
+            pocVolume = level.askVolume + level.bidVolume;
+            bar.pocTicks = level.priceTicks;
+        }
+    }
+    bar.delta = static_cast<int32_t>(delta);
+    bar.volume = static_cast<uint32_t>(volume);
+}
+
+// Bars closed since the study started, each exported once. History present at a full
+// recalculation is already in Sierra Chart and is skipped.
+void ExportClosedFootprints(SCStudyInterfaceRef sc, FootprintExportState& state)
+{
+    AOFB_PROBE(PROBE_FOOTPRINT_EXPORT);
+    if (!sc.Input[124].GetYesNo())
+    {
+        state.exporter.Close();
+        state.openFailed = false;
+        return;
+    }
+
+    if (!state.exporter.IsOpen() && !state.openFailed)
+    {
+        std::string folder = sc.Input[125].GetString();
+        std::string path = folder.empty() ? "" : folder + "/";
+        path += sc.Symbol.GetChars();
+        path += ".afp";
+        state.openFailed = !state.exporter.Open(path, sc.Symbol.GetChars(), sc.TickSize);
+        if (state.openFailed)
+        {
+            SCString logMsg;
+            logMsg.Format("FOOTPRINT EXPORT: not writing %s, %s", path.c_str(), state.exporter.Error().c_str());
+            LogMessage(sc, logMsg, 1);
+        }
+        else if (sc.Input[4].GetYesNo())
+        {
+            SCString logMsg;
+            logMsg.Format("FOOTPRINT EXPORT: writing %s", path.c_str());
+            LogMessage(sc, logMsg, 0);
+        }
+        state.barsExported = sc.ArraySize - 1;
+    }
+    if (!state.exporter.IsOpen()) return;
+
+    if (sc.IsFullRecalculation && sc.UpdateStartIndex == 0)
+        state.barsExported = sc.ArraySize - 1;
+
+    for (; state.barsExported < sc.ArraySize - 1; state.barsExported++)
+    {
+        FootprintBar* bar = state.exporter.Acquire();
+        if (!bar) continue;
+        BuildFootprintBar(sc, state.barsExported, *bar);
+        int slot = state.barsExported & (kFootprintEventBars - 1);
+        if (state.eventBar[slot] == state.barsExported) bar->events = state.events[slot];
+        state.exporter.Publish(bar);
+    }
+
+    // The study never waits for the writer; bars it could not take are counted and reported
+    unsigned long long dropped = state.exporter.BarsDropped();
+    if (dropped != state.droppedReported && sc.Input[4].GetYesNo())
+    {
+        SCString logMsg;
+        logMsg.Format("FOOTPRINT EXPORT: writer behind, %llu bars dropped in total", dropped);
+        LogMessage(sc, logMsg, 0);
+    }
+    state.droppedReported = dropped;
+
+    unsigned long long failed = state.exporter.BarsFailed();
+    if (failed != state.failedReported)
+    {
+        SCString logMsg;
+        logMsg.Format("FOOTPRINT EXPORT: write to %s failed, %llu bars lost in total", state.exporter.Path().c_str(), failed);
+        LogMessage(sc, logMsg, 1);
+    }
+    state.failedReported = failed;
+}
+
+void NoteFootprintEvents(FootprintExportState& state, int index, uint32_t events)
+{
+    int slot = index & (kFootprintEventBars - 1);
+    if (index != state.eventBar[slot])
+    {
+        state.eventBar[slot] = index;
+        state.events[slot] = 0;
+    }
+    state.events[slot] |= events;
+}
+
+// Bit n is the strategy enabled by input 31 + n
+uint32_t StrategyEventBit(const std::string& strategy)
+{
+    int n = StrategyIndexOf(strategy);
+    return n < 0 ? 0 : 1u << n;
+}
+
+// ===============================================================================
+// FOOTPRINT FEATURE IMPLEMENTATION
+// ===============================================================================
+
+void ResetFootprintFeatures(FootprintFeatureSeries& series)
+{
+    series.bars.assign(series.bars.size(), FootprintFeatures{});
+}
+
+// Reads the ends of the level list; an approximate bar has no real extremes and gets no features
+FootprintFeatures ComputeFootprintFeatures(const FootprintBar& bar)
+{
+    FootprintFeatures features = {FOOTPRINT_FEATURES_COMPUTED, 0, 0, 0, 0, 0, 0};
+    int count = static_cast<int>(bar.levels.size());
+    if ((bar.flags & FOOTPRINT_APPROXIMATE) || count == 0) return features;
+
+    const FootprintLevel& low = bar.levels.front();
+    const FootprintLevel& high = bar.levels.back();
+    features.levelCount = static_cast<uint16_t>(std::min(count, 0xFFFF));
+    features.volume = bar.volume;
+    features.highVolume = high.bidVolume + high.askVolume;
+    features.lowVolume = low.bidVolume + low.askVolume;
+    for (int row = 0; row < std::min(count, kFootprintExtremeRows); row++)
+    {
+        const FootprintLevel& top = bar.levels[count - 1 - row];
+        const FootprintLevel& bottom = bar.levels[row];
+        features.highDelta += static_cast<int32_t>(top.askVolume) - static_cast<int32_t>(top.bidVolume);
+        features.lowDelta += static_cast<int32_t>(bottom.askVolume) - static_cast<int32_t>(bottom.bidVolume);
+    }
+
+    if (high.bidVolume > 0) features.flags |= FOOTPRINT_UNFINISHED_HIGH;
+    if (low.askVolume > 0) features.flags |= FOOTPRINT_UNFINISHED_LOW;
+    if (bar.delta > 0 && features.highDelta < 0) features.flags |= FOOTPRINT_DIVERGENT_HIGH;
+    if (bar.delta < 0 && features.lowDelta > 0) features.flags |= FOOTPRINT_DIVERGENT_LOW;
+    return features;
+}
+
+// Features of the bar at index, nullptr when they are off. A closed bar is built and measured
+// the first time any strategy asks; the forming bar is measured again on every request.
+const FootprintFeatures* GetFootprintFeatures(SCStudyInterfaceRef sc, int index)
+{
+    FootprintFeatureSeries* series = (FootprintFeatureSeries*)sc.GetPersistentPointer(19);
+    if (!series || GetStrategyParameters(sc).footprintFeatureWeight <= 0.0f || index < 0 || index >= sc.ArraySize)
+        return nullptr;
+
+    if (index == sc.ArraySize - 1)
+    {
+        BuildFootprintBar(sc, index, series->scratch);
+        series->live = ComputeFootprintFeatures(series->scratch);
+        return &series->live;
+    }
+
+    if (series->bars.size() < static_cast<size_t>(sc.ArraySize))
+        series->bars.resize(static_cast<size_t>(sc.ArraySize), FootprintFeatures{});
+    FootprintFeatures& features = series->bars[index];
+    if (!(features.flags & FOOTPRINT_FEATURES_COMPUTED))
+    {
+        BuildFootprintBar(sc, index, series->scratch);
+        features = ComputeFootprintFeatures(series->scratch);
+    }
+    return &features;
+}
+
+// A signal that expects price to turn at the bar's high or low gains on exhaustion there and on
+// extreme delta against the bar, and loses on an unfinished auction there, which price tends to
+// revisit. A signal that expects price to carry on through that extreme is weighted the other way.
+float ApplyFootprintFeatures(SCStudyInterfaceRef sc, int index, bool atHigh, bool reversal, float confidence)
+{
+    const FootprintFeatures* features = GetFootprintFeatures(sc, index);
+    if (!features || features->levelCount < 2) return confidence;
+
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    float extremeVolume = static_cast<float>(atHigh ? features->highVolume : features->lowVolume);
+    bool exhausted = features->levelCount >= 3 &&
+                     extremeVolume * features->levelCount <= params.exhaustionVolumeRatio * features->volume;
+    bool divergent = (features->flags & (atHigh ? FOOTPRINT_DIVERGENT_HIGH : FOOTPRINT_DIVERGENT_LOW)) != 0;
+    bool unfinished = (features->flags & (atHigh ? FOOTPRINT_UNFINISHED_HIGH : FOOTPRINT_UNFINISHED_LOW)) != 0;
+
+    int score = (exhausted ? 1 : 0) + (divergent ? 1 : 0) - (unfinished ? 1 : 0);
+    if (!reversal) score = -score;
+    return std::max(0.0f, std::min(1.0f, confidence + params.footprintFeatureWeight * score));
+}
+
+// ===============================================================================
+// STRATEGY BREAKER IMPLEMENTATION
+// ===============================================================================
+
+// Position of a strategy's enable input after input 31, -1 for an unknown name
+int StrategyIndexOf(const std::string& strategy)
+{
+    for (int n = 0; n < kStrategyCount; n++)
+        if (strategy == s_StrategyNames[n]) return n;
+    return -1;
+}
+
+uint32_t EnabledStrategyMask(SCStudyInterfaceRef sc)
+{
+    if (sc.Input[5].GetYesNo()) return (1u << kStrategyCount) - 1;
+
+    uint32_t mask = 0;
+    for (int n = 0; n < kStrategyCount; n++)
+        if (sc.Input[31 + n].GetYesNo()) mask |= 1u << n;
+    return mask;
+}
+
+// A live entry was sent: a rejection counts toward the strategy's error rate, an accepted
+// order becomes the trade its fill and exit are attributed to
+void RecordStrategyOrder(SCStudyInterfaceRef sc, StrategyBreakers& breakers, const TradeSignal& signal,
+                         const s_SCNewOrder& order, int orderResult, const StrategyParameters& params)
+{
+    int n = StrategyIndexOf(signal.strategy);
+    if (n < 0) return;
+
+    breakers.orderAttempts[n]++;
+    if (orderResult <= 0)
+    {
+        breakers.orderErrors[n]++;
+        float errorPercent = breakers.orderErrors[n] * 100.0f / breakers.orderAttempts[n];
+        if (params.breakerMaxErrorPercent > 0.0f && breakers.orderAttempts[n] >= kBreakerMinOrders &&
+            errorPercent >= params.breakerMaxErrorPercent)
+            TripStrategyBreaker(sc, breakers, n, BREAKER_ORDER_ERRORS, errorPercent);
+        return;
+    }
+
+    s_SCPositionData positionData;
+    sc.GetTradePosition(positionData);
+    breakers.openStrategy = n;
+    breakers.openOrderId = order.InternalOrderID;
+    breakers.openDirection = signal.direction;
+    breakers.openEntryTicks = signal.entryTicks;
+    breakers.pnlAtEntry = positionData.DailyProfitLoss;
+    breakers.fillSeen = false;
+}
+
+// Once per call. The counters start over when the live bar reaches a new trading day; bars of
+// a recalculation never do, so a reload cannot re-arm a tripped strategy. The attributed trade
+// is followed through its entry order, not the position, so a trade that fills and exits
+// between two calls is still seen: the order's fill is checked for slippage, and once the
+// position is flat again the daily P&L change since the entry moves the strategy's loss
+// streak and drawdown.
+void UpdateStrategyBreakers(SCStudyInterfaceRef sc, StrategyBreakers& breakers, const StrategyParameters& params)
+{
+    if (sc.ArraySize <= 0) return;
+    int tradingDate = sc.GetTradingDayDate(sc.BaseDateTimeIn[sc.ArraySize - 1]);
+    if (tradingDate > breakers.tradingDate)
+    {
+        // Daily P&L restarts with the session, so a trade open across it is not attributed
+        breakers = StrategyBreakers();
+        breakers.tradingDate = tradingDate;
+    }
+
+    int n = breakers.openStrategy;
+    if (n < 0) return;
+
+    s_SCTradeOrder entryOrder;
+    if (sc.GetOrderByOrderID(breakers.openOrderId, entryOrder) == SCTRADING_ORDER_ERROR ||
+        entryOrder.OrderStatusCode == SCT_OSC_CANCELED || entryOrder.OrderStatusCode == SCT_OSC_ERROR)
+    {
+        breakers.openStrategy = -1;     // Never filled, or no longer known: nothing to attribute
+        return;
+    }
+    if (entryOrder.OrderStatusCode != SCT_OSC_FILLED) return;
+
+    if (!breakers.fillSeen)
+    {
+        breakers.fillSeen = true;
+        const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+        int fillTicks = PriceToTicks(instrument, static_cast<float>(entryOrder.AvgFillPrice));
+        int slippageTicks = (fillTicks - breakers.openEntryTicks) * breakers.openDirection;
+        if (params.breakerMaxSlippageTicks > 0 && slippageTicks > params.breakerMaxSlippageTicks)
+            TripStrategyBreaker(sc, breakers, n, BREAKER_SLIPPAGE, static_cast<float>(slippageTicks));
+    }
+
+    s_SCPositionData positionData;
+    sc.GetTradePosition(positionData);
+    if (positionData.PositionQuantity != 0) return;
+
+    float tradePnL = static_cast<float>(positionData.DailyProfitLoss - breakers.pnlAtEntry);
+    breakers.openStrategy = -1;
+    breakers.realizedPnL[n] += tradePnL;
+    breakers.peakPnL[n] = std::max(breakers.peakPnL[n], breakers.realizedPnL[n]);
+    if (tradePnL < 0.0f) breakers.consecutiveLosses[n]++;
+    else if (tradePnL > 0.0f) breakers.consecutiveLosses[n] = 0;
+
+    float drawdown = breakers.peakPnL[n] - breakers.realizedPnL[n];
+    if (params.breakerMaxConsecutiveLosses > 0 && breakers.consecutiveLosses[n] >= params.breakerMaxConsecutiveLosses)
+        TripStrategyBreaker(sc, breakers, n, BREAKER_LOSS_STREAK, breakers.consecutiveLosses[n]);
+    else if (params.breakerMaxDrawdown > 0.0f && drawdown >= params.breakerMaxDrawdown)
+        TripStrategyBreaker(sc, breakers, n, BREAKER_DRAWDOWN, drawdown);
+}
+
+void TripStrategyBreaker(SCStudyInterfaceRef sc, StrategyBreakers& breakers, int strategy, BreakerReason reason,
+                         float value)
+{
+    uint32_t bit = 1u << strategy;
+    if (breakers.trippedMask & bit) return;
+    breakers.trippedMask |= bit;
+    breakers.reason[strategy] = reason;
+
+    if (sc.Input[4].GetYesNo())
+    {
+        static const char* const s_ReasonNames[] = {
+            "", "consecutive losses", "drawdown ($)", "order error rate (%)", "entry slippage (ticks)"
+        };
+        SCString logMsg;
+        logMsg.Format("CIRCUIT BREAKER: %s disabled for the session - %s %.2f", s_StrategyNames[strategy],
+                      s_ReasonNames[reason], value);
+        LogMessage(sc, logMsg, 0);
+    }
+}
+
+// ===============================================================================
+// INTEGER TICK PRICE IMPLEMENTATION
+// ===============================================================================
+
+void UpdateTickPriceSeries(SCStudyInterfaceRef sc, TickPriceSeries& series, int startIndex)
+{
+    AOFB_PROBE(PROBE_TICK_SERIES);
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    size_t size = static_cast<size_t>(std::max(0, sc.ArraySize));
+    
+    series.open.resize(size);
+    series.high.resize(size);
+    series.low.resize(size);
+    series.close.resize(size);
+    
+    // Bars before startIndex are unchanged since the last call; the forming bar is always re-converted
+    for (int i = std::max(0, startIndex); i < sc.ArraySize; i++)
+    {
+        series.open[i] = PriceToTicks(instrument, sc.Open[i]);
+        series.high[i] = PriceToTicks(instrument, sc.High[i]);
+        series.low[i] = PriceToTicks(instrument, sc.Low[i]);
+        series.close[i] = PriceToTicks(instrument, sc.Close[i]);
+    }
+}
+
+const TickPriceSeries& GetTickPriceSeries(SCStudyInterfaceRef sc)
+{
+    TickPriceSeries* series = (TickPriceSeries*)sc.GetPersistentPointer(8);
+    if (!series)
+    {
+        static TickPriceSeries emptySeries;
+        return emptySeries;
+    }
+    
+    return *series;
+}
+
+int GetIndexOfHighestTick(const std::vector<int32_t>& values, int startIndex, int endIndex)
+{
+    startIndex = std::max(0, startIndex);
+    endIndex = std::min(endIndex, static_cast<int>(values.size()) - 1);
+    if (endIndex < startIndex) return -1;
+    
+    int bestIndex = startIndex;
+    for (int i = startIndex + 1; i <= endIndex; i++)
+    {
+        if (values[i] > values[bestIndex]) bestIndex = i;
+    }
+    
+    return bestIndex;
+}
+
+int GetIndexOfLowestTick(const std::vector<int32_t>& values, int startIndex, int endIndex)
+{
+    startIndex = std::max(0, startIndex);
+    endIndex = std::min(endIndex, static_cast<int>(values.size()) - 1);
+    if (endIndex < startIndex) return -1;
+    
+    int bestIndex = startIndex;
+    for (int i = startIndex + 1; i <= endIndex; i++)
+    {
+        if (values[i] < values[bestIndex]) bestIndex = i;
+    }
+    
+    return bestIndex;
+}
+
+// ===============================================================================
+// LEVEL TOUCH HISTORY IMPLEMENTATION
+// ===============================================================================
+
+void ResetLevelTouches(LevelTouchIndex& touches)
+{
+    touches.levels.clear();
+    touches.baseTick = 0;
+    touches.nextBar = 0;
+}
+
+// Grows the index to cover [lowTick, highTick] with margin; false for a range it cannot hold
+static bool CoverTouchLevels(LevelTouchIndex& touches, int lowTick, int highTick)
+{
+    int size = static_cast<int>(touches.levels.size());
+    if (size > 0 && lowTick >= touches.baseTick && highTick < touches.baseTick + size) return true;
+    if (highTick - lowTick + 1 + 2 * kLevelTouchMargin > kLevelTouchMaxLevels) return false;
+
+    int first = lowTick - kLevelTouchMargin;
+    int last = highTick + kLevelTouchMargin;
+    if (size > 0)
+    {
+        first = std::min(first, touches.baseTick);
+        last = std::max(last, touches.baseTick + size - 1);
+        if (last - first + 1 > kLevelTouchMaxLevels)
+        {
+            // Price moved far from the old levels; they are dropped
+            first = lowTick - kLevelTouchMargin;
+            last = highTick + kLevelTouchMargin;
+            size = 0;
+        }
+    }
+
+    std::vector<LevelTouches> grown(last - first + 1, LevelTouches{});
+    if (size > 0)
+        std::copy(touches.levels.begin(), touches.levels.end(), grown.begin() + (touches.baseTick - first));
+    touches.levels.swap(grown);
+    touches.baseTick = first;
+    return true;
+}
+
+// One closed bar: every level in its range gets a touch with the bar's outcome there
+void RecordBarTouches(LevelTouchIndex& touches, const TickPriceSeries& ticks, float volume, int bar)
+{
+    int low = ticks.low[bar];
+    int high = ticks.high[bar];
+    if (high < low || !CoverTouchLevels(touches, low, high)) return;
+
+    int open = ticks.open[bar];
+    int close = ticks.close[bar];
+    for (int level = low; level <= high; level++)
+    {
+        uint8_t outcome = TOUCH_TRADED;
+        if ((open < level && close > level) || (open > level && close < level)) outcome = TOUCH_BROKEN;
+        else if ((open < level && close < level) || (open > level && close > level)) outcome = TOUCH_REJECTED;
+
+        LevelTouches& entry = touches.levels[level - touches.baseTick];
+        entry.bar[entry.head] = bar;
+        entry.breakVolume[entry.head] = outcome == TOUCH_BROKEN ? volume : 0.0f;
+        entry.outcome[entry.head] = outcome;
+        entry.head = static_cast<uint8_t>((entry.head + 1) % kLevelTouchDepth);
+        if (entry.count < kLevelTouchDepth) entry.count++;
+    }
+}
+
+// The index through the bar before index, or nullptr when the history is off or already
+// past index (older bars evaluated later, as lazy history does, get no touch weighting)
+const LevelTouchIndex* GetLevelTouches(SCStudyInterfaceRef sc, int index)
+{
+    LevelTouchIndex* touches = (LevelTouchIndex*)sc.GetPersistentPointer(17);
+    if (!touches || GetStrategyParameters(sc).touchHistoryWeight <= 0.0f || touches->nextBar > index)
+        return nullptr;
+
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int last = std::min(index, static_cast<int>(ticks.low.size()));
+    for (; touches->nextBar < last; touches->nextBar++)
+        RecordBarTouches(*touches, ticks, sc.Volume[touches->nextBar], touches->nextBar);
+    return touches;
+}
+
+TouchSummary SummarizeTouches(const LevelTouchIndex& touches, int levelTicks, int index, int memoryBars)
+{
+    TouchSummary summary = {0, 0, 0, 0.0f};
+    int offset = levelTicks - touches.baseTick;
+    if (offset < 0 || offset >= static_cast<int>(touches.levels.size())) return summary;
+
+    // Newest first, so the first break seen is the latest one
+    const LevelTouches& entry = touches.levels[offset];
+    for (int t = 1; t <= entry.count; t++)
+    {
+        int slot = (entry.head - t + kLevelTouchDepth) % kLevelTouchDepth;
+        if (index - entry.bar[slot] > memoryBars) break;
+        summary.touches++;
+        if (entry.outcome[slot] == TOUCH_REJECTED) summary.rejections++;
+        else if (entry.outcome[slot] == TOUCH_BROKEN)
+        {
+            if (summary.breaks++ == 0) summary.lastBreakVolume = entry.breakVolume[slot];
+        }
+    }
+    return summary;
+}
+
+// A signal that expects the level to hold (rejection) gains on a fresh level and on prior
+// holds, and loses on prior breaks; a breakout gains on a fresh level and on more volume than
+// the last break, and loses on prior holds
+float ApplyTouchHistory(SCStudyInterfaceRef sc, int index, int levelTicks, bool holdSignal, float confidence)
+{
+    const LevelTouchIndex* touches = GetLevelTouches(sc, index);
+    if (!touches) return confidence;
+
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    TouchSummary history = SummarizeTouches(*touches, levelTicks, index, params.touchMemoryBars);
+    float weight = params.touchHistoryWeight;
+    float adjustment = 0.0f;
+    if (history.touches == 0)
+        adjustment = weight;
+    else if (holdSignal)
+        adjustment = weight * std::min(history.rejections, 2) - 2.0f * weight * history.breaks;
+    else
+    {
+        adjustment = -weight * history.rejections;
+        if (history.lastBreakVolume > 0.0f && sc.Volume[index] > history.lastBreakVolume) adjustment += weight;
+    }
+    return std::max(0.0f, std::min(1.0f, confidence + adjustment));
+}
+
+// ===============================================================================
+// REFERENCE LEVEL IMPLEMENTATION
+// ===============================================================================
+
+inline int LowestSetBit(uint64_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long position;
+    _BitScanForward64(&position, bits);
+    return static_cast<int>(position);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+inline int HighestSetBit(uint64_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long position;
+    _BitScanReverse64(&position, bits);
+    return static_cast<int>(position);
+#else
+    return 63 - __builtin_clzll(bits);
+#endif
+}
+
+void ResetReferenceLevels(ReferenceLevels& levels)
+{
+    levels = ReferenceLevels();
+}
+
+// One closed bar. A session ends when a bar falls outside regular hours or on a new date while
+// still inside them (charts without overnight bars); its high, low and last close become the
+// prior-day levels. The overnight range becomes a level when the next session opens.
+void RecordReferenceBar(SCStudyInterfaceRef sc, ReferenceLevels& levels, const TickPriceSeries& ticks, int bar)
+{
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    int time = sc.BaseDateTimeIn[bar].GetTime();
+    int date = sc.BaseDateTimeIn[bar].GetDate();
+    bool inSession = time >= instrument.sessionOpen && time < instrument.sessionClose;
+
+    if (levels.inSession && (!inSession || date != levels.sessionDate))
+    {
+        levels.level[REFERENCE_PRIOR_HIGH] = levels.dayHigh;
+        levels.level[REFERENCE_PRIOR_LOW] = levels.dayLow;
+        levels.level[REFERENCE_SETTLEMENT] = levels.dayClose;
+        levels.inSession = false;
+        levels.hasOvernight = false;
+        levels.dirty = true;
+    }
+
+    if (inSession)
+    {
+        if (!levels.inSession)
+        {
+            if (levels.hasOvernight)
+            {
+                levels.level[REFERENCE_OVERNIGHT_HIGH] = levels.overnightHigh;
+                levels.level[REFERENCE_OVERNIGHT_LOW] = levels.overnightLow;
+                levels.hasOvernight = false;
+            }
+            levels.level[REFERENCE_SESSION_OPEN] = ticks.open[bar];
+            levels.inSession = true;
+            levels.sessionDate = date;
+            levels.dayHigh = ticks.high[bar];
+            levels.dayLow = ticks.low[bar];
+            levels.dirty = true;
+        }
+        levels.dayHigh = std::max(levels.dayHigh, ticks.high[bar]);
+        levels.dayLow = std::min(levels.dayLow, ticks.low[bar]);
+        levels.dayClose = ticks.close[bar];
+    }
+    else if (!levels.hasOvernight)
+    {
+        levels.hasOvernight = true;
+        levels.overnightHigh = ticks.high[bar];
+        levels.overnightLow = ticks.low[bar];
+    }
+    else
+    {
+        levels.overnightHigh = std::max(levels.overnightHigh, ticks.high[bar]);
+        levels.overnightLow = std::min(levels.overnightLow, ticks.low[bar]);
+    }
+}
+
+// Session levels and round numbers in a window centred on centerTicks
+static void BuildReferenceBitmap(ReferenceLevels& levels, int centerTicks, int roundStepTicks)
+{
+    std::memset(levels.bits, 0, sizeof(levels.bits));
+    levels.baseTick = centerTicks - kReferenceWindowTicks / 2;
+    levels.roundStepTicks = roundStepTicks;
+    levels.dirty = false;
+
+    int end = levels.baseTick + kReferenceWindowTicks;
+    if (roundStepTicks > 0)
+    {
+        int first = levels.baseTick + ((roundStepTicks - levels.baseTick % roundStepTicks) % roundStepTicks);
+        for (int tick = first; tick < end; tick += roundStepTicks)
+        {
+            int bit = tick - levels.baseTick;
+            levels.bits[bit >> 6] |= uint64_t(1) << (bit & 63);
+        }
+    }
+    for (int kind = 0; kind < kReferenceLevelKinds; kind++)
+    {
+        int tick = levels.level[kind];
+        if (tick == kNoReferenceLevel || tick < levels.baseTick || tick >= end) continue;
+        int bit = tick - levels.baseTick;
+        levels.bits[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+}
+
+// Levels from the closed bars before index, the bitmap covering its close; nullptr when the
+// service is off or already past index (older bars evaluated later by lazy history)
+const ReferenceLevels* GetReferenceLevels(SCStudyInterfaceRef sc, int index)
+{
+    ReferenceLevels* levels = (ReferenceLevels*)sc.GetPersistentPointer(18);
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    if (!levels || params.referenceLevelWeight <= 0.0f || levels->nextBar > index) return nullptr;
+
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    if (index >= static_cast<int>(ticks.close.size())) return nullptr;
+    for (; levels->nextBar < index; levels->nextBar++)
+        RecordReferenceBar(sc, *levels, ticks, levels->nextBar);
+
+    // Rebuilt when a session changed the levels, the round step changed, or price nears the edge
+    int offset = ticks.close[index] - levels->baseTick;
+    if (levels->dirty || levels->roundStepTicks != params.roundNumberTicks ||
+        offset < kReferenceWindowTicks / 4 || offset >= kReferenceWindowTicks * 3 / 4)
+        BuildReferenceBitmap(*levels, ticks.close[index], params.roundNumberTicks);
+    return levels;
+}
+
+// Nearest reference level to priceTicks, up or down, no more than withinTicks away; the lower
+// one on ties. Two masked word scans unless the window has to be walked across words.
+bool FindNearestReferenceLevel(const ReferenceLevels& levels, int priceTicks, int withinTicks, int& levelTicks)
+{
+    int position = priceTicks - levels.baseTick;
+    int lowest = std::max(0, position - withinTicks);
+    int highest = std::min(kReferenceWindowTicks - 1, position + withinTicks);
+    if (lowest > highest) return false;
+
+    int above = -1;
+    int start = std::max(position, lowest);
+    for (int word = start >> 6; word <= highest >> 6 && start <= highest; word++)
+    {
+        uint64_t bits = levels.bits[word];
+        if (word == start >> 6) bits &= ~uint64_t(0) << (start & 63);
+        if (bits)
+        {
+            int bit = (word << 6) + LowestSetBit(bits);
+            if (bit <= highest) above = bit;
+            break;
+        }
+    }
+
+    int below = -1;
+    int stop = std::min(position, highest);
+    for (int word = stop >> 6; word >= lowest >> 6 && stop >= lowest; word--)
+    {
+        uint64_t bits = levels.bits[word];
+        if (word == stop >> 6) bits &= (uint64_t(2) << (stop & 63)) - 1;
+        if (bits)
+        {
+            int bit = (word << 6) + HighestSetBit(bits);
+            if (bit >= lowest) below = bit;
+            break;
+        }
+    }
+
+    if (above < 0 && below < 0) return false;
+    int nearest = below;
+    if (below < 0 || (above >= 0 && above - position < position - below)) nearest = above;
+    levelTicks = levels.baseTick + nearest;
+    return true;
+}
+
+// Stops rest at reference levels; a signal whose level sits near one gains the weight
+float ApplyReferenceLevel(SCStudyInterfaceRef sc, int index, int levelTicks, float confidence)
 {
-    // Basic validation checks
-    if (signal.direction == 0) return false;
-    if (signal.confidence < 0.5f) return false;
-    if (signal.entryPrice <= 0) return false;
-    if (signal.stopLoss <= 0) return false;
-    if (signal.target <= 0) return false;
-    
-    // Check if stop loss is in correct direction
-    if (signal.direction == 1 && signal.stopLoss >= signal.entryPrice) return false;
-    if (signal.direction == -1 && signal.stopLoss <= signal.entryPrice) return false;
-    
-    // Check if target is in correct direction
-    if (signal.direction == 1 && signal.target <= signal.entryPrice) return false;
-    if (signal.direction == -1 && signal.target >= signal.entryPrice) return false;
-    
-    // Check risk-reward ratio (minimum 1:1.5)
-    float risk = std::abs(signal.entryPrice - signal.stopLoss);
-    float reward = std::abs(signal.target - signal.entryPrice);
-    if (reward / risk < 1.5f) return false;
-    
-    // Check portfolio heat limits
-    RiskMetrics* riskMetrics = (RiskMetrics*)sc.GetPersistentPointer(3);
-    if (riskMetrics && riskMetrics->portfolioHeat > sc.Input[13].GetFloat()) return false;
-    
-    return true;
+    const ReferenceLevels* levels = GetReferenceLevels(sc, index);
+    if (!levels) return confidence;
+
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    int reference = 0;
+    if (!FindNearestReferenceLevel(*levels, levelTicks, params.referenceProximityTicks, reference)) return confidence;
+    return std::min(1.0f, confidence + params.referenceLevelWeight);
 }
 
-void LogTrade(SCStudyInterfaceRef sc, const TradeSignal& signal, const std::string& action)
+// ===============================================================================
+// PARAMETER PROFILE IMPLEMENTATION
+// ===============================================================================
+//
+// Profile files are plain INI. Sections are applied in this order, later ones winning:
+//   [*]          every instrument
+//   [*:trend]    every instrument, selected regime
+//   [ES]         symbol root (ESZ25 -> ES, MNQH6 -> MNQ)
+//   [ES:trend]   symbol root and selected regime
+// Keys are the StrategyParameters fields in snake_case, e.g.
+//   absorption_volume_threshold = 250
+//   level_proximity_ticks = 3
+
+enum ProfileValueType { PROFILE_INT, PROFILE_FLOAT };
+
+// minValue/maxValue repeat the study input's SetIntLimits/SetFloatLimits, so a profile can
+// never set what the input dialog would refuse
+struct ProfileKey {
+    const char* key;
+    ProfileValueType type;
+    size_t offset;
+    double minValue;
+    double maxValue;
+};
+
+static const ProfileKey s_ProfileKeys[] = {
+    {"trade_quantity",                PROFILE_INT,   offsetof(StrategyParameters, tradeQuantity),               1, 100},
+    {"max_daily_trades",              PROFILE_INT,   offsetof(StrategyParameters, maxDailyTrades),              1, 100},
+    {"max_daily_loss",                PROFILE_FLOAT, offsetof(StrategyParameters, maxDailyLoss),                100.0f, 10000.0f},
+    {"daily_profit_target",           PROFILE_FLOAT, offsetof(StrategyParameters, dailyProfitTarget),           100.0f, 20000.0f},
+    {"max_portfolio_heat",            PROFILE_FLOAT, offsetof(StrategyParameters, maxPortfolioHeat),            0.5f, 10.0f},
+    {"position_risk_percent",         PROFILE_FLOAT, offsetof(StrategyParameters, positionRiskPercent),         0.1f, 5.0f},
+    {"absorption_volume_threshold",   PROFILE_INT,   offsetof(StrategyParameters, absorptionVolumeThreshold),   10, 1000},
+    {"absorption_stall_ticks",        PROFILE_INT,   offsetof(StrategyParameters, absorptionStallTicks),        1, 10},
+    {"absorption_confirmation_bars",  PROFILE_INT,   offsetof(StrategyParameters, absorptionConfirmationBars),  1, 5},
+    {"footprint_feature_weight",      PROFILE_FLOAT, offsetof(StrategyParameters, footprintFeatureWeight),      0.0f, 0.2f},
+    {"exhaustion_volume_ratio",       PROFILE_FLOAT, offsetof(StrategyParameters, exhaustionVolumeRatio),       0.01f, 1.0f},
+    {"iceberg_min_hit_volume",        PROFILE_INT,   offsetof(StrategyParameters, icebergMinHitVolume),         10, 500},
+    {"iceberg_detection_bars",        PROFILE_INT,   offsetof(StrategyParameters, icebergDetectionBars),        3, 20},
+    {"iceberg_tolerance_ticks",       PROFILE_INT,   offsetof(StrategyParameters, icebergToleranceTicks),       0, 3},
+    {"iceberg_clip_window_seconds",   PROFILE_INT,   offsetof(StrategyParameters, icebergClipWindowSeconds),    1, 600},
+    {"iceberg_min_clip_repeats",      PROFILE_INT,   offsetof(StrategyParameters, icebergMinClipRepeats),       2, 50},
+    {"iceberg_clip_boost",            PROFILE_FLOAT, offsetof(StrategyParameters, icebergClipBoost),            0.0f, 0.4f},
+    {"delta_ma_period",               PROFILE_INT,   offsetof(StrategyParameters, deltaMAPeriod),               5, 100},
+    {"divergence_lookback",           PROFILE_INT,   offsetof(StrategyParameters, divergenceLookback),          10, 50},
+    {"delta_exhaustion_threshold",    PROFILE_FLOAT, offsetof(StrategyParameters, deltaExhaustionThreshold),    1.0f, 5.0f},
+    {"hvn_multiplier",                PROFILE_FLOAT, offsetof(StrategyParameters, hvnMultiplier),               1.2f, 5.0f},
+    {"lvn_multiplier",                PROFILE_FLOAT, offsetof(StrategyParameters, lvnMultiplier),               0.1f, 0.8f},
+    {"profile_lookback_bars",         PROFILE_INT,   offsetof(StrategyParameters, profileLookbackBars),         100, 2000},
+    {"level_proximity_ticks",         PROFILE_INT,   offsetof(StrategyParameters, levelProximityTicks),         1, 10},
+    {"touch_history_weight",          PROFILE_FLOAT, offsetof(StrategyParameters, touchHistoryWeight),          0.0f, 0.2f},
+    {"touch_memory_bars",             PROFILE_INT,   offsetof(StrategyParameters, touchMemoryBars),             10, 10000},
+    {"breakout_volume_multiplier",    PROFILE_FLOAT, offsetof(StrategyParameters, breakoutVolumeMultiplier),    1.1f, 3.0f},
+    {"breakout_lookback",             PROFILE_INT,   offsetof(StrategyParameters, breakoutLookback),            10, 50},
+    {"momentum_confirmation_bars",    PROFILE_INT,   offsetof(StrategyParameters, momentumConfirmationBars),    2, 10},
+    {"reference_level_weight",        PROFILE_FLOAT, offsetof(StrategyParameters, referenceLevelWeight),        0.0f, 0.2f},
+    {"reference_proximity_ticks",     PROFILE_INT,   offsetof(StrategyParameters, referenceProximityTicks),     0, 20},
+    {"round_number_ticks",            PROFILE_INT,   offsetof(StrategyParameters, roundNumberTicks),            0, 10000},
+    {"book_depth_levels",             PROFILE_INT,   offsetof(StrategyParameters, bookDepthLevels),             1, kMaxDepthLevels},
+    {"min_book_imbalance",            PROFILE_FLOAT, offsetof(StrategyParameters, minBookImbalance),            0.0f, 1.0f},
+    {"vpin_bucket_volume",            PROFILE_INT,   offsetof(StrategyParameters, vpinBucketVolume),            10, 1000000},
+    {"vpin_window_buckets",           PROFILE_INT,   offsetof(StrategyParameters, vpinWindowBuckets),           5, kMaxVpinBuckets},
+    {"max_fade_vpin",                 PROFILE_FLOAT, offsetof(StrategyParameters, maxFadeVpin),                 0.05f, 1.0f},
+    {"canonical_bar_type",            PROFILE_INT,   offsetof(StrategyParameters, canonicalBarType),            0, 2},
+    {"canonical_volume_bar_size",     PROFILE_INT,   offsetof(StrategyParameters, canonicalVolumeBarSize),      1, 1000000},
+    {"canonical_range_bar_ticks",     PROFILE_INT,   offsetof(StrategyParameters, canonicalRangeBarTicks),      1, 10000},
+    {"breaker_max_consecutive_losses", PROFILE_INT,  offsetof(StrategyParameters, breakerMaxConsecutiveLosses), 0, 50},
+    {"breaker_max_drawdown",          PROFILE_FLOAT, offsetof(StrategyParameters, breakerMaxDrawdown),          0.0f, 10000.0f},
+    {"breaker_max_error_percent",     PROFILE_FLOAT, offsetof(StrategyParameters, breakerMaxErrorPercent),      0.0f, 100.0f},
+    {"breaker_max_slippage_ticks",    PROFILE_INT,   offsetof(StrategyParameters, breakerMaxSlippageTicks),     0, 100},
+    {"stale_silence_seconds",         PROFILE_FLOAT, offsetof(StrategyParameters, staleSilenceSeconds),         0.0f, 3600.0f},
+    {"stale_lag_seconds",             PROFILE_FLOAT, offsetof(StrategyParameters, staleLagSeconds),             0.0f, 3600.0f},
+};
+
+static std::string TrimProfileToken(const std::string& text)
 {
-    if (!sc.Input[4].GetYesNo()) return; // Detailed logging disabled
-    
-    SCString logMsg;
-    logMsg.Format("%s - %s: %s | Entry: %.2f | Stop: %.2f | Target: %.2f | Confidence: %.2f | Reason: %s",
-                  action.c_str(),
-                  signal.strategy.c_str(),
-                  (signal.direction == 1) ? "LONG" : "SHORT",
-                  signal.entryPrice,
-                  signal.stopLoss,
-                  signal.target,
-                  signal.confidence,
-                  signal.reason.c_str());
-    
-    sc.AddMessageToLog(logMsg, 0);
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
 }
 
-bool IsWithinTradingHours(SCStudyInterfaceRef sc)
+static std::string LowerProfileToken(std::string text)
 {
-    SCDateTime currentTime = sc.BaseDateTimeIn[sc.Index];
-    SCDateTime tradingStart = sc.Input[21].GetTime();
-    SCDateTime tradingEnd = sc.Input[22].GetTime();
-    
-    // Check if within trading hours
-    bool withinTradingHours = (currentTime.GetTime() >= tradingStart.GetTime() && 
-                              currentTime.GetTime() <= tradingEnd.GetTime());
-    
-    if (!withinTradingHours || !sc.Input[1].GetYesNo()) return false;
-    
-    // Avoid trading near market open/close
-    SCDateTime marketOpen = HMS_TIME(9, 30, 0);
-    SCDateTime marketClose = HMS_TIME(16, 0, 0);
-    
-    bool avoidOpenTime = (currentTime.GetTime() < (marketOpen.GetTime() + sc.Input[24].GetInt() * 60));
-    bool avoidCloseTime = (currentTime.GetTime() > (marketClose.GetTime() - sc.Input[25].GetInt() * 60));
-    
-    return !(avoidOpenTime || avoidCloseTime);
+    for (char& c : text)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
 }
 
-float CalculateVolatility(SCStudyInterfaceRef sc, int lookback)
+std::string GetSymbolRoot(const char* symbol)
 {
-    if (sc.Index < lookback) return 0.0f;
-    
-    std::vector<float> returns;
-    for (int i = sc.Index - lookback + 1; i <= sc.Index; i++)
+    // Leading product code, minus the contract month letter: ESZ25 -> ES, 6EZ5 -> 6E, CLF26-NYMEX -> CL
+    std::string root;
+    if (!symbol) return root;
+
+    size_t pos = 0;
+    while (symbol[pos] != '\0' && (std::isalpha(static_cast<unsigned char>(symbol[pos])) ||
+                                   (pos == 0 && std::isdigit(static_cast<unsigned char>(symbol[pos])))))
     {
-        if (i > 0 && sc.Close[i-1] > 0)
-        {
-            float return_val = (sc.Close[i] - sc.Close[i-1]) / sc.Close[i-1];
-            returns.push_back(return_val);
-        }
+        root += static_cast<char>(std::toupper(static_cast<unsigned char>(symbol[pos])));
+        pos++;
     }
-    
-    if (returns.empty()) return 0.0f;
-    
-    // Calculate standard deviation
-    float mean = std::accumulate(returns.begin(), returns.end(), 0.0f) / returns.size();
-    float variance = 0.0f;
-    
-    for (float ret : returns)
+
+    static const char* monthCodes = "FGHJKMNQUVXZ";
+    if (root.size() > 1 && std::isdigit(static_cast<unsigned char>(symbol[pos])) &&
+        std::strchr(monthCodes, root.back()) != nullptr)
     {
-        variance += (ret - mean) * (ret - mean);
+        root.pop_back();
     }
-    variance /= returns.size();
     
-    return std::sqrt(variance);
+    return root;
+}
+
+void LoadParametersFromInputs(SCStudyInterfaceRef sc, StrategyParameters& params)
+{
+    params.tradeQuantity = sc.Input[2].GetInt();
+    params.maxDailyTrades = sc.Input[3].GetInt();
+    params.maxDailyLoss = sc.Input[11].GetFloat();
+    params.dailyProfitTarget = sc.Input[12].GetFloat();
+    params.maxPortfolioHeat = sc.Input[13].GetFloat();
+    params.positionRiskPercent = sc.Input[14].GetFloat();
+
+    params.absorptionVolumeThreshold = sc.Input[51].GetInt();
+    params.absorptionStallTicks = sc.Input[52].GetInt();
+    params.absorptionConfirmationBars = sc.Input[53].GetInt();
+    params.footprintFeatureWeight = sc.Input[54].GetFloat();
+    params.exhaustionVolumeRatio = sc.Input[55].GetFloat();
+
+    params.icebergMinHitVolume = sc.Input[61].GetInt();
+    params.icebergDetectionBars = sc.Input[62].GetInt();
+    params.icebergToleranceTicks = sc.Input[63].GetInt();
+    params.icebergClipWindowSeconds = sc.Input[64].GetInt();
+    params.icebergMinClipRepeats = sc.Input[65].GetInt();
+    params.icebergClipBoost = sc.Input[66].GetFloat();
+
+    params.deltaMAPeriod = sc.Input[71].GetInt();
+    params.divergenceLookback = sc.Input[72].GetInt();
+    params.deltaExhaustionThreshold = sc.Input[73].GetFloat();
+
+    params.hvnMultiplier = sc.Input[81].GetFloat();
+    params.lvnMultiplier = sc.Input[82].GetFloat();
+    params.profileLookbackBars = sc.Input[83].GetInt();
+    params.levelProximityTicks = sc.Input[84].GetInt();
+    params.touchHistoryWeight = sc.Input[85].GetFloat();
+    params.touchMemoryBars = sc.Input[86].GetInt();
+
+    params.breakoutVolumeMultiplier = sc.Input[91].GetFloat();
+    params.breakoutLookback = sc.Input[92].GetInt();
+    params.momentumConfirmationBars = sc.Input[93].GetInt();
+    params.referenceLevelWeight = sc.Input[94].GetFloat();
+    params.referenceProximityTicks = sc.Input[95].GetInt();
+    params.roundNumberTicks = sc.Input[96].GetInt();
+
+    params.bookDepthLevels = sc.Input[43].GetInt();
+    params.minBookImbalance = sc.Input[44].GetFloat();
+
+    params.vpinBucketVolume = sc.Input[47].GetInt();
+    params.vpinWindowBuckets = sc.Input[48].GetInt();
+    params.maxFadeVpin = sc.Input[49].GetFloat();
+
+    params.canonicalBarType = sc.Input[105].GetIndex();
+    params.canonicalVolumeBarSize = sc.Input[106].GetInt();
+    params.canonicalRangeBarTicks = sc.Input[107].GetInt();
+
+    params.breakerMaxConsecutiveLosses = sc.Input[16].GetInt();
+    params.breakerMaxDrawdown = sc.Input[17].GetFloat();
+    params.breakerMaxErrorPercent = sc.Input[18].GetFloat();
+    params.breakerMaxSlippageTicks = sc.Input[19].GetInt();
+
+    params.staleSilenceSeconds = sc.Input[116].GetFloat();
+    params.staleLagSeconds = sc.Input[117].GetFloat();
 }
 
-std::vector<float> FindSwingPoints(SCStudyInterfaceRef sc, int lookback, bool findHighs)
+bool ApplyParameterProfile(SCStudyInterfaceRef sc, const std::string& path, const std::string& symbolRoot,
+                           const char* regime, StrategyParameters& params)
 {
-    std::vector<float> swingPoints;
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        SCString logMsg;
+        logMsg.Format("PARAMETER PROFILE: cannot open %s", path.c_str());
+        LogMessage(sc, logMsg, 1);
+        return false;
+    }
+
+    std::string rootKey = LowerProfileToken(symbolRoot);
+    std::string regimeKey = LowerProfileToken(regime);
+    const std::string sections[4] = {"*", "*:" + regimeKey, rootKey, rootKey + ":" + regimeKey};
+    std::vector<std::pair<std::string, std::string>> sectionValues[4];
+
+    // Collect the applicable key/value pairs first; nothing is written to params
+    // unless the whole file parses, so a half-edited profile is never applied.
+    bool isValid = true;
+    int currentSection = -1;
+    int lineNumber = 0;
+    std::string line;
+    SCString logMsg;
     
-    for (int i = lookback; i <= sc.Index - lookback; i++)
+    while (std::getline(file, line))
     {
-        bool isSwingPoint = true;
-        float currentValue = findHighs ? sc.High[i] : sc.Low[i];
+        lineNumber++;
+        std::string text = TrimProfileToken(line.substr(0, line.find_first_of(";#")));
+        if (text.empty()) continue;
+
+        if (text.front() == '[')
+        {
+            currentSection = -1;
+            if (text.back() != ']')
+            {
+                logMsg.Format("PARAMETER PROFILE: malformed section at %s:%d", path.c_str(), lineNumber);
+                LogMessage(sc, logMsg, 1);
+                isValid = false;
+                continue;
+            }
+            
+            std::string name = LowerProfileToken(TrimProfileToken(text.substr(1, text.size() - 2)));
+            for (int k = 0; k < 4; k++)
+            {
+                if (name == sections[k]) currentSection = k;
+            }
+            continue;
+        }
+
+        size_t separator = text.find('=');
+        if (separator == std::string::npos)
+        {
+            logMsg.Format("PARAMETER PROFILE: expected key = value at %s:%d", path.c_str(), lineNumber);
+            LogMessage(sc, logMsg, 1);
+            isValid = false;
+            continue;
+        }
+
+        if (currentSection < 0) continue; // Section for another instrument or regime
         
-        // Check if current point is higher/lower than surrounding points
-        for (int j = i - lookback; j <= i + lookback; j++)
+        sectionValues[currentSection].emplace_back(LowerProfileToken(TrimProfileToken(text.substr(0, separator))),
+                                                   TrimProfileToken(text.substr(separator + 1)));
+    }
+
+    StrategyParameters resolved = params;
+    for (const auto& values : sectionValues)
+    {
+        for (const auto& entry : values)
         {
-            if (j == i) continue;
+            const ProfileKey* profileKey = nullptr;
+            for (const ProfileKey& candidate : s_ProfileKeys)
+            {
+                if (entry.first == candidate.key) profileKey = &candidate;
+            }
             
-            float compareValue = findHighs ? sc.High[j] : sc.Low[j];
+            if (!profileKey)
+            {
+                logMsg.Format("PARAMETER PROFILE: unknown key '%s'", entry.first.c_str());
+                LogMessage(sc, logMsg, 1);
+                isValid = false;
+                continue;
+            }
+
+            const char* valueText = entry.second.c_str();
+            char* valueEnd = nullptr;
+            char* field = reinterpret_cast<char*>(&resolved) + profileKey->offset;
             
-            if (findHighs && compareValue >= currentValue)
+            double value = 0.0;
+            if (profileKey->type == PROFILE_INT)
+                value = static_cast<double>(std::strtol(valueText, &valueEnd, 10));
+            else
+                value = static_cast<double>(std::strtof(valueText, &valueEnd));
+
+            if (valueEnd == valueText || *valueEnd != '\0')
             {
-                isSwingPoint = false;
-                break;
+                logMsg.Format("PARAMETER PROFILE: invalid value '%s' for %s", valueText, profileKey->key);
+                LogMessage(sc, logMsg, 1);
+                isValid = false;
+                continue;
             }
-            else if (!findHighs && compareValue <= currentValue)
+
+            // Out-of-range values (and strtol's LONG_MIN/LONG_MAX on overflow) reject the file
+            if (!(value >= profileKey->minValue && value <= profileKey->maxValue))
             {
-                isSwingPoint = false;
-                break;
+                logMsg.Format("PARAMETER PROFILE: %s = %s is outside %g to %g", profileKey->key, valueText,
+                              profileKey->minValue, profileKey->maxValue);
+                LogMessage(sc, logMsg, 1);
+                isValid = false;
+                continue;
             }
+
+            if (profileKey->type == PROFILE_INT)
+                *reinterpret_cast<int*>(field) = static_cast<int>(value);
+            else
+                *reinterpret_cast<float*>(field) = static_cast<float>(value);
         }
-        
-        if (isSwingPoint)
+    }
+
+    if (isValid) params = resolved;
+    return isValid;
+}
+
+void RefreshParameterProfile(SCStudyInterfaceRef sc, bool forceRebuild)
+{
+    AOFB_PROBE(PROBE_PARAMETERS);
+    ParameterProfileStore* store = (ParameterProfileStore*)sc.GetPersistentPointer(6);
+    if (!store) return;
+
+    std::string path = sc.Input[101].GetPathAndFileName();
+    bool hasActive = store->active.load(std::memory_order_acquire) != nullptr;
+    bool rebuild = forceRebuild || !hasActive || path != store->loadedPath;
+    long long writeTime = store->loadedWriteTime;
+
+    // Hot reload: poll the file timestamp at most once a second
+    if (!rebuild && !path.empty() && sc.Input[103].GetYesNo())
+    {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - store->lastCheck >= std::chrono::seconds(1))
         {
-            swingPoints.push_back(currentValue);
+            store->lastCheck = now;
+            std::error_code error;
+            std::filesystem::file_time_type fileTime = std::filesystem::last_write_time(path, error);
+            if (!error)
+            {
+                writeTime = static_cast<long long>(fileTime.time_since_epoch().count());
+                rebuild = (writeTime != store->loadedWriteTime);
+            }
         }
     }
     
-    return swingPoints;
+    if (!rebuild) return;
+
+    int nextSlot = hasActive ? 1 - store->activeSlot : store->activeSlot;
+    StrategyParameters& next = store->slots[nextSlot];
+    LoadParametersFromInputs(sc, next);
+    store->symbolRoot = GetSymbolRoot(sc.Symbol.GetChars());
+
+    if (!path.empty())
+    {
+        std::error_code error;
+        std::filesystem::file_time_type fileTime = std::filesystem::last_write_time(path, error);
+        writeTime = error ? 0 : static_cast<long long>(fileTime.time_since_epoch().count());
+
+        static const char* regimeNames[] = {"default", "trend", "range", "volatile"};
+        int regimeIndex = std::max(0, std::min(3, sc.Input[102].GetIndex()));
+
+        if (ApplyParameterProfile(sc, path, store->symbolRoot, regimeNames[regimeIndex], next))
+        {
+            SCString logMsg;
+            logMsg.Format("PARAMETER PROFILE %s: %s [%s:%s]", hasActive && !forceRebuild ? "RELOADED" : "LOADED",
+                          path.c_str(), store->symbolRoot.c_str(), regimeNames[regimeIndex]);
+            LogMessage(sc, logMsg, 0);
+        }
+        else if (hasActive && !forceRebuild)
+        {
+            // Keep trading on the previous parameters until the file is fixed
+            store->loadedWriteTime = writeTime;
+            LogMessage(sc, "PARAMETER PROFILE REJECTED: keeping previous parameters", 1);
+            return;
+        }
+        else
+        {
+            LoadParametersFromInputs(sc, next);
+            LogMessage(sc, "PARAMETER PROFILE REJECTED: using study inputs", 1);
+        }
+    }
+
+    store->loadedPath = path;
+    store->loadedWriteTime = writeTime;
+    store->activeSlot = nextSlot;
+    store->active.store(&next, std::memory_order_release);
+}
+
+const StrategyParameters& GetStrategyParameters(SCStudyInterfaceRef sc)
+{
+    ParameterProfileStore* store = (ParameterProfileStore*)sc.GetPersistentPointer(6);
+    if (!store)
+    {
+        static StrategyParameters fallbackParams;
+        LoadParametersFromInputs(sc, fallbackParams);
+        return fallbackParams;
+    }
+    
+    if (store->active.load(std::memory_order_acquire) == nullptr)
+        RefreshParameterProfile(sc, true);
+    
+    return *store->active.load(std::memory_order_acquire);
 }
 
 // ===============================================================================
-// STRATEGY IMPLEMENTATION FUNCTIONS
+// INSTRUMENT METADATA IMPLEMENTATION
 // ===============================================================================
 
-TradeSignal CheckLiquidityAbsorption(SCStudyInterfaceRef sc, int index)
+struct InstrumentSpec {
+    const char* root;
+    float tickSize;
+    float tickValue;
+    const char* currency;
+    int sessionOpen;
+    int sessionClose;
+};
+
+// Regular trading hours in ET, matching the chart time zone the time inputs assume
+static const InstrumentSpec s_InstrumentSpecs[] = {
+    // Equity index
+    {"ES",  0.25f,       12.50f,  "USD", HMS_TIME(9, 30, 0),  HMS_TIME(16, 0, 0)},
+    {"MES", 0.25f,       1.25f,   "USD", HMS_TIME(9, 30, 0),  HMS_TIME(16, 0, 0)},
+    {"NQ",  0.25f,       5.00f,   "USD", HMS_TIME(9, 30, 0),  HMS_TIME(16, 0, 0)},
+    {"MNQ", 0.25f,       0.50f,   "USD", HMS_TIME(9, 30, 0),  HMS_TIME(16, 0, 0)},
+    {"YM",  1.0f,        5.00f,   "USD", HMS_TIME(9, 30, 0),  HMS_TIME(16, 0, 0)},
+    {"MYM", 1.0f,        0.50f,   "USD", HMS_TIME(9, 30, 0),  HMS_TIME(16, 0, 0)},
+    {"RTY", 0.10f,       5.00f,   "USD", HMS_TIME(9, 30, 0),  HMS_TIME(16, 0, 0)},
+    {"M2K", 0.10f,       0.50f,   "USD", HMS_TIME(9, 30, 0),  HMS_TIME(16, 0, 0)},
+    // Energy
+    {"CL",  0.01f,       10.00f,  "USD", HMS_TIME(9, 0, 0),   HMS_TIME(14, 30, 0)},
+    {"MCL", 0.01f,       1.00f,   "USD", HMS_TIME(9, 0, 0),   HMS_TIME(14, 30, 0)},
+    {"NG",  0.001f,      10.00f,  "USD", HMS_TIME(9, 0, 0),   HMS_TIME(14, 30, 0)},
+    // Metals
+    {"GC",  0.10f,       10.00f,  "USD", HMS_TIME(8, 20, 0),  HMS_TIME(13, 30, 0)},
+    {"MGC", 0.10f,       1.00f,   "USD", HMS_TIME(8, 20, 0),  HMS_TIME(13, 30, 0)},
+    {"SI",  0.005f,      25.00f,  "USD", HMS_TIME(8, 25, 0),  HMS_TIME(13, 25, 0)},
+    {"HG",  0.0005f,     12.50f,  "USD", HMS_TIME(8, 10, 0),  HMS_TIME(13, 0, 0)},
+    // Rates
+    {"ZB",  0.03125f,    31.25f,  "USD", HMS_TIME(8, 20, 0),  HMS_TIME(15, 0, 0)},
+    {"ZN",  0.015625f,   15.625f, "USD", HMS_TIME(8, 20, 0),  HMS_TIME(15, 0, 0)},
+    {"ZF",  0.0078125f,  7.8125f, "USD", HMS_TIME(8, 20, 0),  HMS_TIME(15, 0, 0)},
+    // Currencies
+    {"6E",  0.00005f,    6.25f,   "USD", HMS_TIME(8, 20, 0),  HMS_TIME(15, 0, 0)},
+    {"6J",  0.0000005f,  6.25f,   "USD", HMS_TIME(8, 20, 0),  HMS_TIME(15, 0, 0)},
+    // Grains
+    {"ZC",  0.25f,       12.50f,  "USD", HMS_TIME(9, 30, 0),  HMS_TIME(14, 20, 0)},
+    {"ZS",  0.25f,       12.50f,  "USD", HMS_TIME(9, 30, 0),  HMS_TIME(14, 20, 0)},
+    {"ZW",  0.25f,       12.50f,  "USD", HMS_TIME(9, 30, 0),  HMS_TIME(14, 20, 0)},
+};
+
+void ResolveInstrumentMetadata(SCStudyInterfaceRef sc, InstrumentMetadata& instrument)
+{
+    instrument.root = GetSymbolRoot(sc.Symbol.GetChars());
+    instrument.isKnown = false;
+
+    // Unknown symbols fall back to the chart's own tick settings and the equity session
+    float tickSize = sc.TickSize;
+    float pointValue = (sc.TickSize > 0) ? sc.CurrencyValuePerTick / sc.TickSize : 0.0f;
+    instrument.currency = "USD";
+    instrument.sessionOpen = HMS_TIME(9, 30, 0);
+    instrument.sessionClose = HMS_TIME(16, 0, 0);
+
+    for (const InstrumentSpec& spec : s_InstrumentSpecs)
+    {
+        if (instrument.root != spec.root) continue;
+
+        // The chart's tick size defines the price grid; the contract's point value is fixed,
+        // so the tick value follows whatever tick size the data feed uses.
+        if (tickSize <= 0) tickSize = spec.tickSize;
+        pointValue = spec.tickValue / spec.tickSize;
+        instrument.currency = spec.currency;
+        instrument.sessionOpen = spec.sessionOpen;
+        instrument.sessionClose = spec.sessionClose;
+        instrument.isKnown = true;
+        break;
+    }
+
+    if (tickSize <= 0) tickSize = 0.01f;
+    instrument.tickSize = tickSize;
+    instrument.invTickSize = 1.0 / tickSize;
+    instrument.pointValue = pointValue;
+    instrument.tickValue = pointValue * tickSize;
+
+    if (sc.Input[4].GetYesNo())
+    {
+        SCString logMsg;
+        logMsg.Format("INSTRUMENT: %s%s | Tick: %g | Tick Value: %.4f %s | Session: %02d:%02d-%02d:%02d",
+                      instrument.root.c_str(), instrument.isKnown ? "" : " (chart settings)",
+                      instrument.tickSize, instrument.tickValue, instrument.currency.c_str(),
+                      instrument.sessionOpen / 3600, (instrument.sessionOpen / 60) % 60,
+                      instrument.sessionClose / 3600, (instrument.sessionClose / 60) % 60);
+        LogMessage(sc, logMsg, 0);
+    }
+}
+
+const InstrumentMetadata& GetInstrumentMetadata(SCStudyInterfaceRef sc)
 {
-    TradeSignal signal = {0, 0.0f, "Liquidity Absorption", 0.0f, 0.0f, 0.0f, ""};
+    InstrumentMetadata* instrument = (InstrumentMetadata*)sc.GetPersistentPointer(7);
+    if (!instrument)
+    {
+        static InstrumentMetadata fallbackInstrument;
+        ResolveInstrumentMetadata(sc, fallbackInstrument);
+        return fallbackInstrument;
+    }
     
-    if (index < 5) return signal;
+    if (instrument->tickSize <= 0.0f)
+        ResolveInstrumentMetadata(sc, *instrument);
+    
+    return *instrument;
+}
+
+// ===============================================================================
+// STRATEGY IMPLEMENTATION FUNCTIONS
+// ===============================================================================
+//
+// All price logic below runs in integer ticks (see TickPriceSeries). Prices are only
+// converted back for subgraph plotting, logging and order submission. 1.5R targets
+// round away from entry so they stay on the tick grid and still pass ValidateSignal.
+
+// The signal of every strategy whose bit is set in strategyMask (bit n = input 31+n)
+void CollectStrategySignals(SCStudyInterfaceRef sc, int index, uint32_t strategyMask, SignalColumns& signals)
+{
+    AOFB_PROBE(PROBE_SIGNALS);
+    if (strategyMask & (1u << 0))
+    {
+        TradeSignal signal = CheckLiquidityAbsorption(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 1))
+    {
+        TradeSignal signal = CheckIcebergDetection(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 2))
+    {
+        TradeSignal signal = CheckDeltaDivergence(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 3))
+    {
+        TradeSignal signal = CheckVolumeImbalance(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 4))
+    {
+        TradeSignal signal = CheckStopRunAnticipation(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 5))
+    {
+        TradeSignal signal = CheckHVNRejection(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 6))
+    {
+        TradeSignal signal = CheckLVNBreakout(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 7))
+    {
+        TradeSignal signal = CheckMomentumBreakout(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 8))
+    {
+        TradeSignal signal = CheckCumulativeDeltaTrend(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+    if (strategyMask & (1u << 9))
+    {
+        TradeSignal signal = CheckLiquidityTraps(sc, index);
+        if (signal.direction != 0) signals.Add(signal);
+    }
+}
+
+// Absorption on the strategy bar latest bars back from the newest that closed during chart bar
+// index, confirmed by the bars before it
+static TradeSignal CheckLiquidityAbsorptionBar(SCStudyInterfaceRef sc, int index, int latest)
+{
+    TradeSignal signal = {0, 0.0f, "Liquidity Absorption", 0, 0, 0, ""};
 
-    int volumeThreshold = sc.Input[51].GetInt();
-    int priceStallTicks = sc.Input[52].GetInt();
-    int confirmationBars = sc.Input[53].GetInt();
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    int volumeThreshold = params.absorptionVolumeThreshold;
+    int priceStallTicks = params.absorptionStallTicks;
+    int confirmationBars = params.absorptionConfirmationBars;
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+
+    // Volume thresholds are measured on the strategy bars: the chart's, or canonical ones
+    CanonicalBar bar;
+    if (!GetStrategyBar(sc, index, latest, bar)) return signal;
     
-    float priceStallRange = priceStallTicks * sc.TickSize;
-    float currentHigh = sc.High[index];
-    float currentLow = sc.Low[index];
-    float currentClose = sc.Close[index];
+    int currentHigh = bar.high;
+    int currentLow = bar.low;
+    int currentClose = bar.close;
+    int rangeTicks = currentHigh - currentLow;
+    bool priceStalled = (rangeTicks <= priceStallTicks);
     
     // Check for absorption at current low (potential long setup)
-    if (sc.BidVolume[index] >= volumeThreshold)
+    if (bar.bidVolume >= volumeThreshold)
     {
-        float rangeTicks = (currentHigh - currentLow) / sc.TickSize;
-        bool priceStalled = (rangeTicks <= priceStallTicks);
-        bool closedOffLow = (currentClose > (currentLow + (currentHigh - currentLow) * 0.6f));
+        bool closedOffLow = ((currentClose - currentLow) * 10 > rangeTicks * 6);
         
         if (priceStalled && closedOffLow)
         {
             // Check for confirmation in previous bars
             int confirmationCount = 0;
-            for (int i = 1; i <= confirmationBars && (index - i) >= 0; i++)
+            CanonicalBar prior;
+            for (int i = 1; i <= confirmationBars && GetStrategyBar(sc, index, latest + i, prior); i++)
             {
-                if (sc.BidVolume[index - i] >= volumeThreshold * 0.7f)
+                if (prior.bidVolume >= volumeThreshold * 0.7f)
                     confirmationCount++;
             }
             
@@ -1040,32 +4510,31 @@ TradeSignal CheckLiquidityAbsorption(SCStudyInterfaceRef sc, int index)
             {
                 signal.direction = 1; // Long
                 signal.confidence = 0.75f + (static_cast<float>(confirmationCount) / confirmationBars * 0.25f);
-                signal.entryPrice = currentClose + sc.TickSize;
-                signal.stopLoss = currentLow - (2 * sc.TickSize);
-                signal.target = currentClose + ((currentClose - signal.stopLoss) * 2.0f);
-                signal.reason = "Absorption at Low - Volume: " + std::to_string(sc.BidVolume[index]);
+                signal.entryTicks = currentClose + 1;
+                signal.stopTicks = currentLow - 2;
+                signal.targetTicks = currentClose + (currentClose - signal.stopTicks) * 2;
+                signal.reason = "Absorption at Low - Volume: " + std::to_string(bar.bidVolume);
                 
                 // Visualize the signal
-                sc.Subgraph[2][index] = currentLow - sc.TickSize;
+                sc.Subgraph[2][index] = TicksToPrice(instrument, currentLow - 1);
                 sc.Subgraph[2].DataColor[index] = sc.Subgraph[2].PrimaryColor;
             }
         }
     }
     
     // Check for absorption at current high (potential short setup)
-    if (sc.AskVolume[index] >= volumeThreshold)
+    if (bar.askVolume >= volumeThreshold)
     {
-        float rangeTicks = (currentHigh - currentLow) / sc.TickSize;
-        bool priceStalled = (rangeTicks <= priceStallTicks);
-        bool closedOffHigh = (currentClose < (currentLow + (currentHigh - currentLow) * 0.4f));
+        bool closedOffHigh = ((currentClose - currentLow) * 10 < rangeTicks * 4);
         
         if (priceStalled && closedOffHigh)
         {
             // Check for confirmation in previous bars
             int confirmationCount = 0;
-            for (int i = 1; i <= confirmationBars && (index - i) >= 0; i++)
+            CanonicalBar prior;
+            for (int i = 1; i <= confirmationBars && GetStrategyBar(sc, index, latest + i, prior); i++)
             {
-                if (sc.AskVolume[index - i] >= volumeThreshold * 0.7f)
+                if (prior.askVolume >= volumeThreshold * 0.7f)
                     confirmationCount++;
             }
             
@@ -1073,35 +4542,59 @@ TradeSignal CheckLiquidityAbsorption(SCStudyInterfaceRef sc, int index)
             {
                 signal.direction = -1; // Short
                 signal.confidence = 0.75f + (static_cast<float>(confirmationCount) / confirmationBars * 0.25f);
-                signal.entryPrice = currentClose - sc.TickSize;
-                signal.stopLoss = currentHigh + (2 * sc.TickSize);
-                signal.target = currentClose - ((signal.stopLoss - currentClose) * 2.0f);
-                signal.reason = "Absorption at High - Volume: " + std::to_string(sc.AskVolume[index]);
+                signal.entryTicks = currentClose - 1;
+                signal.stopTicks = currentHigh + 2;
+                signal.targetTicks = currentClose - (signal.stopTicks - currentClose) * 2;
+                signal.reason = "Absorption at High - Volume: " + std::to_string(bar.askVolume);
                 
                 // Visualize the signal
-                sc.Subgraph[2][index] = currentHigh + sc.TickSize;
+                sc.Subgraph[2][index] = TicksToPrice(instrument, currentHigh + 1);
                 sc.Subgraph[2].DataColor[index] = sc.Subgraph[2].SecondaryColor;
             }
         }
     }
+
+    return signal;
+}
+
+TradeSignal CheckLiquidityAbsorption(SCStudyInterfaceRef sc, int index)
+{
+    AOFB_PROBE(PROBE_LIQUIDITY_ABSORPTION);
+    TradeSignal signal = {0, 0.0f, "Liquidity Absorption", 0, 0, 0, ""};
+    
+    if (index < 5) return signal;
+
+    // Each strategy bar that closed during this chart bar, newest first, until one signals
+    int closed = CountStrategyBars(sc, index);
+    for (int latest = 0; latest < closed && signal.direction == 0; latest++)
+        signal = CheckLiquidityAbsorptionBar(sc, index, latest);
     
+    // The footprint at the absorbed extreme: exhaustion and extreme delta back the turn, an
+    // unfinished auction there argues against it
+    if (signal.direction != 0)
+        signal.confidence = ApplyFootprintFeatures(sc, index, signal.direction < 0, true, signal.confidence);
+
     return signal;
 }
 
 TradeSignal CheckIcebergDetection(SCStudyInterfaceRef sc, int index)
 {
-    TradeSignal signal = {0, 0.0f, "Iceberg Detection", 0.0f, 0.0f, 0.0f, ""};
+    AOFB_PROBE(PROBE_ICEBERG_DETECTION);
+    TradeSignal signal = {0, 0.0f, "Iceberg Detection", 0, 0, 0, ""};
     
-    int minHitVolume = sc.Input[61].GetInt();
-    int detectionBars = sc.Input[62].GetInt();
-    int priceTolerance = sc.Input[63].GetInt();
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    int minHitVolume = params.icebergMinHitVolume;
+    int detectionBars = params.icebergDetectionBars;
+    int priceTolerance = params.icebergToleranceTicks;
     
     if (index < detectionBars) return signal;
     
-    float tolerancePrice = priceTolerance * sc.TickSize;
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int currentClose = ticks.close[index];
     
     // Check for buy iceberg (repeated hits at bid level)
-    float icebergLevel = sc.Low[index];
+    int icebergLevel = ticks.low[index];
     int hitCount = 0;
     int totalVolume = 0;
     
@@ -1110,7 +4603,7 @@ TradeSignal CheckIcebergDetection(SCStudyInterfaceRef sc, int index)
         int barIndex = index - i;
         if (barIndex < 0) break;
         
-        if (std::abs(sc.Low[barIndex] - icebergLevel) <= tolerancePrice)
+        if (std::abs(ticks.low[barIndex] - icebergLevel) <= priceTolerance)
         {
             if (sc.BidVolume[barIndex] >= minHitVolume)
             {
@@ -1124,24 +4617,32 @@ TradeSignal CheckIcebergDetection(SCStudyInterfaceRef sc, int index)
     if (hitCount >= detectionBars * 0.6f && totalVolume >= minHitVolume * detectionBars)
     {
         // Check if price is bouncing from iceberg level
-        if (sc.Close[index] > icebergLevel + sc.TickSize)
+        if (currentClose > icebergLevel + 1)
         {
             signal.direction = 1; // Long
             signal.confidence = 0.6f + (static_cast<float>(hitCount) / detectionBars * 0.3f);
-            signal.entryPrice = sc.Close[index] + sc.TickSize;
-            signal.stopLoss = icebergLevel - (2 * sc.TickSize);
-            signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 1.5f);
+            signal.entryTicks = currentClose + 1;
+            signal.stopTicks = icebergLevel - 2;
+            signal.targetTicks = signal.entryTicks + ((signal.entryTicks - signal.stopTicks) * 3 + 1) / 2;
             signal.reason = "Buy Iceberg Detected - Hits: " + std::to_string(hitCount) + 
                            " Volume: " + std::to_string(totalVolume);
+
+            // Same-size prints at the bid are the refills being hit
+            int clipRepeats = GetClipClusterRepeats(sc, SC_TS_BID, icebergLevel, priceTolerance, index);
+            if (clipRepeats > 0)
+            {
+                signal.confidence = std::min(1.0f, signal.confidence + params.icebergClipBoost);
+                signal.reason += " Clips: " + std::to_string(clipRepeats);
+            }
             
             // Visualize the signal
-            sc.Subgraph[3][index] = icebergLevel - (2 * sc.TickSize);
+            sc.Subgraph[3][index] = TicksToPrice(instrument, icebergLevel - 2);
             sc.Subgraph[3].DataColor[index] = sc.Subgraph[3].PrimaryColor;
         }
     }
     
     // Check for sell iceberg (repeated hits at ask level)
-    icebergLevel = sc.High[index];
+    icebergLevel = ticks.high[index];
     hitCount = 0;
     totalVolume = 0;
     
@@ -1150,7 +4651,7 @@ TradeSignal CheckIcebergDetection(SCStudyInterfaceRef sc, int index)
         int barIndex = index - i;
         if (barIndex < 0) break;
         
-        if (std::abs(sc.High[barIndex] - icebergLevel) <= tolerancePrice)
+        if (std::abs(ticks.high[barIndex] - icebergLevel) <= priceTolerance)
         {
             if (sc.AskVolume[barIndex] >= minHitVolume)
             {
@@ -1164,18 +4665,25 @@ TradeSignal CheckIcebergDetection(SCStudyInterfaceRef sc, int index)
     if (hitCount >= detectionBars * 0.6f && totalVolume >= minHitVolume * detectionBars)
     {
         // Check if price is rejecting from iceberg level
-        if (sc.Close[index] < icebergLevel - sc.TickSize)
+        if (currentClose < icebergLevel - 1)
         {
             signal.direction = -1; // Short
             signal.confidence = 0.6f + (static_cast<float>(hitCount) / detectionBars * 0.3f);
-            signal.entryPrice = sc.Close[index] - sc.TickSize;
-            signal.stopLoss = icebergLevel + (2 * sc.TickSize);
-            signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 1.5f);
+            signal.entryTicks = currentClose - 1;
+            signal.stopTicks = icebergLevel + 2;
+            signal.targetTicks = signal.entryTicks - ((signal.stopTicks - signal.entryTicks) * 3 + 1) / 2;
             signal.reason = "Sell Iceberg Detected - Hits: " + std::to_string(hitCount) + 
                            " Volume: " + std::to_string(totalVolume);
+
+            int clipRepeats = GetClipClusterRepeats(sc, SC_TS_ASK, icebergLevel, priceTolerance, index);
+            if (clipRepeats > 0)
+            {
+                signal.confidence = std::min(1.0f, signal.confidence + params.icebergClipBoost);
+                signal.reason += " Clips: " + std::to_string(clipRepeats);
+            }
             
             // Visualize the signal
-            sc.Subgraph[3][index] = icebergLevel + (2 * sc.TickSize);
+            sc.Subgraph[3][index] = TicksToPrice(instrument, icebergLevel + 2);
             sc.Subgraph[3].DataColor[index] = sc.Subgraph[3].SecondaryColor;
         }
     }
@@ -1185,10 +4693,14 @@ TradeSignal CheckIcebergDetection(SCStudyInterfaceRef sc, int index)
 
 TradeSignal CheckDeltaDivergence(SCStudyInterfaceRef sc, int index)
 {
-    TradeSignal signal = {0, 0.0f, "Delta Divergence", 0.0f, 0.0f, 0.0f, ""};
+    AOFB_PROBE(PROBE_DELTA_DIVERGENCE);
+    TradeSignal signal = {0, 0.0f, "Delta Divergence", 0, 0, 0, ""};
     
-    int lookbackPeriod = sc.Input[72].GetInt();
-    float exhaustionThreshold = sc.Input[73].GetFloat();
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    int lookbackPeriod = params.divergenceLookback;
+    float exhaustionThreshold = params.deltaExhaustionThreshold;
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
     
     if (index < lookbackPeriod + 5) return signal;
     
@@ -1196,54 +4708,54 @@ TradeSignal CheckDeltaDivergence(SCStudyInterfaceRef sc, int index)
     float cumulativeDelta = sc.GetPersistentFloat(4);
     
     // Find recent swing high/low in price
-    int priceHighIndex = sc.GetIndexOfHighestValue(sc.High, index - lookbackPeriod, index - 1);
-    int priceLowIndex = sc.GetIndexOfLowestValue(sc.Low, index - lookbackPeriod, index - 1);
+    int priceHighIndex = GetIndexOfHighestTick(ticks.high, index - lookbackPeriod, index - 1);
+    int priceLowIndex = GetIndexOfLowestTick(ticks.low, index - lookbackPeriod, index - 1);
     
     // Check for bearish divergence (price higher high, delta lower high)
-    if (priceHighIndex != -1 && sc.High[index] > sc.High[priceHighIndex])
+    if (priceHighIndex != -1 && ticks.high[index] > ticks.high[priceHighIndex])
     {
         if (sc.Subgraph[0][index] < sc.Subgraph[0][priceHighIndex])
         {
-            float divergenceStrength = (sc.High[index] - sc.High[priceHighIndex]) / sc.TickSize;
+            int divergenceStrength = ticks.high[index] - ticks.high[priceHighIndex];
             float deltaWeakness = (sc.Subgraph[0][priceHighIndex] - sc.Subgraph[0][index]) / 
                                 std::abs(sc.Subgraph[0][priceHighIndex]);
             
-            if (divergenceStrength >= 3.0f && deltaWeakness >= 0.1f)
+            if (divergenceStrength >= 3 && deltaWeakness >= 0.1f)
             {
                 signal.direction = -1; // Short
                 signal.confidence = 0.7f + std::min(0.25f, deltaWeakness);
-                signal.entryPrice = sc.Close[index] - sc.TickSize;
-                signal.stopLoss = sc.High[index] + (2 * sc.TickSize);
-                signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 2.0f);
+                signal.entryTicks = ticks.close[index] - 1;
+                signal.stopTicks = ticks.high[index] + 2;
+                signal.targetTicks = signal.entryTicks - (signal.stopTicks - signal.entryTicks) * 2;
                 signal.reason = "Bearish Delta Divergence - Strength: " + std::to_string(divergenceStrength);
                 
                 // Visualize the signal
-                sc.Subgraph[4][index] = sc.High[index] + (2 * sc.TickSize);
+                sc.Subgraph[4][index] = TicksToPrice(instrument, ticks.high[index] + 2);
                 sc.Subgraph[4].DataColor[index] = sc.Subgraph[4].SecondaryColor;
             }
         }
     }
     
     // Check for bullish divergence (price lower low, delta higher low)
-    if (priceLowIndex != -1 && sc.Low[index] < sc.Low[priceLowIndex])
+    if (priceLowIndex != -1 && ticks.low[index] < ticks.low[priceLowIndex])
     {
         if (sc.Subgraph[0][index] > sc.Subgraph[0][priceLowIndex])
         {
-            float divergenceStrength = (sc.Low[priceLowIndex] - sc.Low[index]) / sc.TickSize;
+            int divergenceStrength = ticks.low[priceLowIndex] - ticks.low[index];
             float deltaStrength = (sc.Subgraph[0][index] - sc.Subgraph[0][priceLowIndex]) / 
                                 std::abs(sc.Subgraph[0][priceLowIndex]);
             
-            if (divergenceStrength >= 3.0f && deltaStrength >= 0.1f)
+            if (divergenceStrength >= 3 && deltaStrength >= 0.1f)
             {
                 signal.direction = 1; // Long
                 signal.confidence = 0.7f + std::min(0.25f, deltaStrength);
-                signal.entryPrice = sc.Close[index] + sc.TickSize;
-                signal.stopLoss = sc.Low[index] - (2 * sc.TickSize);
-                signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 2.0f);
+                signal.entryTicks = ticks.close[index] + 1;
+                signal.stopTicks = ticks.low[index] - 2;
+                signal.targetTicks = signal.entryTicks + (signal.entryTicks - signal.stopTicks) * 2;
                 signal.reason = "Bullish Delta Divergence - Strength: " + std::to_string(divergenceStrength);
                 
                 // Visualize the signal
-                sc.Subgraph[4][index] = sc.Low[index] - (2 * sc.TickSize);
+                sc.Subgraph[4][index] = TicksToPrice(instrument, ticks.low[index] - 2);
                 sc.Subgraph[4].DataColor[index] = sc.Subgraph[4].PrimaryColor;
             }
         }
@@ -1252,18 +4764,19 @@ TradeSignal CheckDeltaDivergence(SCStudyInterfaceRef sc, int index)
     return signal;
 }
 
-TradeSignal CheckVolumeImbalance(SCStudyInterfaceRef sc, int index)
+// Imbalance on the strategy bar latest bars back from the newest that closed during chart bar index
+static TradeSignal CheckVolumeImbalanceBar(SCStudyInterfaceRef sc, int index, int latest)
 {
-    TradeSignal signal = {0, 0.0f, "Volume Imbalance", 0.0f, 0.0f, 0.0f, ""};
-    
-    if (index < 2) return signal;
+    TradeSignal signal = {0, 0.0f, "Volume Imbalance", 0, 0, 0, ""};
     
-    // Calculate volume imbalance ratio
-    float totalVolume = sc.AskVolume[index] + sc.BidVolume[index];
+    // Calculate volume imbalance ratio on the strategy bar: the chart's, or a canonical one
+    CanonicalBar bar;
+    if (!GetStrategyBar(sc, index, latest, bar)) return signal;
+    float totalVolume = bar.askVolume + bar.bidVolume;
     if (totalVolume == 0) return signal;
     
-    float askRatio = sc.AskVolume[index] / totalVolume;
-    float bidRatio = sc.BidVolume[index] / totalVolume;
+    float askRatio = bar.askVolume / totalVolume;
+    float bidRatio = bar.bidVolume / totalVolume;
     
     // Significant imbalance thresholds
     const float strongImbalanceThreshold = 0.75f;  // 75% or more on one side
@@ -1271,25 +4784,28 @@ TradeSignal CheckVolumeImbalance(SCStudyInterfaceRef sc, int index)
     
     if (totalVolume < minVolume) return signal;
     
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    int currentHigh = bar.high;
+    int currentLow = bar.low;
+    int currentClose = bar.close;
+    float closePosition = static_cast<float>(currentClose - currentLow) / std::max(1, currentHigh - currentLow);
+    
     // Check for bullish imbalance (more buying pressure)
     if (askRatio >= strongImbalanceThreshold)
     {
         // Confirm with price action - should be closing near high
-        float closePosition = (sc.Close[index] - sc.Low[index]) / 
-                             std::max(sc.TickSize, sc.High[index] - sc.Low[index]);
-        
         if (closePosition >= 0.6f) // Closing in upper 40% of range
         {
             signal.direction = 1; // Long
             signal.confidence = 0.65f + (askRatio - strongImbalanceThreshold) * 1.4f;
-            signal.entryPrice = sc.Close[index] + sc.TickSize;
-            signal.stopLoss = sc.Low[index] - sc.TickSize;
-            signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 1.5f);
+            signal.entryTicks = currentClose + 1;
+            signal.stopTicks = currentLow - 1;
+            signal.targetTicks = signal.entryTicks + ((signal.entryTicks - signal.stopTicks) * 3 + 1) / 2;
             signal.reason = "Bullish Volume Imbalance - Ask Ratio: " + 
                            std::to_string(static_cast<int>(askRatio * 100)) + "%";
             
             // Visualize the signal
-            sc.Subgraph[4][index] = sc.Low[index] - sc.TickSize;
+            sc.Subgraph[4][index] = TicksToPrice(instrument, currentLow - 1);
             sc.Subgraph[4].DataColor[index] = sc.Subgraph[4].PrimaryColor;
         }
     }
@@ -1298,21 +4814,18 @@ TradeSignal CheckVolumeImbalance(SCStudyInterfaceRef sc, int index)
     if (bidRatio >= strongImbalanceThreshold)
     {
         // Confirm with price action - should be closing near low
-        float closePosition = (sc.Close[index] - sc.Low[index]) / 
-                             std::max(sc.TickSize, sc.High[index] - sc.Low[index]);
-        
         if (closePosition <= 0.4f) // Closing in lower 40% of range
         {
             signal.direction = -1; // Short
             signal.confidence = 0.65f + (bidRatio - strongImbalanceThreshold) * 1.4f;
-            signal.entryPrice = sc.Close[index] - sc.TickSize;
-            signal.stopLoss = sc.High[index] + sc.TickSize;
-            signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 1.5f);
+            signal.entryTicks = currentClose - 1;
+            signal.stopTicks = currentHigh + 1;
+            signal.targetTicks = signal.entryTicks - ((signal.stopTicks - signal.entryTicks) * 3 + 1) / 2;
             signal.reason = "Bearish Volume Imbalance - Bid Ratio: " + 
                            std::to_string(static_cast<int>(bidRatio * 100)) + "%";
             
             // Visualize the signal
-            sc.Subgraph[4][index] = sc.High[index] + sc.TickSize;
+            sc.Subgraph[4][index] = TicksToPrice(instrument, currentHigh + 1);
             sc.Subgraph[4].DataColor[index] = sc.Subgraph[4].SecondaryColor;
         }
     }
@@ -1320,30 +4833,49 @@ TradeSignal CheckVolumeImbalance(SCStudyInterfaceRef sc, int index)
     return signal;
 }
 
+TradeSignal CheckVolumeImbalance(SCStudyInterfaceRef sc, int index)
+{
+    AOFB_PROBE(PROBE_VOLUME_IMBALANCE);
+    TradeSignal signal = {0, 0.0f, "Volume Imbalance", 0, 0, 0, ""};
+    
+    if (index < 2) return signal;
+
+    // Each strategy bar that closed during this chart bar, newest first, until one signals
+    int closed = CountStrategyBars(sc, index);
+    for (int latest = 0; latest < closed && signal.direction == 0; latest++)
+        signal = CheckVolumeImbalanceBar(sc, index, latest);
+
+    return signal;
+}
+
 
 TradeSignal CheckStopRunAnticipation(SCStudyInterfaceRef sc, int index)
 {
-    TradeSignal signal = {0, 0.0f, "Stop Run Anticipation", 0.0f, 0.0f, 0.0f, ""};
+    AOFB_PROBE(PROBE_STOP_RUN);
+    TradeSignal signal = {0, 0.0f, "Stop Run Anticipation", 0, 0, 0, ""};
     
     if (index < 20) return signal;
     
     int lookback = 20;
     
     // Find recent swing highs and lows where stops might be clustered
-    std::vector<float> swingHighs = FindSwingPoints(sc, 5, true);
-    std::vector<float> swingLows = FindSwingPoints(sc, 5, false);
+    std::vector<int> swingHighs = FindSwingPoints(sc, 5, true);
+    std::vector<int> swingLows = FindSwingPoints(sc, 5, false);
     
-    float currentPrice = sc.Close[index];
-    float currentHigh = sc.High[index];
-    float currentLow = sc.Low[index];
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int currentPrice = ticks.close[index];
+    int currentHigh = ticks.high[index];
+    int currentLow = ticks.low[index];
     
     // Check for stop run above recent swing high (potential short setup)
-    for (float swingHigh : swingHighs)
+    int sweptLevel = 0;
+    for (int swingHigh : swingHighs)
     {
-        float distanceToSwing = std::abs(currentHigh - swingHigh);
+        int distanceToSwing = std::abs(currentHigh - swingHigh);
         
         // If we've just cleared a swing high with volume
-        if (currentHigh > swingHigh && distanceToSwing <= 3 * sc.TickSize)
+        if (currentHigh > swingHigh && distanceToSwing <= 3)
         {
             // Check for high volume on the breakout bar
             float avgVolume = 0;
@@ -1357,18 +4889,19 @@ TradeSignal CheckStopRunAnticipation(SCStudyInterfaceRef sc, int index)
             if (sc.Volume[index] > avgVolume * 1.5f)
             {
                 // Check if price is failing to continue higher (potential trap)
-                if (sc.Close[index] < swingHigh + (2 * sc.TickSize))
+                if (currentPrice < swingHigh + 2)
                 {
                     signal.direction = -1; // Short (fade the breakout)
                     signal.confidence = 0.7f;
-                    signal.entryPrice = sc.Close[index] - sc.TickSize;
-                    signal.stopLoss = currentHigh + (2 * sc.TickSize);
-                    signal.target = swingHigh - (3 * sc.TickSize);
-                    signal.reason = "Stop Run Fade - Failed breakout above " + std::to_string(swingHigh);
+                    signal.entryTicks = currentPrice - 1;
+                    signal.stopTicks = currentHigh + 2;
+                    signal.targetTicks = swingHigh - 3;
+                    signal.reason = "Stop Run Fade - Failed breakout above " + std::to_string(TicksToPrice(instrument, swingHigh));
                     
                     // Visualize the signal
-                    sc.Subgraph[5][index] = currentHigh + (2 * sc.TickSize);
+                    sc.Subgraph[5][index] = TicksToPrice(instrument, currentHigh + 2);
                     sc.Subgraph[5].DataColor[index] = sc.Subgraph[5].SecondaryColor;
+                    sweptLevel = swingHigh;
                     break;
                 }
                 else
@@ -1376,29 +4909,32 @@ TradeSignal CheckStopRunAnticipation(SCStudyInterfaceRef sc, int index)
                     // Genuine breakout - ride the momentum
                     signal.direction = 1; // Long (ride the breakout)
                     signal.confidence = 0.65f;
-                    signal.entryPrice = sc.Close[index] + sc.TickSize;
-                    signal.stopLoss = swingHigh - sc.TickSize;
-                    signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 2.0f);
-                    signal.reason = "Stop Run Momentum - Breakout above " + std::to_string(swingHigh);
+                    signal.entryTicks = currentPrice + 1;
+                    signal.stopTicks = swingHigh - 1;
+                    signal.targetTicks = signal.entryTicks + (signal.entryTicks - signal.stopTicks) * 2;
+                    signal.reason = "Stop Run Momentum - Breakout above " + std::to_string(TicksToPrice(instrument, swingHigh));
                     
                     // Visualize the signal
-                    sc.Subgraph[5][index] = currentLow - (2 * sc.TickSize);
+                    sc.Subgraph[5][index] = TicksToPrice(instrument, currentLow - 2);
                     sc.Subgraph[5].DataColor[index] = sc.Subgraph[5].PrimaryColor;
+                    sweptLevel = swingHigh;
                     break;
                 }
             }
         }
     }
     
+    bool sweptHigh = signal.direction != 0;
+
     // Check for stop run below recent swing low (potential long setup)
     if (signal.direction == 0) // Only if no signal found above
     {
-        for (float swingLow : swingLows)
+        for (int swingLow : swingLows)
         {
-            float distanceToSwing = std::abs(currentLow - swingLow);
+            int distanceToSwing = std::abs(currentLow - swingLow);
             
             // If we've just cleared a swing low with volume
-            if (currentLow < swingLow && distanceToSwing <= 3 * sc.TickSize)
+            if (currentLow < swingLow && distanceToSwing <= 3)
             {
                 // Check for high volume on the breakdown bar
                 float avgVolume = 0;
@@ -1412,18 +4948,19 @@ TradeSignal CheckStopRunAnticipation(SCStudyInterfaceRef sc, int index)
                 if (sc.Volume[index] > avgVolume * 1.5f)
                 {
                     // Check if price is failing to continue lower (potential trap)
-                    if (sc.Close[index] > swingLow - (2 * sc.TickSize))
+                    if (currentPrice > swingLow - 2)
                     {
                         signal.direction = 1; // Long (fade the breakdown)
                         signal.confidence = 0.7f;
-                        signal.entryPrice = sc.Close[index] + sc.TickSize;
-                        signal.stopLoss = currentLow - (2 * sc.TickSize);
-                        signal.target = swingLow + (3 * sc.TickSize);
-                        signal.reason = "Stop Run Fade - Failed breakdown below " + std::to_string(swingLow);
+                        signal.entryTicks = currentPrice + 1;
+                        signal.stopTicks = currentLow - 2;
+                        signal.targetTicks = swingLow + 3;
+                        signal.reason = "Stop Run Fade - Failed breakdown below " + std::to_string(TicksToPrice(instrument, swingLow));
                         
                         // Visualize the signal
-                        sc.Subgraph[5][index] = currentLow - (2 * sc.TickSize);
+                        sc.Subgraph[5][index] = TicksToPrice(instrument, currentLow - 2);
                         sc.Subgraph[5].DataColor[index] = sc.Subgraph[5].PrimaryColor;
+                        sweptLevel = swingLow;
                         break;
                     }
                     else
@@ -1431,14 +4968,15 @@ TradeSignal CheckStopRunAnticipation(SCStudyInterfaceRef sc, int index)
                         // Genuine breakdown - ride the momentum
                         signal.direction = -1; // Short (ride the breakdown)
                         signal.confidence = 0.65f;
-                        signal.entryPrice = sc.Close[index] - sc.TickSize;
-                        signal.stopLoss = swingLow + sc.TickSize;
-                        signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 2.0f);
-                        signal.reason = "Stop Run Momentum - Breakdown below " + std::to_string(swingLow);
+                        signal.entryTicks = currentPrice - 1;
+                        signal.stopTicks = swingLow + 1;
+                        signal.targetTicks = signal.entryTicks - (signal.stopTicks - signal.entryTicks) * 2;
+                        signal.reason = "Stop Run Momentum - Breakdown below " + std::to_string(TicksToPrice(instrument, swingLow));
                         
                         // Visualize the signal
-                        sc.Subgraph[5][index] = currentHigh + (2 * sc.TickSize);
+                        sc.Subgraph[5][index] = TicksToPrice(instrument, currentHigh + 2);
                         sc.Subgraph[5].DataColor[index] = sc.Subgraph[5].SecondaryColor;
+                        sweptLevel = swingLow;
                         break;
                     }
                 }
@@ -1446,50 +4984,63 @@ TradeSignal CheckStopRunAnticipation(SCStudyInterfaceRef sc, int index)
         }
     }
     
+    // Stops cluster at prior-session levels and round numbers; a swing sitting on one counts more
+    if (signal.direction != 0)
+        signal.confidence = ApplyReferenceLevel(sc, index, sweptLevel, signal.confidence);
+
+    // Footprint at the swept extreme: exhaustion backs the fade, an unfinished auction the breakout
+    if (signal.direction != 0)
+    {
+        bool fade = sweptHigh ? signal.direction < 0 : signal.direction > 0;
+        signal.confidence = ApplyFootprintFeatures(sc, index, sweptHigh, fade, signal.confidence);
+    }
+
     return signal;
 }
 
 TradeSignal CheckHVNRejection(SCStudyInterfaceRef sc, int index)
 {
-    TradeSignal signal = {0, 0.0f, "HVN Rejection", 0.0f, 0.0f, 0.0f, ""};
+    AOFB_PROBE(PROBE_HVN_REJECTION);
+    TradeSignal signal = {0, 0.0f, "HVN Rejection", 0, 0, 0, ""};
     
-    std::vector<float>* hvnLevels = (std::vector<float>*)sc.GetPersistentPointer(1);
+    std::vector<int>* hvnLevels = (std::vector<int>*)sc.GetPersistentPointer(1);
     if (!hvnLevels || hvnLevels->empty()) return signal;
     
-    float currentPrice = sc.Close[index];
-    float currentHigh = sc.High[index];
-    float currentLow = sc.Low[index];
-    int proximityTicks = sc.Input[84].GetInt();
-    float proximityRange = proximityTicks * sc.TickSize;
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int currentPrice = ticks.close[index];
+    int currentHigh = ticks.high[index];
+    int currentLow = ticks.low[index];
+    int proximityTicks = GetStrategyParameters(sc).levelProximityTicks;
     
     // Check for rejection from HVN levels
-    for (float hvnLevel : *hvnLevels)
+    int signalLevel = 0;
+    for (int hvnLevel : *hvnLevels)
     {
         // Check if price approached the HVN level
-        bool approachedFromBelow = (currentLow <= hvnLevel + proximityRange && 
-                                   currentLow >= hvnLevel - proximityRange);
-        bool approachedFromAbove = (currentHigh >= hvnLevel - proximityRange && 
-                                   currentHigh <= hvnLevel + proximityRange);
+        bool approachedFromBelow = (std::abs(currentLow - hvnLevel) <= proximityTicks);
+        bool approachedFromAbove = (std::abs(currentHigh - hvnLevel) <= proximityTicks);
         
         if (approachedFromBelow)
         {
             // Check for rejection (price failed to close above HVN)
-            if (currentPrice < hvnLevel && sc.High[index] >= hvnLevel)
+            if (currentPrice < hvnLevel && currentHigh >= hvnLevel)
             {
                 // Confirm with volume and price action
-                float rejectionStrength = (hvnLevel - currentPrice) / sc.TickSize;
+                int rejectionStrength = hvnLevel - currentPrice;
                 
-                if (rejectionStrength >= 2.0f)
+                if (rejectionStrength >= 2)
                 {
                     signal.direction = -1; // Short
                     signal.confidence = 0.65f + std::min(0.25f, rejectionStrength / 10.0f);
-                    signal.entryPrice = currentPrice - sc.TickSize;
-                    signal.stopLoss = hvnLevel + (2 * sc.TickSize);
-                    signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 1.5f);
-                    signal.reason = "HVN Rejection from Above - Level: " + std::to_string(hvnLevel);
+                    signal.entryTicks = currentPrice - 1;
+                    signal.stopTicks = hvnLevel + 2;
+                    signal.targetTicks = signal.entryTicks - ((signal.stopTicks - signal.entryTicks) * 3 + 1) / 2;
+                    signal.reason = "HVN Rejection from Above - Level: " + std::to_string(TicksToPrice(instrument, hvnLevel));
                     
                     // Visualize the signal
-                    sc.Subgraph[6][index] = hvnLevel;
+                    sc.Subgraph[6][index] = TicksToPrice(instrument, hvnLevel);
+                    signalLevel = hvnLevel;
                     break;
                 }
             }
@@ -1498,43 +5049,50 @@ TradeSignal CheckHVNRejection(SCStudyInterfaceRef sc, int index)
         if (approachedFromAbove)
         {
             // Check for rejection (price failed to close below HVN)
-            if (currentPrice > hvnLevel && sc.Low[index] <= hvnLevel)
+            if (currentPrice > hvnLevel && currentLow <= hvnLevel)
             {
                 // Confirm with volume and price action
-                float rejectionStrength = (currentPrice - hvnLevel) / sc.TickSize;
+                int rejectionStrength = currentPrice - hvnLevel;
                 
-                if (rejectionStrength >= 2.0f)
+                if (rejectionStrength >= 2)
                 {
                     signal.direction = 1; // Long
                     signal.confidence = 0.65f + std::min(0.25f, rejectionStrength / 10.0f);
-                    signal.entryPrice = currentPrice + sc.TickSize;
-                    signal.stopLoss = hvnLevel - (2 * sc.TickSize);
-                    signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 1.5f);
-                    signal.reason = "HVN Rejection from Below - Level: " + std::to_string(hvnLevel);
+                    signal.entryTicks = currentPrice + 1;
+                    signal.stopTicks = hvnLevel - 2;
+                    signal.targetTicks = signal.entryTicks + ((signal.entryTicks - signal.stopTicks) * 3 + 1) / 2;
+                    signal.reason = "HVN Rejection from Below - Level: " + std::to_string(TicksToPrice(instrument, hvnLevel));
                     
                     // Visualize the signal
-                    sc.Subgraph[6][index] = hvnLevel;
+                    sc.Subgraph[6][index] = TicksToPrice(instrument, hvnLevel);
+                    signalLevel = hvnLevel;
                     break;
                 }
             }
         }
     }
     
+    // Prior holds and breaks at the level, or a fresh level, move the confidence
+    if (signal.direction != 0)
+        signal.confidence = ApplyTouchHistory(sc, index, signalLevel, true, signal.confidence);
+
     return signal;
 }
 
 TradeSignal CheckLVNBreakout(SCStudyInterfaceRef sc, int index)
 {
-    TradeSignal signal = {0, 0.0f, "LVN Breakout", 0.0f, 0.0f, 0.0f, ""};
+    AOFB_PROBE(PROBE_LVN_BREAKOUT);
+    TradeSignal signal = {0, 0.0f, "LVN Breakout", 0, 0, 0, ""};
     
-    std::vector<float>* lvnLevels = (std::vector<float>*)sc.GetPersistentPointer(2);
-    if (!lvnLevels || lvnLevels->empty()) return signal;
+    std::vector<int>* lvnLevels = (std::vector<int>*)sc.GetPersistentPointer(2);
+    if (!lvnLevels || lvnLevels->empty() || index < 1) return signal;
     
-    float currentPrice = sc.Close[index];
-    float currentHigh = sc.High[index];
-    float currentLow = sc.Low[index];
-    int proximityTicks = sc.Input[84].GetInt();
-    float proximityRange = proximityTicks * sc.TickSize;
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int currentPrice = ticks.close[index];
+    int currentHigh = ticks.high[index];
+    int currentLow = ticks.low[index];
+    int proximityTicks = GetStrategyParameters(sc).levelProximityTicks;
     
     // Calculate average volume for comparison
     float avgVolume = 0;
@@ -1546,24 +5104,26 @@ TradeSignal CheckLVNBreakout(SCStudyInterfaceRef sc, int index)
     avgVolume /= volumeBars;
     
     // Check for breakout through LVN levels
-    for (float lvnLevel : *lvnLevels)
+    int signalLevel = 0;
+    for (int lvnLevel : *lvnLevels)
     {
         // Check if price is breaking through LVN with momentum
-        bool breakingUp = (sc.Low[index - 1] <= lvnLevel && currentHigh > lvnLevel + proximityRange);
-        bool breakingDown = (sc.High[index - 1] >= lvnLevel && currentLow < lvnLevel - proximityRange);
+        bool breakingUp = (ticks.low[index - 1] <= lvnLevel && currentHigh > lvnLevel + proximityTicks);
+        bool breakingDown = (ticks.high[index - 1] >= lvnLevel && currentLow < lvnLevel - proximityTicks);
         
         if (breakingUp && sc.Volume[index] > avgVolume * 1.2f)
         {
             // Upward breakout through LVN
             signal.direction = 1; // Long
             signal.confidence = 0.6f + std::min(0.3f, (sc.Volume[index] / avgVolume - 1.0f));
-            signal.entryPrice = currentPrice + sc.TickSize;
-            signal.stopLoss = lvnLevel - sc.TickSize;
-            signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 2.0f);
-            signal.reason = "LVN Upward Breakout - Level: " + std::to_string(lvnLevel);
+            signal.entryTicks = currentPrice + 1;
+            signal.stopTicks = lvnLevel - 1;
+            signal.targetTicks = signal.entryTicks + (signal.entryTicks - signal.stopTicks) * 2;
+            signal.reason = "LVN Upward Breakout - Level: " + std::to_string(TicksToPrice(instrument, lvnLevel));
             
             // Visualize the signal
-            sc.Subgraph[7][index] = lvnLevel;
+            sc.Subgraph[7][index] = TicksToPrice(instrument, lvnLevel);
+            signalLevel = lvnLevel;
             break;
         }
         
@@ -1572,41 +5132,51 @@ TradeSignal CheckLVNBreakout(SCStudyInterfaceRef sc, int index)
             // Downward breakout through LVN
             signal.direction = -1; // Short
             signal.confidence = 0.6f + std::min(0.3f, (sc.Volume[index] / avgVolume - 1.0f));
-            signal.entryPrice = currentPrice - sc.TickSize;
-            signal.stopLoss = lvnLevel + sc.TickSize;
-            signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 2.0f);
-            signal.reason = "LVN Downward Breakout - Level: " + std::to_string(lvnLevel);
+            signal.entryTicks = currentPrice - 1;
+            signal.stopTicks = lvnLevel + 1;
+            signal.targetTicks = signal.entryTicks - (signal.stopTicks - signal.entryTicks) * 2;
+            signal.reason = "LVN Downward Breakout - Level: " + std::to_string(TicksToPrice(instrument, lvnLevel));
             
             // Visualize the signal
-            sc.Subgraph[7][index] = lvnLevel;
+            sc.Subgraph[7][index] = TicksToPrice(instrument, lvnLevel);
+            signalLevel = lvnLevel;
             break;
         }
     }
     
+    // Prior holds and breaks at the level, or a fresh level, move the confidence
+    if (signal.direction != 0)
+        signal.confidence = ApplyTouchHistory(sc, index, signalLevel, false, signal.confidence);
+
     return signal;
 }
 
 TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index)
 {
-    TradeSignal signal = {0, 0.0f, "Momentum Breakout", 0.0f, 0.0f, 0.0f, ""};
+    AOFB_PROBE(PROBE_MOMENTUM_BREAKOUT);
+    TradeSignal signal = {0, 0.0f, "Momentum Breakout", 0, 0, 0, ""};
     
-    int lookbackPeriod = sc.Input[92].GetInt();
-    float volumeMultiplier = sc.Input[91].GetFloat();
-    int confirmationPeriod = sc.Input[93].GetInt();
+    const StrategyParameters& params = GetStrategyParameters(sc);
+    int lookbackPeriod = params.breakoutLookback;
+    float volumeMultiplier = params.breakoutVolumeMultiplier;
+    int confirmationPeriod = params.momentumConfirmationBars;
     
     if (index < lookbackPeriod + confirmationPeriod) return signal;
     
+    const InstrumentMetadata& instrument = GetInstrumentMetadata(sc);
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    
     // Find recent range high and low
-    int rangeHighIndex = sc.GetIndexOfHighestValue(sc.High, index - lookbackPeriod, index - 1);
-    int rangeLowIndex = sc.GetIndexOfLowestValue(sc.Low, index - lookbackPeriod, index - 1);
+    int rangeHighIndex = GetIndexOfHighestTick(ticks.high, index - lookbackPeriod, index - 1);
+    int rangeLowIndex = GetIndexOfLowestTick(ticks.low, index - lookbackPeriod, index - 1);
     
     if (rangeHighIndex == -1 || rangeLowIndex == -1) return signal;
     
-    float rangeHigh = sc.High[rangeHighIndex];
-    float rangeLow = sc.Low[rangeLowIndex];
-    float currentPrice = sc.Close[index];
-    float currentHigh = sc.High[index];
-    float currentLow = sc.Low[index];
+    int rangeHigh = ticks.high[rangeHighIndex];
+    int rangeLow = ticks.low[rangeLowIndex];
+    int currentPrice = ticks.close[index];
+    int currentHigh = ticks.high[index];
+    int currentLow = ticks.low[index];
     
     // Calculate average volume
     float avgVolume = 0;
@@ -1621,8 +5191,8 @@ TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index)
     if (currentHigh > rangeHigh && sc.Volume[index] >= avgVolume * volumeMultiplier)
     {
         // Confirm momentum with price closing in upper portion of bar
-        float barRange = currentHigh - currentLow;
-        float closePosition = (currentPrice - currentLow) / std::max(sc.TickSize, barRange);
+        int barRange = currentHigh - currentLow;
+        float closePosition = static_cast<float>(currentPrice - currentLow) / std::max(1, barRange);
         
         if (closePosition >= 0.7f) // Closing in upper 30% of bar
         {
@@ -1630,7 +5200,7 @@ TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index)
             int momentumBars = 0;
             for (int i = 1; i <= confirmationPeriod; i++)
             {
-                if (index - i >= 0 && sc.Close[index - i] > sc.Open[index - i])
+                if (index - i >= 0 && ticks.close[index - i] > ticks.open[index - i])
                     momentumBars++;
             }
             
@@ -1638,13 +5208,13 @@ TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index)
             {
                 signal.direction = 1; // Long
                 signal.confidence = 0.6f + std::min(0.3f, (sc.Volume[index] / avgVolume - 1.0f));
-                signal.entryPrice = currentPrice + sc.TickSize;
-                signal.stopLoss = rangeLow - sc.TickSize;
-                signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 2.0f);
-                signal.reason = "Upward Momentum Breakout - Range High: " + std::to_string(rangeHigh);
+                signal.entryTicks = currentPrice + 1;
+                signal.stopTicks = rangeLow - 1;
+                signal.targetTicks = signal.entryTicks + (signal.entryTicks - signal.stopTicks) * 2;
+                signal.reason = "Upward Momentum Breakout - Range High: " + std::to_string(TicksToPrice(instrument, rangeHigh));
                 
                 // Visualize the signal
-                sc.Subgraph[5][index] = rangeHigh;
+                sc.Subgraph[5][index] = TicksToPrice(instrument, rangeHigh);
                 sc.Subgraph[5].DataColor[index] = sc.Subgraph[5].PrimaryColor;
             }
         }
@@ -1654,8 +5224,8 @@ TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index)
     if (currentLow < rangeLow && sc.Volume[index] >= avgVolume * volumeMultiplier)
     {
         // Confirm momentum with price closing in lower portion of bar
-        float barRange = currentHigh - currentLow;
-        float closePosition = (currentPrice - currentLow) / std::max(sc.TickSize, barRange);
+        int barRange = currentHigh - currentLow;
+        float closePosition = static_cast<float>(currentPrice - currentLow) / std::max(1, barRange);
         
         if (closePosition <= 0.3f) // Closing in lower 30% of bar
         {
@@ -1663,7 +5233,7 @@ TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index)
             int momentumBars = 0;
             for (int i = 1; i <= confirmationPeriod; i++)
             {
-                if (index - i >= 0 && sc.Close[index - i] < sc.Open[index - i])
+                if (index - i >= 0 && ticks.close[index - i] < ticks.open[index - i])
                     momentumBars++;
             }
             
@@ -1671,13 +5241,13 @@ TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index)
             {
                 signal.direction = -1; // Short
                 signal.confidence = 0.6f + std::min(0.3f, (sc.Volume[index] / avgVolume - 1.0f));
-                signal.entryPrice = currentPrice - sc.TickSize;
-                signal.stopLoss = rangeHigh + sc.TickSize;
-                signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 2.0f);
-                signal.reason = "Downward Momentum Breakout - Range Low: " + std::to_string(rangeLow);
+                signal.entryTicks = currentPrice - 1;
+                signal.stopTicks = rangeHigh + 1;
+                signal.targetTicks = signal.entryTicks - (signal.stopTicks - signal.entryTicks) * 2;
+                signal.reason = "Downward Momentum Breakout - Range Low: " + std::to_string(TicksToPrice(instrument, rangeLow));
                 
                 // Visualize the signal
-                sc.Subgraph[5][index] = rangeLow;
+                sc.Subgraph[5][index] = TicksToPrice(instrument, rangeLow);
                 sc.Subgraph[5].DataColor[index] = sc.Subgraph[5].SecondaryColor;
             }
         }
@@ -1688,10 +5258,13 @@ TradeSignal CheckMomentumBreakout(SCStudyInterfaceRef sc, int index)
 
 TradeSignal CheckCumulativeDeltaTrend(SCStudyInterfaceRef sc, int index)
 {
-    TradeSignal signal = {0, 0.0f, "Cumulative Delta Trend", 0.0f, 0.0f, 0.0f, ""};
+    AOFB_PROBE(PROBE_CUMULATIVE_DELTA);
+    TradeSignal signal = {0, 0.0f, "Cumulative Delta Trend", 0, 0, 0, ""};
     
     if (index < 20) return signal;
     
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    
     // Get cumulative delta values
     float currentDelta = sc.Subgraph[0][index];
     float deltaMA = sc.Subgraph[1][index];
@@ -1703,7 +5276,7 @@ TradeSignal CheckCumulativeDeltaTrend(SCStudyInterfaceRef sc, int index)
     float deltaMATrend = deltaMA - prevDeltaMA;
     
     // Check for strong delta trend alignment with price
-    float priceChange = sc.Close[index] - sc.Close[index - 1];
+    int priceChange = ticks.close[index] - ticks.close[index - 1];
     bool deltaAlignedWithPrice = (deltaTrend > 0 && priceChange > 0) || 
                                 (deltaTrend < 0 && priceChange < 0);
     
@@ -1722,9 +5295,9 @@ TradeSignal CheckCumulativeDeltaTrend(SCStudyInterfaceRef sc, int index)
         {
             signal.direction = 1; // Long
             signal.confidence = 0.6f + std::min(0.3f, trendStrength * 5.0f);
-            signal.entryPrice = sc.Close[index] + sc.TickSize;
-            signal.stopLoss = sc.Low[index] - (2 * sc.TickSize);
-            signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 1.5f);
+            signal.entryTicks = ticks.close[index] + 1;
+            signal.stopTicks = ticks.low[index] - 2;
+            signal.targetTicks = signal.entryTicks + ((signal.entryTicks - signal.stopTicks) * 3 + 1) / 2;
             signal.reason = "Bullish Delta Trend - Strength: " + std::to_string(trendStrength);
         }
     }
@@ -1739,9 +5312,9 @@ TradeSignal CheckCumulativeDeltaTrend(SCStudyInterfaceRef sc, int index)
         {
             signal.direction = -1; // Short
             signal.confidence = 0.6f + std::min(0.3f, trendStrength * 5.0f);
-            signal.entryPrice = sc.Close[index] - sc.TickSize;
-            signal.stopLoss = sc.High[index] + (2 * sc.TickSize);
-            signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 1.5f);
+            signal.entryTicks = ticks.close[index] - 1;
+            signal.stopTicks = ticks.high[index] + 2;
+            signal.targetTicks = signal.entryTicks - ((signal.stopTicks - signal.entryTicks) * 3 + 1) / 2;
             signal.reason = "Bearish Delta Trend - Strength: " + std::to_string(trendStrength);
         }
     }
@@ -1751,22 +5324,24 @@ TradeSignal CheckCumulativeDeltaTrend(SCStudyInterfaceRef sc, int index)
 
 TradeSignal CheckLiquidityTraps(SCStudyInterfaceRef sc, int index)
 {
-    TradeSignal signal = {0, 0.0f, "Liquidity Traps", 0.0f, 0.0f, 0.0f, ""};
+    AOFB_PROBE(PROBE_LIQUIDITY_TRAPS);
+    TradeSignal signal = {0, 0.0f, "Liquidity Traps", 0, 0, 0, ""};
     
     if (index < 10) return signal;
     
     // Look for sudden appearance and disappearance of large orders
     // This is simulated since we don't have direct DOM access in historical data
     
-    float currentHigh = sc.High[index];
-    float currentLow = sc.Low[index];
-    float currentClose = sc.Close[index];
-    float prevHigh = sc.High[index - 1];
-    float prevLow = sc.Low[index - 1];
+    const TickPriceSeries& ticks = GetTickPriceSeries(sc);
+    int currentHigh = ticks.high[index];
+    int currentLow = ticks.low[index];
+    int currentClose = ticks.close[index];
+    int prevHigh = ticks.high[index - 1];
+    int prevLow = ticks.low[index - 1];
     
     // Calculate average volume and range
     float avgVolume = 0;
-    float avgRange = 0;
+    int rangeSum = 0;
     int lookback = 10;
     
     for (int i = 1; i <= lookback; i++)
@@ -1774,80 +5349,88 @@ TradeSignal CheckLiquidityTraps(SCStudyInterfaceRef sc, int index)
         if (index - i >= 0)
         {
             avgVolume += sc.Volume[index - i];
-            avgRange += (sc.High[index - i] - sc.Low[index - i]);
+            rangeSum += (ticks.high[index - i] - ticks.low[index - i]);
         }
     }
     avgVolume /= lookback;
-    avgRange /= lookback;
+    float avgRange = static_cast<float>(rangeSum) / lookback;
     
     // Look for trap patterns
     // Pattern 1: High volume bar with small range followed by reversal
-    float currentRange = currentHigh - currentLow;
+    int currentRange = currentHigh - currentLow;
     bool highVolumeSmallRange = (sc.Volume[index] > avgVolume * 2.0f && 
                                 currentRange < avgRange * 0.7f);
     
+    int trapLevel = 0;
     if (highVolumeSmallRange)
     {
         // Check for reversal in next few bars (simulated)
         // In real implementation, this would monitor DOM changes
         
         // Bullish trap (fake selling pressure)
-        if (currentClose < (currentLow + currentRange * 0.3f))
+        if ((currentClose - currentLow) * 10 < currentRange * 3)
         {
             signal.direction = 1; // Long (fade the selling)
             signal.confidence = 0.65f;
-            signal.entryPrice = currentClose + sc.TickSize;
-            signal.stopLoss = currentLow - sc.TickSize;
-            signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 2.0f);
+            signal.entryTicks = currentClose + 1;
+            signal.stopTicks = currentLow - 1;
+            signal.targetTicks = signal.entryTicks + (signal.entryTicks - signal.stopTicks) * 2;
             signal.reason = "Liquidity Trap - Fake Selling Pressure";
+            trapLevel = currentLow;
         }
         
         // Bearish trap (fake buying pressure)
-        if (currentClose > (currentLow + currentRange * 0.7f))
+        if ((currentClose - currentLow) * 10 > currentRange * 7)
         {
             signal.direction = -1; // Short (fade the buying)
             signal.confidence = 0.65f;
-            signal.entryPrice = currentClose - sc.TickSize;
-            signal.stopLoss = currentHigh + sc.TickSize;
-            signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 2.0f);
+            signal.entryTicks = currentClose - 1;
+            signal.stopTicks = currentHigh + 1;
+            signal.targetTicks = signal.entryTicks - (signal.stopTicks - signal.entryTicks) * 2;
             signal.reason = "Liquidity Trap - Fake Buying Pressure";
+            trapLevel = currentHigh;
         }
     }
     
     // Pattern 2: Price spikes with immediate reversal (stop hunting)
     bool priceSpike = false;
-    float spikeLevel = 0;
+    int spikeLevel = 0;
     
     // Check for upward spike
-    if (currentHigh > prevHigh + (3 * sc.TickSize) && 
-        currentClose < currentHigh - (2 * sc.TickSize))
+    if (currentHigh > prevHigh + 3 && 
+        currentClose < currentHigh - 2)
     {
         priceSpike = true;
         spikeLevel = currentHigh;
         
         signal.direction = -1; // Short (fade the spike)
         signal.confidence = 0.7f;
-        signal.entryPrice = sc.Close[index] - sc.TickSize;
-        signal.stopLoss = spikeLevel + sc.TickSize;
-        signal.target = signal.entryPrice - ((signal.stopLoss - signal.entryPrice) * 1.5f);
+        signal.entryTicks = currentClose - 1;
+        signal.stopTicks = spikeLevel + 1;
+        signal.targetTicks = signal.entryTicks - ((signal.stopTicks - signal.entryTicks) * 3 + 1) / 2;
         signal.reason = "Liquidity Trap - Upward Spike Fade";
+        trapLevel = spikeLevel;
     }
     
     // Check for downward spike
-    if (currentLow < prevLow - (3 * sc.TickSize) && 
-        currentClose > currentLow + (2 * sc.TickSize))
+    if (currentLow < prevLow - 3 && 
+        currentClose > currentLow + 2)
     {
         priceSpike = true;
         spikeLevel = currentLow;
         
         signal.direction = 1; // Long (fade the spike)
         signal.confidence = 0.7f;
-        signal.entryPrice = sc.Close[index] + sc.TickSize;
-        signal.stopLoss = spikeLevel - sc.TickSize;
-        signal.target = signal.entryPrice + ((signal.entryPrice - signal.stopLoss) * 1.5f);
+        signal.entryTicks = currentClose + 1;
+        signal.stopTicks = spikeLevel - 1;
+        signal.targetTicks = signal.entryTicks + ((signal.entryTicks - signal.stopTicks) * 3 + 1) / 2;
         signal.reason = "Liquidity Trap - Downward Spike Fade";
+        trapLevel = spikeLevel;
     }
     
+    // A trap sprung at a prior-session level or round number counts more
+    if (signal.direction != 0)
+        signal.confidence = ApplyReferenceLevel(sc, index, trapLevel, signal.confidence);
+
     return signal;
 }
-
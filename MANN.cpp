@@ -787,7 +787,9 @@ float CalculatePositionSize(SCStudyInterfaceRef sc, const TradeSignal& signal, c
     float stopDistance = std::abs(signal.entryPrice - signal.stopLoss);
     if (stopDistance <= 0) return baseQuantity;
     
-    float pointValue = sc.Input[94].GetFloat();
+    // Input[94] is the confirming-signal count in this study; derive the point value from the symbol settings
+    float pointValue = (sc.TickSize > 0) ? sc.CurrencyValuePerTick / sc.TickSize : 0.0f;
+    if (pointValue <= 0) return baseQuantity;
     float calculatedSize = riskAmount / (stopDistance * pointValue);
     
     // Apply confidence scaling
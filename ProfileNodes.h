@@ -0,0 +1,87 @@
+// ==================================================================================
+// VOLUME PROFILE NODE DETECTION
+// Shared by the study (MAN.cpp) and the out-of-process strategy worker
+// (StrategyWorker.cpp) so both produce identical HVN/LVN levels.
+// ==================================================================================
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+struct VolumeProfileLevel {
+    int priceTicks;
+    float volume;
+    bool isHVN;
+    bool isLVN;
+};
+
+// Builds a volume profile over bars [startIndex, endIndex] on a flat array indexed by
+// tick offset from the lowest low, then classifies each traded level against the average
+// traded-level volume. Series only need operator[]; volumeAtTick is caller-owned scratch.
+// Returns the base tick of the profile, or 0 with no levels when the window is empty.
+template <typename TickSeries, typename VolumeSeries>
+int BuildProfileNodes(const TickSeries& lowTicks, const TickSeries& highTicks, const VolumeSeries& volume,
+                      int startIndex, int endIndex, float hvnMultiplier, float lvnMultiplier,
+                      std::vector<float>& volumeAtTick, std::vector<VolumeProfileLevel>& levels)
+{
+    levels.clear();
+    if (endIndex < startIndex) return 0;
+
+    int baseTick = lowTicks[startIndex];
+    int topTick = highTicks[startIndex];
+    for (int i = startIndex + 1; i <= endIndex; i++)
+    {
+        baseTick = std::min(baseTick, static_cast<int>(lowTicks[i]));
+        topTick = std::max(topTick, static_cast<int>(highTicks[i]));
+    }
+
+    volumeAtTick.assign(topTick - baseTick + 1, 0.0f);
+
+    for (int i = startIndex; i <= endIndex; i++)
+    {
+        float barVolume = volume[i];
+        int low = lowTicks[i];
+
+        // Distribute volume across price levels within the bar
+        int numLevels = std::max(1, static_cast<int>(highTicks[i]) - low);
+        float volumePerLevel = barVolume / numLevels;
+        float* levelVolume = &volumeAtTick[low - baseTick];
+
+        for (int level = 0; level < numLevels; level++)
+        {
+            levelVolume[level] += volumePerLevel;
+        }
+    }
+
+    // Calculate average volume over the traded levels
+    float totalVolume = 0;
+    int tradedLevels = 0;
+    for (float levelVolume : volumeAtTick)
+    {
+        if (levelVolume <= 0) continue;
+        totalVolume += levelVolume;
+        tradedLevels++;
+    }
+
+    if (tradedLevels == 0) return baseTick;
+    float avgVolume = totalVolume / tradedLevels;
+
+    // Identify HVN and LVN levels
+    float hvnThreshold = avgVolume * hvnMultiplier;
+    float lvnThreshold = avgVolume * lvnMultiplier;
+
+    for (int offset = 0; offset < static_cast<int>(volumeAtTick.size()); offset++)
+    {
+        float levelVolume = volumeAtTick[offset];
+        if (levelVolume <= 0) continue;
+
+        VolumeProfileLevel level;
+        level.priceTicks = baseTick + offset;
+        level.volume = levelVolume;
+        level.isHVN = (levelVolume >= hvnThreshold);
+        level.isLVN = (levelVolume <= lvnThreshold);
+        levels.push_back(level);
+    }
+
+    return baseTick;
+}
@@ -0,0 +1,250 @@
+// ==================================================================================
+// STRATEGY WORKER BRIDGE
+// Shared-memory layout and single-producer/single-consumer rings between the study
+// (MAN.cpp, producer of bars and requests) and StrategyWorker.cpp (producer of results).
+// Both sides include this header; the segment layout is versioned by kBridgeVersion.
+// ==================================================================================
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <new>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const uint32_t kBridgeMagic = 0x41464242;       // "AFBB"
+static const uint32_t kBridgeVersion = 3;
+static const uint32_t kBridgeToWorkerCapacity = 4096;  // Must be a power of two
+static const uint32_t kBridgeToStudyCapacity = 4096;
+static const size_t kBridgeCacheLine = 64;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "bridge indices must be lock-free across processes");
+
+enum BridgeMessageType : uint16_t {
+    BRIDGE_MSG_RESET = 1,           // Study -> worker: drop all bar history
+    BRIDGE_MSG_BAR,                 // Study -> worker: bar at barIndex (re-sent while forming)
+    BRIDGE_MSG_PROFILE_REQUEST,     // Study -> worker: build profile nodes for a window
+    BRIDGE_MSG_PROFILE_LEVEL,       // Worker -> study: one traded level of the requested profile
+    BRIDGE_MSG_PROFILE_END          // Worker -> study: request complete, levels may be applied
+};
+
+struct BridgeBar {
+    int32_t barIndex;
+    int32_t openTicks;
+    int32_t highTicks;
+    int32_t lowTicks;
+    int32_t closeTicks;
+    float volume;
+    float bidVolume;
+    float askVolume;
+    double dateTime;
+};
+
+struct BridgeProfileRequest {
+    uint32_t requestId;
+    int32_t startIndex;
+    int32_t endIndex;
+    float hvnMultiplier;
+    float lvnMultiplier;
+};
+
+struct BridgeProfileLevel {
+    uint32_t requestId;
+    int32_t priceTicks;
+    float volume;
+    uint8_t isHVN;
+    uint8_t isLVN;
+};
+
+struct BridgeProfileEnd {
+    uint32_t requestId;
+    int32_t endIndex;
+    int32_t levelCount;
+    uint32_t workerEpoch;           // Worker run that answered, see BridgeSegment::workerEpoch
+};
+
+// One message per cache line, so a handoff never shares a line with its neighbour
+struct alignas(kBridgeCacheLine) BridgeMessage {
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t sequence;
+    union {
+        BridgeBar bar;
+        BridgeProfileRequest request;
+        BridgeProfileLevel level;
+        BridgeProfileEnd end;
+    };
+};
+
+static_assert(sizeof(BridgeMessage) == kBridgeCacheLine, "bridge message must fill exactly one cache line");
+
+// Lamport ring with cached opposite index. The producer owns head and its copy of tail,
+// the consumer owns tail and its copy of head; each pair sits on its own cache line.
+template <uint32_t Capacity>
+struct SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "ring capacity must be a power of two");
+
+    alignas(kBridgeCacheLine) std::atomic<uint32_t> head;
+    uint32_t cachedTail;
+    alignas(kBridgeCacheLine) std::atomic<uint32_t> tail;
+    uint32_t cachedHead;
+    alignas(kBridgeCacheLine) BridgeMessage slots[Capacity];
+
+    bool TryPush(const BridgeMessage& message)
+    {
+        uint32_t writeIndex = head.load(std::memory_order_relaxed);
+        if (writeIndex - cachedTail == Capacity)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (writeIndex - cachedTail == Capacity) return false;
+        }
+        slots[writeIndex & (Capacity - 1)] = message;
+        head.store(writeIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(BridgeMessage& message)
+    {
+        uint32_t readIndex = tail.load(std::memory_order_relaxed);
+        if (readIndex == cachedHead)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (readIndex == cachedHead) return false;
+        }
+        message = slots[readIndex & (Capacity - 1)];
+        tail.store(readIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t FreeSlots() const
+    {
+        return Capacity - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+};
+
+struct BridgeSegment {
+    std::atomic<uint32_t> magic;            // Published last by the creator
+    uint32_t version;
+    std::atomic<uint32_t> workerHeartbeat;  // Bumped by the worker on every poll
+    std::atomic<uint32_t> studyHeartbeat;   // Bumped by the study on every call
+    std::atomic<uint32_t> producerOwner;    // Study instance feeding toWorker, 0 when unclaimed
+    std::atomic<uint32_t> workerEpoch;      // Bumped by each worker as it attaches, before it answers
+    SpscRing<kBridgeToWorkerCapacity> toWorker;
+    SpscRing<kBridgeToStudyCapacity> toStudy;
+};
+
+// Named shared-memory mapping of one BridgeSegment. The study creates it, the worker attaches.
+// A re-created study re-attaches to an existing segment and keeps the ring indices as they are.
+class BridgeMapping {
+public:
+    BridgeMapping() {}
+    ~BridgeMapping() { Close(); }
+    BridgeMapping(const BridgeMapping&) = delete;
+    BridgeMapping& operator=(const BridgeMapping&) = delete;
+
+    bool Open(const char* name, bool create)
+    {
+        Close();
+        if (!name || !*name) return false;
+
+        void* view = nullptr;
+#ifdef _WIN32
+        char mappingName[256];
+        std::snprintf(mappingName, sizeof(mappingName), "Local\\%s", name);
+        if (create)
+            m_handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                          static_cast<DWORD>(sizeof(BridgeSegment)), mappingName);
+        else
+            m_handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mappingName);
+        if (!m_handle) return false;
+        view = MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(BridgeSegment));
+#else
+        char mappingName[256];
+        std::snprintf(mappingName, sizeof(mappingName), "/%s", name);
+        m_fd = shm_open(mappingName, create ? (O_CREAT | O_RDWR) : O_RDWR, 0600);
+        if (m_fd < 0) return false;
+        if (create && ftruncate(m_fd, sizeof(BridgeSegment)) != 0)
+        {
+            Close();
+            return false;
+        }
+        view = mmap(nullptr, sizeof(BridgeSegment), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (view == MAP_FAILED) view = nullptr;
+#endif
+        if (!view)
+        {
+            Close();
+            return false;
+        }
+        m_segment = static_cast<BridgeSegment*>(view);
+
+        // Fresh mappings are zero-filled by the OS, which is a valid empty ring
+        if (create && m_segment->magic.load(std::memory_order_acquire) != kBridgeMagic)
+        {
+            m_segment->version = kBridgeVersion;
+            m_segment->magic.store(kBridgeMagic, std::memory_order_release);
+        }
+
+        if (m_segment->magic.load(std::memory_order_acquire) != kBridgeMagic || m_segment->version != kBridgeVersion)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (m_segment) UnmapViewOfFile(m_segment);
+        if (m_handle) CloseHandle(m_handle);
+        m_handle = nullptr;
+#else
+        if (m_segment) munmap(m_segment, sizeof(BridgeSegment));
+        if (m_fd >= 0) close(m_fd);
+        m_fd = -1;
+#endif
+        m_segment = nullptr;
+    }
+
+    BridgeSegment* Segment() const { return m_segment; }
+
+    // toWorker has exactly one producer. The owner token identifies a study instance and is
+    // stable across reloads, so the same instance can reclaim the ring after a restart while
+    // a second chart on the same name is refused.
+    bool ClaimProducer(uint32_t owner)
+    {
+        if (!m_segment || owner == 0) return false;
+        uint32_t current = 0;
+        if (m_segment->producerOwner.compare_exchange_strong(current, owner, std::memory_order_acq_rel))
+            return true;
+        return current == owner;
+    }
+
+    void ReleaseProducer(uint32_t owner)
+    {
+        if (!m_segment) return;
+        uint32_t current = owner;
+        m_segment->producerOwner.compare_exchange_strong(current, 0, std::memory_order_acq_rel);
+    }
+
+private:
+    BridgeSegment* m_segment = nullptr;
+#ifdef _WIN32
+    HANDLE m_handle = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
@@ -0,0 +1,137 @@
+// ==================================================================================
+// STRATEGY WORKER
+// Out-of-process analytics for the Advanced Order Flow Trading Bot (MAN.cpp).
+// Attaches to the study's shared-memory bridge, keeps its own copy of the bar
+// history and answers profile node requests, so the chart thread only publishes
+// bars and applies finished results.
+//
+// Build:  g++ -std=c++17 -O2 -o StrategyWorker StrategyWorker.cpp -lrt     (Linux)
+//         cl /std:c++17 /O2 /EHsc StrategyWorker.cpp                        (Windows)
+// Run:    StrategyWorker [bridge name]      default name: AOFB_Bridge
+// ==================================================================================
+#include "StrategyBridge.h"
+#include "ProfileNodes.h"
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+
+struct WorkerBarHistory {
+    std::vector<int32_t> lowTicks;
+    std::vector<int32_t> highTicks;
+    std::vector<float> volume;
+    int barCount = 0;
+};
+
+// Results go back to the study; the worker can afford to wait for ring space, the study cannot
+static void PushToStudy(BridgeSegment& segment, const BridgeMessage& message)
+{
+    while (!segment.toStudy.TryPush(message))
+    {
+        segment.workerHeartbeat.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+    }
+}
+
+static void StoreBar(WorkerBarHistory& history, const BridgeBar& bar)
+{
+    if (bar.barIndex < 0) return;
+
+    if (bar.barIndex >= static_cast<int>(history.lowTicks.size()))
+    {
+        size_t newSize = static_cast<size_t>(bar.barIndex) + 1;
+        history.lowTicks.resize(newSize, 0);
+        history.highTicks.resize(newSize, 0);
+        history.volume.resize(newSize, 0.0f);
+    }
+    history.lowTicks[bar.barIndex] = bar.lowTicks;
+    history.highTicks[bar.barIndex] = bar.highTicks;
+    history.volume[bar.barIndex] = bar.volume;
+    history.barCount = std::max(history.barCount, bar.barIndex + 1);
+}
+
+static void AnswerProfileRequest(BridgeSegment& segment, const WorkerBarHistory& history,
+                                 const BridgeProfileRequest& request, uint32_t epoch,
+                                 std::vector<float>& volumeAtTick, std::vector<VolumeProfileLevel>& levels)
+{
+    int startIndex = std::max(0, request.startIndex);
+    int endIndex = std::min(request.endIndex, history.barCount - 1);
+
+    BuildProfileNodes(history.lowTicks, history.highTicks, history.volume, startIndex, endIndex,
+                      request.hvnMultiplier, request.lvnMultiplier, volumeAtTick, levels);
+
+    BridgeMessage message = {};
+    message.type = BRIDGE_MSG_PROFILE_LEVEL;
+    for (const VolumeProfileLevel& level : levels)
+    {
+        message.level.requestId = request.requestId;
+        message.level.priceTicks = level.priceTicks;
+        message.level.volume = level.volume;
+        message.level.isHVN = level.isHVN ? 1 : 0;
+        message.level.isLVN = level.isLVN ? 1 : 0;
+        PushToStudy(segment, message);
+        message.sequence++;
+    }
+
+    BridgeMessage end = {};
+    end.type = BRIDGE_MSG_PROFILE_END;
+    end.end.requestId = request.requestId;
+    end.end.endIndex = request.endIndex;
+    end.end.levelCount = static_cast<int32_t>(levels.size());
+    end.end.workerEpoch = epoch;
+    PushToStudy(segment, end);
+}
+
+int main(int argc, char** argv)
+{
+    const char* bridgeName = (argc > 1) ? argv[1] : "AOFB_Bridge";
+
+    BridgeMapping mapping;
+    while (!mapping.Open(bridgeName, false))
+    {
+        std::printf("Waiting for study bridge '%s'...\n", bridgeName);
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    std::printf("Attached to study bridge '%s'\n", bridgeName);
+
+    // This run starts with no history; the study sees the new epoch and sends it all again
+    BridgeSegment& segment = *mapping.Segment();
+    uint32_t epoch = segment.workerEpoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+    WorkerBarHistory history;
+    std::vector<float> volumeAtTick;
+    std::vector<VolumeProfileLevel> levels;
+    int idlePolls = 0;
+
+    for (;;)
+    {
+        segment.workerHeartbeat.fetch_add(1, std::memory_order_relaxed);
+
+        BridgeMessage message;
+        if (!segment.toWorker.TryPop(message))
+        {
+            // Spin briefly for low handoff latency, then back off to keep a core free
+            if (++idlePolls < 1000)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+        idlePolls = 0;
+
+        switch (message.type)
+        {
+        case BRIDGE_MSG_RESET:
+            history = WorkerBarHistory();
+            break;
+        case BRIDGE_MSG_BAR:
+            StoreBar(history, message.bar);
+            break;
+        case BRIDGE_MSG_PROFILE_REQUEST:
+            AnswerProfileRequest(segment, history, message.request, epoch, volumeAtTick, levels);
+            break;
+        default:
+            break;
+        }
+    }
+}
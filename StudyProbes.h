@@ -0,0 +1,296 @@
+// ==================================================================================
+// STUDY PROBES
+// Stage markers for profiling the study outside Sierra. Without AOFB_PROBES (the Sierra
+// build) a probe expands to nothing. The headless engine defines AOFB_PROBES, and each
+// probe then becomes:
+//   - a pair of USDT probes, provider "aofb", stage__enter/stage__return with the stage
+//     name as argument, when <sys/sdt.h> is available. They are a nop until perf or
+//     bpftrace attaches.
+//   - on a thread that is recording, a node in that thread's stage tree, which collects
+//     call count and inclusive time. The trees are fixed size, so recording never
+//     allocates.
+//   - the thread's current stage, so an allocator that calls CountProbeAllocation charges
+//     each heap allocation to the innermost open stage while the thread is counting.
+// WriteFoldedStacks merges every thread's tree into folded stacks, one line per path
+// ("scsf_AdvancedOrderFlowBot;CollectStrategySignals;CheckStopRunAnticipation;FindSwingPoints
+// 81234"), weighted by self time in nanoseconds, as flamegraph.pl and speedscope read them.
+// ==================================================================================
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+enum ProbeStage {
+    PROBE_STUDY_CALL,
+    PROBE_PARAMETERS,
+    PROBE_TICK_SERIES,
+    PROBE_DEPTH,
+    PROBE_TAPE,
+    PROBE_TOXICITY,
+    PROBE_FOOTPRINT_EXPORT,
+    PROBE_BAR_BATCH,
+    PROBE_BACKFILL,
+    PROBE_RISK,
+    PROBE_ORDER_FLOW,
+    PROBE_VOLUME_PROFILE,
+    PROBE_SIGNALS,
+    PROBE_LIQUIDITY_ABSORPTION,
+    PROBE_ICEBERG_DETECTION,
+    PROBE_DELTA_DIVERGENCE,
+    PROBE_VOLUME_IMBALANCE,
+    PROBE_STOP_RUN,
+    PROBE_HVN_REJECTION,
+    PROBE_LVN_BREAKOUT,
+    PROBE_MOMENTUM_BREAKOUT,
+    PROBE_CUMULATIVE_DELTA,
+    PROBE_LIQUIDITY_TRAPS,
+    PROBE_SWING_POINTS,
+    PROBE_VOLATILITY,
+    PROBE_ORDER_ENTRY,
+    PROBE_STAGE_COUNT
+};
+
+// Frame names in the folded stacks; the study's function names, so graphs read like a profiler's
+static const char* const s_ProbeStageNames[PROBE_STAGE_COUNT] = {
+    "scsf_AdvancedOrderFlowBot", "RefreshParameterProfile", "UpdateTickPriceSeries", "UpdateDepthFeatures",
+    "PumpTimeAndSales", "FeedToxicityFromBars", "ExportClosedFootprints", "AdvanceBarBatch",
+    "BackfillVisibleSignals", "UpdateRiskMetrics", "UpdateOrderFlowDataAt", "ProcessVolumeProfile",
+    "CollectStrategySignals", "CheckLiquidityAbsorption", "CheckIcebergDetection", "CheckDeltaDivergence",
+    "CheckVolumeImbalance", "CheckStopRunAnticipation", "CheckHVNRejection", "CheckLVNBreakout",
+    "CheckMomentumBreakout", "CheckCumulativeDeltaTrend", "CheckLiquidityTraps", "FindSwingPoints",
+    "CalculateVolatility", "OrderEntry"
+};
+
+// Allocations made outside every stage are charged to this extra slot
+static const int kProbeOutsideStages = PROBE_STAGE_COUNT;
+
+inline const char* ProbeSlotName(int slot)
+{
+    return slot < PROBE_STAGE_COUNT ? s_ProbeStageNames[slot] : "(outside stages)";
+}
+
+#ifdef AOFB_PROBES
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define AOFB_USDT_ENTER(stage) DTRACE_PROBE1(aofb, stage__enter, s_ProbeStageNames[stage])
+#define AOFB_USDT_RETURN(stage) DTRACE_PROBE1(aofb, stage__return, s_ProbeStageNames[stage])
+#endif
+#endif
+#ifndef AOFB_USDT_ENTER
+#define AOFB_USDT_ENTER(stage) ((void)0)
+#define AOFB_USDT_RETURN(stage) ((void)0)
+#endif
+
+static const int kProbeTreeNodes = 512;     // Stage paths per thread; time on paths past it stays with the parent
+static const int kProbeMaxDepth = 32;
+
+// One thread's stage call tree. Node 0 is the root and is never timed.
+struct ProbeTree {
+    struct Node {
+        int16_t stage;
+        int16_t parent;
+        int16_t firstChild;
+        int16_t nextSibling;
+        uint64_t calls;
+        uint64_t nanos;         // Inclusive
+    };
+
+    Node nodes[kProbeTreeNodes];
+    int nodeCount = 1;
+    int current = 0;
+    int depth = 0;
+    int entered[kProbeMaxDepth];            // Node timed at each depth, -1 when the tree was full
+    int64_t started[kProbeMaxDepth];
+    bool recording = false;
+
+    ProbeTree() { nodes[0] = Node{-1, -1, -1, -1, 0, 0}; }
+
+    static int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Enter(int stage)
+    {
+        if (depth >= kProbeMaxDepth)
+        {
+            depth++;
+            return;
+        }
+        int node = nodes[current].firstChild;
+        while (node >= 0 && nodes[node].stage != stage) node = nodes[node].nextSibling;
+        if (node < 0 && nodeCount < kProbeTreeNodes)
+        {
+            node = nodeCount++;
+            nodes[node] = Node{static_cast<int16_t>(stage), static_cast<int16_t>(current),
+                               -1, nodes[current].firstChild, 0, 0};
+            nodes[current].firstChild = static_cast<int16_t>(node);
+        }
+        entered[depth] = node;
+        if (node >= 0)
+        {
+            current = node;
+            started[depth] = Now();
+        }
+        depth++;
+    }
+
+    void Exit()
+    {
+        if (--depth >= kProbeMaxDepth) return;
+        int node = entered[depth];
+        if (node < 0) return;
+        nodes[node].calls++;
+        nodes[node].nanos += static_cast<uint64_t>(Now() - started[depth]);
+        current = nodes[node].parent;
+    }
+};
+
+// Every thread's tree, kept after the thread exits so a shutdown report still sees it
+inline std::mutex& ProbeRegistryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+inline std::vector<std::unique_ptr<ProbeTree>>& ProbeRegistry()
+{
+    static std::vector<std::unique_ptr<ProbeTree>> trees;
+    return trees;
+}
+
+inline ProbeTree*& ThreadProbeTree()
+{
+    static thread_local ProbeTree* tree = nullptr;
+    return tree;
+}
+
+// Heap allocations per stage slot. Thread-local and trivially initialized, so the allocator
+// can update it from any thread at any time without allocating itself.
+struct ProbeAllocations {
+    uint64_t count[PROBE_STAGE_COUNT + 1];
+    uint64_t bytes[PROBE_STAGE_COUNT + 1];
+};
+
+struct ProbeThreadState {
+    int stage = kProbeOutsideStages;        // Innermost open stage
+    bool countAllocations = false;
+    ProbeAllocations allocations = {};
+};
+
+inline ProbeThreadState& ThreadProbeState()
+{
+    static thread_local ProbeThreadState state;
+    return state;
+}
+
+// Starts or stops charging the calling thread's allocations to stages
+inline void SetAllocationCounting(bool counting)
+{
+    ThreadProbeState().countAllocations = counting;
+}
+
+// For a global operator new; a no-op unless the thread is counting
+inline void CountProbeAllocation(size_t bytes)
+{
+    ProbeThreadState& state = ThreadProbeState();
+    if (!state.countAllocations) return;
+    state.allocations.count[state.stage]++;
+    state.allocations.bytes[state.stage] += bytes;
+}
+
+// Starts or stops timing stages on the calling thread; its tree is created on first use
+inline void SetProbeRecording(bool recording)
+{
+    ProbeTree*& tree = ThreadProbeTree();
+    if (!tree)
+    {
+        if (!recording) return;
+        std::lock_guard<std::mutex> lock(ProbeRegistryMutex());
+        ProbeRegistry().emplace_back(new ProbeTree());
+        tree = ProbeRegistry().back().get();
+    }
+    tree->recording = recording;
+}
+
+class ProbeScope {
+public:
+    explicit ProbeScope(ProbeStage stage) : m_stage(stage)
+    {
+        AOFB_USDT_ENTER(stage);
+        int& current = ThreadProbeState().stage;
+        m_outerStage = current;
+        current = stage;
+        ProbeTree* tree = ThreadProbeTree();
+        if (tree && tree->recording)
+        {
+            m_tree = tree;
+            tree->Enter(stage);
+        }
+    }
+
+    ~ProbeScope()
+    {
+        if (m_tree) m_tree->Exit();
+        ThreadProbeState().stage = m_outerStage;
+        AOFB_USDT_RETURN(m_stage);
+    }
+
+    ProbeScope(const ProbeScope&) = delete;
+    ProbeScope& operator=(const ProbeScope&) = delete;
+
+private:
+    ProbeStage m_stage;
+    int m_outerStage;
+    ProbeTree* m_tree = nullptr;
+};
+
+// Self time of node and its subtree into folded, keyed by the path from the root
+inline void FoldProbeNode(const ProbeTree& tree, int node, const std::string& prefix,
+                          std::map<std::string, uint64_t>& folded)
+{
+    const ProbeTree::Node& entry = tree.nodes[node];
+    std::string path = prefix.empty() ? s_ProbeStageNames[entry.stage] : prefix + ";" + s_ProbeStageNames[entry.stage];
+    uint64_t childNanos = 0;
+    for (int child = entry.firstChild; child >= 0; child = tree.nodes[child].nextSibling)
+    {
+        childNanos += tree.nodes[child].nanos;
+        FoldProbeNode(tree, child, path, folded);
+    }
+    if (entry.nanos > childNanos) folded[path] += entry.nanos - childNanos;
+}
+
+// Call once recording threads are idle. Returns the number of stacks written, -1 if the file cannot be opened.
+inline int WriteFoldedStacks(const std::string& path)
+{
+    std::map<std::string, uint64_t> folded;
+    {
+        std::lock_guard<std::mutex> lock(ProbeRegistryMutex());
+        for (const std::unique_ptr<ProbeTree>& tree : ProbeRegistry())
+            for (int child = tree->nodes[0].firstChild; child >= 0; child = tree->nodes[child].nextSibling)
+                FoldProbeNode(*tree, child, std::string(), folded);
+    }
+
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return -1;
+    for (const std::pair<const std::string, uint64_t>& stack : folded)
+        std::fprintf(file, "%s %llu\n", stack.first.c_str(), static_cast<unsigned long long>(stack.second));
+    std::fclose(file);
+    return static_cast<int>(folded.size());
+}
+
+#define AOFB_PROBE_JOIN2(a, b) a##b
+#define AOFB_PROBE_JOIN(a, b) AOFB_PROBE_JOIN2(a, b)
+#define AOFB_PROBE(stage) ProbeScope AOFB_PROBE_JOIN(probeScope, __LINE__)(stage)
+#else
+#define AOFB_PROBE(stage) ((void)0)
+#endif
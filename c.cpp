@@ -66,6 +66,29 @@ struct TradeInfo {
     float UnrealizedPnL;
 };
 
+// Open trades, stored by column. The per-tick exit check reads only the hot columns, which
+// are cache-line aligned and span two lines each for a full table; bookkeeping is cold.
+const int MaxOpenTrades = 32;
+
+struct OpenTradeDetails {
+    int TradeID;
+    int StrategyType;
+    float Target2;
+    SCDateTime EntryTime;
+    int EntryIndex;     // Bars up to and including this one cannot exit the trade
+};
+
+struct OpenTradeTable {
+    alignas(64) int Direction[MaxOpenTrades];
+    alignas(64) float EntryPrice[MaxOpenTrades];
+    alignas(64) float StopLoss[MaxOpenTrades];
+    alignas(64) float Target[MaxOpenTrades];
+    alignas(64) int Quantity[MaxOpenTrades];
+    OpenTradeDetails Details[MaxOpenTrades];
+    int Count;
+    int NextTradeID;
+};
+
 /*==========================================================================*/
 // Main Study Function
 /*==========================================================================*/
@@ -169,15 +192,37 @@ SCSFExport scsf_OrderFlowTradingBot(SCStudyInterfaceRef sc)
         return;
     }
     
+    // Release the open-trade table when the study is removed
+    if (sc.LastCallToFunction) {
+        delete (OpenTradeTable*)sc.GetPersistentPointer(1);
+        sc.SetPersistentPointer(1, NULL);
+        return;
+    }
+    
     // Persistent variables
     int& LastProcessedIndex = sc.GetPersistentInt(1);
     float& DailyPnL = sc.GetPersistentFloat(1);
     float& CumulativeDelta = sc.GetPersistentFloat(2);
     int& ActiveTrades = sc.GetPersistentInt(2);
     
+    OpenTradeTable* OpenTrades = (OpenTradeTable*)sc.GetPersistentPointer(1);
+    if (OpenTrades == NULL) {
+        OpenTrades = new OpenTradeTable();
+        sc.SetPersistentPointer(1, OpenTrades);
+    }
+    
+    // A recalculation replays history from the first bar; trades opened on the live bars
+    // would otherwise be checked against it
+    if (sc.IsFullRecalculation && sc.Index == 0)
+        OpenTrades->Count = 0;
+    
     // Get current bar index
     int CurrentIndex = sc.Index;
     
+    // Stops and targets are checked on every update, not only on new bars
+    ManageActiveTrades(sc, CurrentIndex, *OpenTrades);
+    ActiveTrades = OpenTrades->Count;
+    
     // Skip if not new bar or insufficient data
     if (CurrentIndex < 10 || CurrentIndex <= LastProcessedIndex)
         return;
@@ -203,9 +248,7 @@ SCSFExport scsf_OrderFlowTradingBot(SCStudyInterfaceRef sc)
     
     // Execute enabled strategies
     ExecuteStrategies(sc, CurrentIndex, orderFlow, CumulativeDelta);
-    
-    // Update trade management
-    ManageActiveTrades(sc, CurrentIndex);
+    ActiveTrades = OpenTrades->Count;
     
     // Log system status
     LogSystemStatus(sc, CurrentIndex, orderFlow, DailyPnL, ActiveTrades);
@@ -607,20 +650,62 @@ void ExecuteTrade(SCStudyInterfaceRef sc, const TradeInfo& trade, int Direction)
     
     sc.AddMessageToLog(tradeMsg, 0);
     
+    // Track the trade until its stop or first target is reached
+    OpenTradeTable* OpenTrades = (OpenTradeTable*)sc.GetPersistentPointer(1);
+    if (OpenTrades == NULL || OpenTrades->Count >= MaxOpenTrades)
+        return;
+    
+    int Slot = OpenTrades->Count++;
+    OpenTrades->Direction[Slot] = Direction;
+    OpenTrades->EntryPrice[Slot] = trade.EntryPrice;
+    OpenTrades->StopLoss[Slot] = trade.StopLoss;
+    OpenTrades->Target[Slot] = trade.Target1;
+    OpenTrades->Quantity[Slot] = trade.Quantity;
+    OpenTrades->Details[Slot].TradeID = ++OpenTrades->NextTradeID;
+    OpenTrades->Details[Slot].StrategyType = trade.StrategyType;
+    OpenTrades->Details[Slot].Target2 = trade.Target2;
+    OpenTrades->Details[Slot].EntryTime = sc.BaseDateTimeIn[sc.Index];
+    OpenTrades->Details[Slot].EntryIndex = sc.Index;
+    
     // Here you would add actual order submission code
     // Example: sc.BuyEntry(), sc.SellEntry(), etc.
 }
 
-void ManageActiveTrades(SCStudyInterfaceRef sc, int Index)
+void ManageActiveTrades(SCStudyInterfaceRef sc, int Index, OpenTradeTable& Trades)
 {
-    // Trade management logic - monitor stops, targets, trailing stops, etc.
-    // This would track open positions and manage exits
-    
-    float CurrentPrice = sc.Close[Index];
-    
-    // Example of basic trade management
-    // In real implementation, you'd iterate through active trades
-    // and check exit conditions
+    // A bar that reaches both the stop and the target is counted as stopped out.
+    // The P&L is only logged: these are signals, not fills, so it stays out of the daily total.
+    float BarHigh = sc.High[Index];
+    float BarLow = sc.Low[Index];
+    float PointValue = (sc.TickSize > 0) ? sc.CurrencyValuePerTick / sc.TickSize : 0.0f;
+    
+    for (int t = 0; t < Trades.Count; ) {
+        int Direction = Trades.Direction[t];
+        bool StopHit = (Direction > 0) ? (BarLow <= Trades.StopLoss[t]) : (BarHigh >= Trades.StopLoss[t]);
+        bool TargetHit = (Direction > 0) ? (BarHigh >= Trades.Target[t]) : (BarLow <= Trades.Target[t]);
+        // The entry bar's own range came before the entry; the cold column is read only on a hit
+        if ((!StopHit && !TargetHit) || Index <= Trades.Details[t].EntryIndex) {
+            t++;
+            continue;
+        }
+        
+        float ExitPrice = StopHit ? Trades.StopLoss[t] : Trades.Target[t];
+        float TradePnL = (ExitPrice - Trades.EntryPrice[t]) * Direction * Trades.Quantity[t] * PointValue;
+        SCString exitMsg;
+        exitMsg.Format("TRADE EXIT - ID: %d, Strategy: %d, %s at %.2f, P&L: %.2f",
+                      Trades.Details[t].TradeID, Trades.Details[t].StrategyType,
+                      StopHit ? "Stop" : "Target", ExitPrice, TradePnL);
+        sc.AddMessageToLog(exitMsg, 0);
+        
+        // Swap the last trade into the freed slot; order does not matter
+        int Last = --Trades.Count;
+        Trades.Direction[t] = Trades.Direction[Last];
+        Trades.EntryPrice[t] = Trades.EntryPrice[Last];
+        Trades.StopLoss[t] = Trades.StopLoss[Last];
+        Trades.Target[t] = Trades.Target[Last];
+        Trades.Quantity[t] = Trades.Quantity[Last];
+        Trades.Details[t] = Trades.Details[Last];
+    }
 }
 
 void LogSystemStatus(SCStudyInterfaceRef sc, int Index, const OrderFlowData& orderFlow, 
@@ -0,0 +1,358 @@
+// ==================================================================================
+// BAR STORE
+// Local compressed bar history the headless engine recovers feed gaps from. One file
+// per symbol (<dir>/<symbol>.afs): a file header, then self-contained blocks. Inside a
+// block, prices are tick counts stored as zigzag varint deltas (open against the prior
+// close, high/low/close against the open), time as milliseconds since the prior bar and
+// volumes as varints, so a typical bar takes 10-14 bytes instead of a 48-byte BarRecord.
+// Block headers carry the first bar index and payload size, so a reader finds a range
+// without decoding anything before it.
+//
+// The recorder (the feed, or a capture process next to it) appends final bars and
+// flushes once per feed frame, before the frame goes out, so every bar the engine can
+// miss is already on disk. A flush extends the open block in place: payload first, then
+// the header's counts, so a reader never sees a count without its bytes. Volumes are
+// whole contracts; prices must be on tick.
+// ==================================================================================
+#pragma once
+#include "HeadlessProtocol.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+static const uint32_t kStoreFileMagic = 0x31534641;    // "AFS1"
+static const uint32_t kStoreBlockMagic = 0x31424641;   // "AFB1"
+static const int kStoreBlockBars = 256;
+
+struct StoreFileHeader {
+    uint32_t magic;
+    uint32_t reserved;
+    double tickSize;
+    char symbol[32];
+};
+
+struct StoreBlockHeader {
+    uint32_t magic;
+    int32_t firstBarIndex;
+    uint32_t barCount;
+    uint32_t payloadBytes;
+    int64_t baseTimeMs;         // Time of the bar before the block's first bar (its own time if none)
+    int32_t baseCloseTicks;     // Close of the bar before the block's first bar
+    uint32_t reserved;
+};
+
+static_assert(sizeof(StoreFileHeader) == 48, "store file header layout");
+static_assert(sizeof(StoreBlockHeader) == 32, "store block header layout");
+
+inline std::string BarStorePath(const std::string& directory, const std::string& symbol)
+{
+    return directory + "/" + symbol + ".afs";
+}
+
+inline void PutVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+inline void PutSigned(std::vector<uint8_t>& out, int64_t value)
+{
+    PutVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+inline bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7)
+    {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline bool GetSigned(const uint8_t*& p, const uint8_t* end, int64_t& value)
+{
+    uint64_t raw;
+    if (!GetVarint(p, end, raw)) return false;
+    value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+}
+
+inline int64_t BarTimeMs(double dateTime) { return std::llround(dateTime * 86400000.0); }
+
+class BarStoreWriter {
+public:
+    ~BarStoreWriter() { Close(); }
+
+    // Starts a new store for the session, replacing any previous one
+    bool Open(const std::string& directory, const std::string& symbol, double tickSize)
+    {
+        Close();
+        if (tickSize <= 0.0) return false;
+        m_fd = ::open(BarStorePath(directory, symbol).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) return false;
+
+        StoreFileHeader header = {};
+        header.magic = kStoreFileMagic;
+        header.tickSize = tickSize;
+        std::strncpy(header.symbol, symbol.c_str(), sizeof(header.symbol) - 1);
+        m_tickSize = tickSize;
+        m_blockOpen = false;
+        m_fileSize = sizeof(header);
+        return WriteAt(&header, sizeof(header), 0);
+    }
+
+    // Bars must arrive in index order; each is recorded once, when final
+    void Append(const BarRecord& bar)
+    {
+        if (m_fd < 0) return;
+        m_pending.push_back(bar);
+    }
+
+    // Makes every appended bar readable
+    bool Flush()
+    {
+        bool written = true;
+        size_t next = 0;
+        while (m_fd >= 0 && written && next < m_pending.size())
+        {
+            if (!m_blockOpen) StartBlock(m_pending[next]);
+
+            m_payload.clear();
+            for (; next < m_pending.size() && m_block.barCount < static_cast<uint32_t>(kStoreBlockBars); next++)
+            {
+                EncodeBar(m_pending[next]);
+                m_block.barCount++;
+            }
+            written = WriteAt(m_payload.data(), m_payload.size(), m_fileSize);
+            m_fileSize += static_cast<off_t>(m_payload.size());
+            m_block.payloadBytes += static_cast<uint32_t>(m_payload.size());
+            written = written && WriteAt(&m_block, sizeof(m_block), m_blockOffset);
+            if (m_block.barCount == static_cast<uint32_t>(kStoreBlockBars)) m_blockOpen = false;
+        }
+        m_pending.clear();
+        return written && m_fd >= 0;
+    }
+
+    void Close()
+    {
+        if (m_fd < 0) return;
+        Flush();
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+private:
+    int32_t Ticks(float price) const { return static_cast<int32_t>(std::lround(price / m_tickSize)); }
+
+    // Each block restarts its deltas from the previous bar, so it decodes on its own
+    void StartBlock(const BarRecord& first)
+    {
+        m_block = StoreBlockHeader();
+        m_block.magic = kStoreBlockMagic;
+        m_block.firstBarIndex = first.barIndex;
+        m_block.baseTimeMs = m_hasPrior ? m_priorTimeMs : BarTimeMs(first.dateTime);
+        m_block.baseCloseTicks = m_hasPrior ? m_priorCloseTicks : Ticks(first.open);
+        m_blockOffset = m_fileSize;
+        m_fileSize += static_cast<off_t>(sizeof(m_block));
+        m_blockOpen = true;
+    }
+
+    void EncodeBar(const BarRecord& bar)
+    {
+        int64_t timeMs = BarTimeMs(bar.dateTime);
+        int32_t open = Ticks(bar.open);
+        int32_t close = Ticks(bar.close);
+        int64_t priorTimeMs = m_hasPrior ? m_priorTimeMs : m_block.baseTimeMs;
+        int32_t priorCloseTicks = m_hasPrior ? m_priorCloseTicks : m_block.baseCloseTicks;
+        PutSigned(m_payload, timeMs - priorTimeMs);
+        PutSigned(m_payload, open - priorCloseTicks);
+        PutSigned(m_payload, Ticks(bar.high) - open);
+        PutSigned(m_payload, open - Ticks(bar.low));
+        PutSigned(m_payload, close - open);
+        PutVarint(m_payload, static_cast<uint64_t>(std::llround(std::max(0.0f, bar.volume))));
+        PutVarint(m_payload, static_cast<uint64_t>(std::llround(std::max(0.0f, bar.bidVolume))));
+        PutVarint(m_payload, static_cast<uint64_t>(std::llround(std::max(0.0f, bar.askVolume))));
+        PutVarint(m_payload, bar.numTrades);
+        m_hasPrior = true;
+        m_priorTimeMs = timeMs;
+        m_priorCloseTicks = close;
+    }
+
+    bool WriteAt(const void* data, size_t size, off_t offset)
+    {
+        const char* p = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            ssize_t n = ::pwrite(m_fd, p, size, offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            p += n;
+            size -= static_cast<size_t>(n);
+            offset += n;
+        }
+        return true;
+    }
+
+    int m_fd = -1;
+    double m_tickSize = 0.0;
+    off_t m_fileSize = 0;
+    std::vector<BarRecord> m_pending;
+    std::vector<uint8_t> m_payload;
+    StoreBlockHeader m_block = {};
+    off_t m_blockOffset = 0;
+    bool m_blockOpen = false;
+    bool m_hasPrior = false;
+    int64_t m_priorTimeMs = 0;
+    int32_t m_priorCloseTicks = 0;
+};
+
+// Reads ranges back by bar index. Block positions are indexed as the file is scanned and
+// the scan resumes where it stopped, so repeated recoveries only read new blocks' headers.
+class BarStoreReader {
+public:
+    ~BarStoreReader() { Close(); }
+
+    bool Open(const std::string& directory, const std::string& symbol)
+    {
+        Close();
+        m_fd = ::open(BarStorePath(directory, symbol).c_str(), O_RDONLY);
+        if (m_fd < 0) return false;
+
+        StoreFileHeader header;
+        if (::pread(m_fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+            header.magic != kStoreFileMagic || header.tickSize <= 0.0)
+        {
+            Close();
+            return false;
+        }
+        m_tickSize = header.tickSize;
+        m_scanOffset = sizeof(header);
+        return true;
+    }
+
+    bool IsOpen() const { return m_fd >= 0; }
+
+    // Appends bars firstIndex..lastIndex to out; false unless the whole range was found
+    bool Read(int firstIndex, int lastIndex, std::vector<BarRecord>& out)
+    {
+        if (m_fd < 0 || lastIndex < firstIndex) return false;
+        ScanNewBlocks();
+
+        // Blocks are in index order: start at the last one beginning at or before firstIndex
+        size_t before = out.size();
+        std::vector<BlockEntry>::const_iterator block = std::upper_bound(m_blocks.begin(), m_blocks.end(), firstIndex,
+            [](int index, const BlockEntry& entry) { return index < entry.header.firstBarIndex; });
+        if (block != m_blocks.begin()) --block;
+        for (; block != m_blocks.end() && block->header.firstBarIndex <= lastIndex; ++block)
+        {
+            if (!DecodeBlock(*block, firstIndex, lastIndex, out)) break;
+        }
+
+        size_t expected = static_cast<size_t>(lastIndex - firstIndex + 1);
+        if (out.size() - before == expected && out[before].barIndex == firstIndex && out.back().barIndex == lastIndex)
+            return true;
+        out.resize(before);
+        return false;
+    }
+
+    void Close()
+    {
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+        m_blocks.clear();
+    }
+
+private:
+    struct BlockEntry {
+        StoreBlockHeader header;
+        off_t payloadOffset;
+    };
+
+    // The last block may still be growing: its header is re-read and the scan resumes after it
+    void ScanNewBlocks()
+    {
+        struct stat info;
+        if (::fstat(m_fd, &info) != 0) return;
+        if (!m_blocks.empty())
+        {
+            BlockEntry& last = m_blocks.back();
+            off_t headerOffset = last.payloadOffset - static_cast<off_t>(sizeof(StoreBlockHeader));
+            StoreBlockHeader header;
+            if (::pread(m_fd, &header, sizeof(header), headerOffset) == static_cast<ssize_t>(sizeof(header)) &&
+                header.magic == kStoreBlockMagic && header.barCount >= last.header.barCount)
+                last.header = header;
+            m_scanOffset = last.payloadOffset + static_cast<off_t>(last.header.payloadBytes);
+        }
+        while (m_scanOffset + static_cast<off_t>(sizeof(StoreBlockHeader)) <= info.st_size)
+        {
+            BlockEntry entry;
+            if (::pread(m_fd, &entry.header, sizeof(entry.header), m_scanOffset) != static_cast<ssize_t>(sizeof(entry.header)) ||
+                entry.header.magic != kStoreBlockMagic)
+                return;
+            entry.payloadOffset = m_scanOffset + static_cast<off_t>(sizeof(entry.header));
+            if (entry.payloadOffset + static_cast<off_t>(entry.header.payloadBytes) > info.st_size) return;
+            m_blocks.push_back(entry);
+            m_scanOffset = entry.payloadOffset + static_cast<off_t>(entry.header.payloadBytes);
+        }
+    }
+
+    bool DecodeBlock(const BlockEntry& block, int firstIndex, int lastIndex, std::vector<BarRecord>& out)
+    {
+        m_payload.resize(block.header.payloadBytes);
+        if (::pread(m_fd, m_payload.data(), m_payload.size(), block.payloadOffset) != static_cast<ssize_t>(m_payload.size()))
+            return false;
+
+        const uint8_t* p = m_payload.data();
+        const uint8_t* end = p + m_payload.size();
+        int64_t timeMs = block.header.baseTimeMs;
+        int64_t closeTicks = block.header.baseCloseTicks;
+        for (uint32_t b = 0; b < block.header.barCount; b++)
+        {
+            int64_t timeDelta, openDelta, highDelta, lowDelta, closeDelta;
+            uint64_t volume, bidVolume, askVolume, numTrades;
+            if (!GetSigned(p, end, timeDelta) || !GetSigned(p, end, openDelta) || !GetSigned(p, end, highDelta) ||
+                !GetSigned(p, end, lowDelta) || !GetSigned(p, end, closeDelta) || !GetVarint(p, end, volume) ||
+                !GetVarint(p, end, bidVolume) || !GetVarint(p, end, askVolume) || !GetVarint(p, end, numTrades))
+                return false;
+
+            timeMs += timeDelta;
+            int64_t openTicks = closeTicks + openDelta;
+            closeTicks = openTicks + closeDelta;
+
+            int index = block.header.firstBarIndex + static_cast<int>(b);
+            if (index < firstIndex || index > lastIndex) continue;
+
+            BarRecord bar = {};
+            bar.barIndex = index;
+            bar.dateTime = timeMs / 86400000.0;
+            bar.open = Price(openTicks);
+            bar.high = Price(openTicks + highDelta);
+            bar.low = Price(openTicks - lowDelta);
+            bar.close = Price(closeTicks);
+            bar.volume = static_cast<float>(volume);
+            bar.bidVolume = static_cast<float>(bidVolume);
+            bar.askVolume = static_cast<float>(askVolume);
+            bar.numTrades = static_cast<uint32_t>(numTrades);
+            out.push_back(bar);
+        }
+        return true;
+    }
+
+    float Price(int64_t ticks) const { return static_cast<float>(ticks * m_tickSize); }
+
+    int m_fd = -1;
+    double m_tickSize = 0.0;
+    off_t m_scanOffset = 0;
+    std::vector<BlockEntry> m_blocks;
+    std::vector<uint8_t> m_payload;
+};
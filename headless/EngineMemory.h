@@ -0,0 +1,171 @@
+// ==================================================================================
+// ENGINE MEMORY
+// Arenas for the headless engine's long-lived buffers: each symbol's chart arrays and
+// the feed thread's frame buffers. An arena is one anonymous mapping, on huge pages
+// when asked, pre-faulted by the thread that will use it so Linux's first-touch policy
+// places it on that thread's NUMA node. Allocation is a bump pointer and blocks are
+// only reclaimed with the arena, so arrays are reserved up front and spill to the
+// heap if they outgrow it. An arena is used by one thread at a time.
+// ==================================================================================
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const size_t kHugePageBytes = 2u << 20;
+
+enum ArenaPageKind {
+    ARENA_PAGES_NONE,           // Not mapped
+    ARENA_PAGES_SMALL,          // Regular pages
+    ARENA_PAGES_TRANSPARENT,    // Regular mapping with MADV_HUGEPAGE, 2 MB aligned
+    ARENA_PAGES_HUGETLB         // Reserved huge pages (vm.nr_hugepages)
+};
+
+inline const char* ArenaPageKindName(ArenaPageKind kind)
+{
+    switch (kind)
+    {
+        case ARENA_PAGES_SMALL:       return "small pages";
+        case ARENA_PAGES_TRANSPARENT: return "transparent huge pages";
+        case ARENA_PAGES_HUGETLB:     return "hugetlb pages";
+        default:                      return "unmapped";
+    }
+}
+
+class MemoryArena {
+public:
+    MemoryArena() {}
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+    ~MemoryArena() { Release(); }
+
+    // Reserved huge pages first, then a 2 MB aligned regular mapping advised for THP
+    bool Map(size_t bytes, bool hugePages)
+    {
+        Release();
+        size_t size = (bytes + kHugePageBytes - 1) & ~(kHugePageBytes - 1);
+        if (size == 0) return false;
+
+#ifdef MAP_HUGETLB
+        if (hugePages)
+        {
+            void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (base != MAP_FAILED)
+            {
+                Adopt(static_cast<char*>(base), size, ARENA_PAGES_HUGETLB);
+                return true;
+            }
+        }
+#endif
+
+        // Over-map by one huge page and trim, so THP can back the whole range
+        size_t mapped = size + kHugePageBytes;
+        void* raw = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) return false;
+        uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (start + kHugePageBytes - 1) & ~(static_cast<uintptr_t>(kHugePageBytes) - 1);
+        if (aligned > start) ::munmap(raw, aligned - start);
+        if (start + mapped > aligned + size)
+            ::munmap(reinterpret_cast<void*>(aligned + size), start + mapped - (aligned + size));
+
+        ArenaPageKind kind = ARENA_PAGES_SMALL;
+#ifdef MADV_HUGEPAGE
+        if (hugePages && ::madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE) == 0)
+            kind = ARENA_PAGES_TRANSPARENT;
+#endif
+        Adopt(reinterpret_cast<char*>(aligned), size, kind);
+        return true;
+    }
+
+    // Writes one byte per page from the calling thread, which is where first touch places it
+    void Prefault()
+    {
+        long pageBytes = ::sysconf(_SC_PAGESIZE);
+        size_t step = (m_kind == ARENA_PAGES_HUGETLB || pageBytes <= 0) ? kHugePageBytes : static_cast<size_t>(pageBytes);
+        volatile char* base = m_base;
+        for (size_t offset = 0; offset < m_size; offset += step) base[offset] = 0;
+    }
+
+    // nullptr when the arena is full; callers fall back to the heap
+    void* Allocate(size_t bytes, size_t alignment)
+    {
+        size_t offset = (m_used + alignment - 1) & ~(alignment - 1);
+        if (!m_base || offset + bytes > m_size) return nullptr;
+        m_used = offset + bytes;
+        return m_base + offset;
+    }
+
+    bool Owns(const void* pointer) const
+    {
+        const char* p = static_cast<const char*>(pointer);
+        return m_base && p >= m_base && p < m_base + m_size;
+    }
+
+    size_t Size() const { return m_size; }
+    size_t Used() const { return m_used; }
+    ArenaPageKind PageKind() const { return m_kind; }
+
+private:
+    void Adopt(char* base, size_t size, ArenaPageKind kind)
+    {
+        m_base = base;
+        m_size = size;
+        m_used = 0;
+        m_kind = kind;
+    }
+
+    void Release()
+    {
+        if (m_base) ::munmap(m_base, m_size);
+        m_base = nullptr;
+        m_size = 0;
+        m_used = 0;
+        m_kind = ARENA_PAGES_NONE;
+    }
+
+    char* m_base = nullptr;
+    size_t m_size = 0;
+    size_t m_used = 0;
+    ArenaPageKind m_kind = ARENA_PAGES_NONE;
+};
+
+// Standard allocator over an optional arena: without one, or once it is full, it is the heap.
+// Blocks are cache-line aligned so arrays from one arena never share a line.
+template <typename T>
+struct ArenaAllocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    MemoryArena* arena = nullptr;
+
+    ArenaAllocator() {}
+    explicit ArenaAllocator(MemoryArena* owner) : arena(owner) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count)
+    {
+        if (arena)
+        {
+            void* block = arena->Allocate(count * sizeof(T), alignof(T) > 64 ? alignof(T) : 64);
+            if (block) return static_cast<T*>(block);
+        }
+        return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t)
+    {
+        if (arena && arena->Owns(pointer)) return;
+        ::operator delete(pointer);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena == b.arena; }
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena != b.arena; }
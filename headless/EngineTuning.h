@@ -0,0 +1,168 @@
+// ==================================================================================
+// ENGINE TUNING
+// Deployment knobs for the headless engine: CPU lists and thread pinning, NUMA node
+// lookup, the key/value config file, and the latency histogram the engine keeps for
+// the strategy loop. Linux only; pinning failures are reported and otherwise ignored.
+// ==================================================================================
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// "2-5,8" -> {2, 3, 4, 5, 8}
+inline bool ParseCpuList(const std::string& text, std::vector<int>& cpus)
+{
+    cpus.clear();
+    size_t position = 0;
+    while (position < text.size())
+    {
+        size_t comma = text.find(',', position);
+        std::string item = text.substr(position, comma == std::string::npos ? std::string::npos : comma - position);
+        int first = 0, last = 0;
+        if (std::sscanf(item.c_str(), "%d-%d", &first, &last) == 2) {}
+        else if (std::sscanf(item.c_str(), "%d", &first) == 1) last = first;
+        else return false;
+        if (first < 0 || last < first || last >= CPU_SETSIZE) return false;
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+        if (comma == std::string::npos) break;
+        position = comma + 1;
+    }
+    return !cpus.empty();
+}
+
+inline bool PinCurrentThread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+}
+
+// NUMA node of a CPU from sysfs, 0 when the machine does not expose one
+inline int NumaNodeOfCpu(int cpu)
+{
+    for (int node = 0; node < 64; node++)
+    {
+        char path[96];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+        if (::access(path, F_OK) == 0) return node;
+    }
+    return 0;
+}
+
+// Config file lines are long options without the dashes: "workers 4", "input 3=20".
+// Blank lines and '#' comments are skipped; an optional '=' after the key is accepted.
+inline bool ReadConfigFile(const std::string& path, std::vector<std::string>& arguments)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        size_t keyStart = line.find_first_not_of(" \t\r");
+        if (keyStart == std::string::npos) continue;
+        size_t keyEnd = line.find_first_of(" \t=", keyStart);
+        arguments.push_back("--" + line.substr(keyStart, keyEnd - keyStart));
+        if (keyEnd == std::string::npos) continue;
+
+        size_t valueStart = line.find_first_not_of(" \t", keyEnd);
+        if (valueStart != std::string::npos && line[valueStart] == '=')
+            valueStart = line.find_first_not_of(" \t", valueStart + 1);
+        size_t valueEnd = line.find_last_not_of(" \t\r");
+        if (valueStart != std::string::npos && valueEnd >= valueStart)
+            arguments.push_back(line.substr(valueStart, valueEnd - valueStart + 1));
+    }
+    return true;
+}
+
+// Log-linear histogram of nanosecond latencies: 16 sub-buckets per power of two,
+// so any percentile is within about 6% of the true value. Fixed size, no allocation.
+class LatencyHistogram {
+public:
+    void Record(uint64_t nanoseconds)
+    {
+        m_buckets[BucketOf(nanoseconds)]++;
+        m_count++;
+        if (nanoseconds > m_max) m_max = nanoseconds;
+    }
+
+    void Merge(const LatencyHistogram& other)
+    {
+        for (int b = 0; b < kBucketCount; b++) m_buckets[b] += other.m_buckets[b];
+        m_count += other.m_count;
+        if (other.m_max > m_max) m_max = other.m_max;
+    }
+
+    // Upper edge of the bucket holding the given quantile (0..1)
+    uint64_t Percentile(double quantile) const
+    {
+        if (m_count == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(m_count - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < kBucketCount; b++)
+        {
+            seen += m_buckets[b];
+            if (seen >= rank)
+            {
+                uint64_t edge = UpperEdgeOf(b);
+                return edge < m_max ? edge : m_max;
+            }
+        }
+        return m_max;
+    }
+
+    uint64_t Count() const { return m_count; }
+    uint64_t Max() const { return m_max; }
+
+private:
+    static const int kSubBucketBits = 4;
+    static const int kBucketCount = 64 << kSubBucketBits;
+
+    static int BucketOf(uint64_t value)
+    {
+        if (value < (1u << kSubBucketBits)) return static_cast<int>(value);
+        int exponent = 63 - __builtin_clzll(value);
+        int subBucket = static_cast<int>((value >> (exponent - kSubBucketBits)) & ((1u << kSubBucketBits) - 1));
+        return ((exponent - kSubBucketBits + 1) << kSubBucketBits) + subBucket;
+    }
+
+    static uint64_t UpperEdgeOf(int bucket)
+    {
+        if (bucket < (1 << kSubBucketBits)) return static_cast<uint64_t>(bucket);
+        int exponent = (bucket >> kSubBucketBits) + kSubBucketBits - 1;
+        uint64_t subBucket = static_cast<uint64_t>(bucket & ((1 << kSubBucketBits) - 1));
+        return ((uint64_t(1) << kSubBucketBits) + subBucket + 1) << (exponent - kSubBucketBits);
+    }
+
+    uint64_t m_buckets[kBucketCount] = {};
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+};
+
+// Runtime options that place threads and memory; all off by default
+struct EngineTuning {
+    int feedCpu = -1;               // Core for the feed/gateway I/O thread
+    std::vector<int> workerCpus;    // Worker w runs on workerCpus[w % size]
+    bool hugePages = false;         // Arenas on hugetlb pages, else transparent huge pages
+    bool numaLocal = false;         // Workers steal only within their NUMA node
+    int barCapacity = 0;            // Bars reserved per symbol in its arena; 0 keeps arrays on the heap
+};
+
+// "on", "yes", "1" and their opposites
+inline bool ParseSwitch(const std::string& text, bool& value)
+{
+    if (text == "on" || text == "yes" || text == "1") value = true;
+    else if (text == "off" || text == "no" || text == "0") value = false;
+    else return false;
+    return true;
+}
@@ -0,0 +1,81 @@
+// ==================================================================================
+// ORDER GATEWAY STUB
+// Stand-in for the execution gateway: accepts one engine connection, logs every order
+// and fills it in full at its reference price plus optional adverse slippage. Fills for
+// one incoming frame go back as one frame.
+//
+// Build:  g++ -std=c++17 -O2 -o aofb_gateway headless/GatewayStub.cpp
+// Run:    aofb_gateway unix:/tmp/aofb_gateway.sock [slippage in price units]
+// ==================================================================================
+#include "HeadlessProtocol.h"
+#include <memory>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+    std::string path;
+    if (argc < 2 || !ParseUnixEndpoint(argv[1], path))
+    {
+        std::fprintf(stderr, "usage: aofb_gateway unix:<path> [slippage]\n");
+        return 2;
+    }
+    float slippage = (argc > 2) ? static_cast<float>(std::atof(argv[2])) : 0.0f;
+
+    std::signal(SIGPIPE, SIG_IGN);
+    int listenFd = ListenUnixSocket(path);
+    if (listenFd < 0)
+    {
+        std::fprintf(stderr, "cannot listen on '%s'\n", path.c_str());
+        return 1;
+    }
+    std::printf("gateway listening on %s\n", path.c_str());
+    std::fflush(stdout);
+
+    for (;;)
+    {
+        int engineFd = ::accept(listenFd, nullptr, nullptr);
+        if (engineFd < 0) continue;
+        std::printf("engine connected\n");
+        std::fflush(stdout);
+
+        std::unique_ptr<FrameReader> reader(new FrameReader());
+        FrameWriter fills;
+        unsigned long long orderCount = 0;
+
+        while (reader->Fill(engineFd) > 0)
+        {
+            while (const FrameHeader* header = reader->Next())
+            {
+                if (header->type != FRAME_ORDERS) continue;
+                const OrderRecord* orders = FrameReader::Records<OrderRecord>(header);
+                for (int r = 0; orders && r < header->recordCount; r++)
+                {
+                    const OrderRecord& order = orders[r];
+                    FillRecord* fill = fills.Reserve<FillRecord>(FRAME_FILLS);
+                    fill->symbolId = order.symbolId;
+                    fill->orderId = order.orderId;
+                    fill->side = order.side;
+                    fill->quantity = order.quantity;
+                    fill->price = order.referencePrice + order.side * slippage;
+                    fill->flags = order.flags;
+                    fill->dateTime = order.dateTime;
+
+                    const char* kind = (order.flags & ORDER_ENTRY) ? "ENTRY" : (order.flags & ORDER_EXIT) ? "EXIT" : "FLATTEN";
+                    std::printf("order %u symbol %u %s %s %d @ %.4f (stop %.4f target %.4f)\n", order.orderId,
+                                order.symbolId, kind, order.side > 0 ? "BUY" : "SELL", order.quantity,
+                                fill->price, order.stopOffset, order.targetOffset);
+                    orderCount++;
+                }
+                fills.CloseFrame();
+            }
+            if (reader->IsCorrupt() || !fills.Flush(engineFd)) break;
+            std::fflush(stdout);
+        }
+
+        std::printf("engine disconnected after %llu orders\n", orderCount);
+        std::fflush(stdout);
+        ::close(engineFd);
+    }
+}
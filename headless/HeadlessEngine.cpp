@@ -0,0 +1,1208 @@
+// ==================================================================================
+// HEADLESS ENGINE
+// Runs the Advanced Order Flow Trading Bot study (MAN.cpp, compiled unchanged against
+// headless/sierrachart.h) as a Linux daemon. Bars arrive as framed batches from a Unix
+// socket or a replay file; entries, exits and flattens go to the order gateway as
+// framed batches, one study call and one write per feed frame.
+//
+// Build:  g++ -std=c++17 -O2 -fno-omit-frame-pointer -pthread -Iheadless -o aofb_engine headless/HeadlessEngine.cpp
+// Run:    aofb_engine --feed unix:/tmp/aofb_feed.sock --gateway unix:/tmp/aofb_gateway.sock --workers 4
+//         aofb_engine --feed replay:session.bin [--input 3=20 --input 21=09:30:00 ...]
+// Without --gateway, orders are filled in-process at the reference price (paper mode).
+// With --workers N, symbols run on a work-stealing pool; 0 (default) runs them on the feed thread.
+// --config <file> reads the same options from a file; see headless/engine.conf.example for
+// CPU pinning, huge pages and NUMA placement. Strategy-loop latency is reported on shutdown.
+// With --store DIR, bars lost between the feed and the engine are recovered from the feed's
+// bar store (headless/BarStore.h) and replayed into the study as one catch-up batch.
+// Bars are taken to be in the host's local time zone, as a chart would show them; set
+// --chart-utc-offset MINUTES when the feed's bars are stamped in another zone.
+// A study that sets sc.UpdateAlways is also called on a 250 ms timer while its feed is quiet,
+// as Sierra does; replays run without the timer so their results do not depend on timing.
+// SIGUSR1 writes every symbol's recent decision trace to the log; the study is not called.
+// The study is built with its stage probes (StudyProbes.h): USDT probes for perf and bpftrace,
+// and with --profile-stages <file> a folded-stack profile of the replay, optionally limited
+// to one session with --profile-session YYYY-MM-DD. Frame pointers keep perf's stacks cheap.
+// --allocations report|check counts the heap allocations of steady-state study calls by stage;
+// check exits with status 3 if any stage allocated more per call than --allocation-baseline
+// allows (headless/allocation_baseline.conf), or at all without a baseline.
+// ==================================================================================
+#define AOFB_PROBES
+#include "../MAN.cpp"
+#include "HeadlessProtocol.h"
+#include "WorkStealingScheduler.h"
+#include "EngineTuning.h"
+#include "BarStore.h"
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <climits>
+#include <thread>
+#include <csignal>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+
+// ==================================================================================
+// ALLOCATION COUNTING
+// The engine replaces the global allocator so --allocations can charge every heap
+// allocation to the study stage that made it (StudyProbes.h). A thread that is not
+// counting pays one thread-local test per allocation.
+// ==================================================================================
+
+void* operator new(std::size_t bytes)
+{
+    CountProbeAllocation(bytes);
+    void* block = std::malloc(bytes ? bytes : 1);
+    if (!block) throw std::bad_alloc();
+    return block;
+}
+
+void* operator new(std::size_t bytes, std::align_val_t alignment)
+{
+    CountProbeAllocation(bytes);
+    size_t align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    void* block = nullptr;
+    if (::posix_memalign(&block, align, bytes ? bytes : 1) != 0) throw std::bad_alloc();
+    return block;
+}
+
+// Not inlined, or GCC pairs the free with the new-expression and warns of a mismatch
+__attribute__((noinline)) void operator delete(void* block) noexcept { std::free(block); }
+__attribute__((noinline)) void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+__attribute__((noinline)) void operator delete(void* block, std::align_val_t) noexcept { std::free(block); }
+__attribute__((noinline)) void operator delete(void* block, std::size_t, std::align_val_t) noexcept { std::free(block); }
+
+static volatile std::sig_atomic_t s_StopRequested = 0;
+static volatile std::sig_atomic_t s_TraceDumpRequested = 0;
+
+static const double kUnixEpochInSCDays = 25569.0;   // 1970-01-01 as an SCDateTime
+static const int kHostTimeZone = INT_MIN;           // Chart time is the host's local time
+static const int kDefaultAllocationWarmup = 100;    // Study calls per symbol before its steady state
+
+enum AllocationMode {
+    ALLOCATIONS_OFF,
+    ALLOCATIONS_REPORT,     // Steady-state allocations by stage on shutdown
+    ALLOCATIONS_CHECK       // The same, and exit status 3 if a stage exceeded its baseline
+};
+
+// One symbol's steady-state study calls: after its warm-up, excluding requested trace dumps
+struct AllocationTally {
+    ProbeAllocations totals = {};
+    uint64_t calls = 0;
+    uint64_t worstCall = 0;     // Most allocations in one call
+    int worstBar = -1;          // Newest bar of that call
+    int firstBar = -1;          // Newest bar of the first call that allocated
+    int firstStage = -1;        // Stage that allocated most in that call
+};
+
+struct InputOverride {
+    int index;
+    std::string value;
+};
+
+struct OpenBracket {
+    uint32_t entryOrderId = 0;
+    float stopOffset = 0.0f;
+    float targetOffset = 0.0f;
+    double stopPrice = 0.0;
+    double targetPrice = 0.0;
+    bool armed = false;         // Entry filled, stop and target are live
+    bool exitPending = false;   // Exit sent, waiting for its fill
+};
+
+// Order states the study can look up with sc.GetOrderByOrderID; older ids are forgotten
+static const int kRecentOrders = 16;
+
+class HeadlessEngine;
+
+// Everything one feed or gateway frame carried for one symbol
+struct PipelineBatch {
+    std::vector<BarRecord> bars;
+    std::vector<FillRecord> fills;
+    bool timer = false;             // Timer call for a study that asked for sc.UpdateAlways
+    bool dumpTrace = false;         // Log the study's decision trace, without calling the study
+};
+
+// One charted symbol: its own study instance, bars and simulated bracket. Batches are
+// queued by the I/O thread and drained by exactly one worker at a time, in arrival order.
+struct SymbolPipeline : public HeadlessOrderRouter, public ScheduledTask {
+    HeadlessEngine* engine = nullptr;
+    std::mutex inboxMutex;
+    std::deque<PipelineBatch> inbox;
+    uint32_t symbolId = 0;
+    SCStudyInterface sc;
+    bool hasRun = false;
+    int firstDirtyIndex = INT_MAX;  // Lowest bar changed since the study last ran
+    SCDateTime lastDataTime;        // sc.LatestDateTimeForLastBar, fixed when the bar arrives
+    int priorArraySize = 0;
+    double pointValue = 0.0;
+    int tradingDate = -1;
+    OpenBracket bracket;
+    s_SCTradeOrder recentOrders[kRecentOrders];     // By order id modulo kRecentOrders
+    int entriesSent = 0;
+    int fills = 0;
+    MemoryArena arena;              // Bar and subgraph arrays, mapped by the first thread to run the symbol
+    bool memoryReady = false;
+    LatencyHistogram loopLatency;   // One sample per study call
+    int studyCalls = 0;
+    AllocationTally allocations;
+    BarStoreReader store;           // Opened at the first gap
+    std::vector<BarRecord> recovered;
+    int feedIndexOffset = 0;        // Feed bar index minus chart index, after gaps the store could not fill
+    int barsRecovered = 0;
+    std::atomic<bool> wantsTimer{false};    // sc.UpdateAlways after the last study call
+
+    int SubmitEntry(SCStudyInterface& study, int side, const s_SCNewOrder& order) override;
+    int Flatten(SCStudyInterface& study) override;
+    bool GetOrder(int orderId, s_SCTradeOrder& order) override;
+    void Log(SCStudyInterface& study, const char* message) override;
+
+    void Run() override;
+    bool HasPendingWork() override
+    {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        return !inbox.empty();
+    }
+};
+
+class HeadlessEngine {
+public:
+    bool paperMode = true;
+    bool replayClock = false;
+    int chartUtcOffsetMinutes = kHostTimeZone;     // Time zone the bars are stamped in
+    int gatewayFd = -1;
+    int workerCount = 0;
+    std::string storeDir;
+    std::string profilePath;        // Folded stage stacks written here on shutdown
+    AllocationMode allocationMode = ALLOCATIONS_OFF;
+    int allocationWarmup = kDefaultAllocationWarmup;
+    double allocationBaseline[PROBE_STAGE_COUNT + 1] = {};     // Allocations per call each stage may make
+    bool allocationCheckFailed = false;
+    int profileDate = -1;           // Only calls whose newest bar is on this date are profiled
+    EngineTuning tuning;
+    std::atomic<bool> gatewayFailed{false};
+    std::vector<InputOverride> inputOverrides;
+
+    void Start();
+
+    SymbolPipeline* FindPipeline(uint32_t symbolId)
+    {
+        std::unordered_map<uint32_t, std::unique_ptr<SymbolPipeline>>::iterator it = m_pipelines.find(symbolId);
+        return it == m_pipelines.end() ? nullptr : it->second.get();
+    }
+
+    void HandleFrame(const FrameHeader* header);
+    void HandleFills(const FrameHeader* header);
+    void HandleTimer();
+    void RequestTraceDump();
+    int TimerFd() const { return m_timerPipe[0]; }
+    void DrainPipeline(SymbolPipeline& pipeline);
+    void Shutdown();
+    void ReportAllocations(SymbolPipeline& pipeline);
+
+    uint32_t SendOrder(SymbolPipeline& pipeline, int side, int quantity, uint32_t flags,
+                       double referencePrice, float stopOffset, float targetOffset);
+    void ApplyFill(SymbolPipeline& pipeline, const FillRecord& fill);
+
+private:
+    void DefineSymbol(const SymbolRecord& record);
+    PipelineBatch& BatchFor(SymbolPipeline* pipeline);
+    void DispatchBatches();
+    void ApplyBar(SymbolPipeline& pipeline, const BarRecord& record);
+    void WriteBar(SymbolPipeline& pipeline, int index, const BarRecord& record);
+    int RecoverGap(SymbolPipeline& pipeline, int feedIndex);
+    void PreparePipelineMemory(SymbolPipeline& pipeline);
+    bool RunPipeline(SymbolPipeline& pipeline, bool timerCall);
+    void TimerLoop();
+    void CheckBracket(SymbolPipeline& pipeline);
+    bool FlushOrders();
+    SCDateTime Now(const SymbolPipeline& pipeline) const;
+    SCDateTime LastDataTime(const SymbolPipeline& pipeline, const SCDateTime& now) const;
+
+    std::unordered_map<uint32_t, std::unique_ptr<SymbolPipeline>> m_pipelines;
+    std::vector<std::pair<SymbolPipeline*, PipelineBatch>> m_frameBatches;    // Batches of the frame being read
+    WorkStealingScheduler m_scheduler;
+    bool m_feedSequenceKnown = false;
+    uint32_t m_nextFeedSequence = 0;
+    std::mutex m_ordersMutex;
+    FrameWriter m_orders;
+    std::atomic<uint32_t> m_nextOrderId{1};
+    int m_timerPipe[2] = {-1, -1};  // Timer thread -> feed thread ticks
+    std::thread m_timer;
+    std::atomic<bool> m_timerStop{false};
+};
+
+static const int kTimerMillis = 250;
+
+// ==================================================================================
+// ORDER ROUTING (called from inside the study)
+// ==================================================================================
+
+int SymbolPipeline::SubmitEntry(SCStudyInterface& study, int side, const s_SCNewOrder& order)
+{
+    if (order.OrderQuantity <= 0 || sc.Position.PositionQuantity != 0 || bracket.entryOrderId != 0) return 0;
+
+    double referencePrice = study.Close[study.ArraySize - 1];
+    uint32_t orderId = engine->SendOrder(*this, side, order.OrderQuantity, ORDER_ENTRY, referencePrice,
+                                         static_cast<float>(order.Stop1Offset), static_cast<float>(order.Target1Offset));
+    entriesSent++;
+    return static_cast<int>(orderId);
+}
+
+int SymbolPipeline::Flatten(SCStudyInterface& study)
+{
+    int quantity = static_cast<int>(std::lround(std::fabs(sc.Position.PositionQuantity)));
+    if (quantity == 0 || bracket.exitPending) return 0;
+
+    int side = (sc.Position.PositionQuantity > 0) ? -1 : 1;
+    bracket.exitPending = true;
+    return static_cast<int>(engine->SendOrder(*this, side, quantity, ORDER_FLATTEN,
+                                              study.Close[study.ArraySize - 1], 0.0f, 0.0f));
+}
+
+bool SymbolPipeline::GetOrder(int orderId, s_SCTradeOrder& order)
+{
+    const s_SCTradeOrder& recent = recentOrders[static_cast<uint32_t>(orderId) % kRecentOrders];
+    if (orderId <= 0 || recent.InternalOrderID != orderId) return false;
+    order = recent;
+    return true;
+}
+
+void SymbolPipeline::Log(SCStudyInterface& study, const char* message)
+{
+    std::fprintf(stderr, "[%s] %s\n", study.Symbol.GetChars(), message);
+}
+
+void SymbolPipeline::Run()
+{
+    engine->DrainPipeline(*this);
+}
+
+// ==================================================================================
+// ENGINE
+// ==================================================================================
+
+uint32_t HeadlessEngine::SendOrder(SymbolPipeline& pipeline, int side, int quantity, uint32_t flags,
+                                   double referencePrice, float stopOffset, float targetOffset)
+{
+    uint32_t orderId = m_nextOrderId++;
+    s_SCTradeOrder& state = pipeline.recentOrders[orderId % kRecentOrders];
+    state = s_SCTradeOrder();
+    state.InternalOrderID = static_cast<int>(orderId);
+    state.OrderStatusCode = SCT_OSC_OPEN;
+    state.OrderQuantity = quantity;
+    if (flags & ORDER_ENTRY)
+    {
+        pipeline.bracket = OpenBracket();
+        pipeline.bracket.entryOrderId = orderId;
+        pipeline.bracket.stopOffset = stopOffset;
+        pipeline.bracket.targetOffset = targetOffset;
+    }
+
+    SCDateTime now = Now(pipeline);
+    if (paperMode)
+    {
+        FillRecord fill = {};
+        fill.symbolId = pipeline.symbolId;
+        fill.orderId = orderId;
+        fill.side = side;
+        fill.quantity = quantity;
+        fill.price = static_cast<float>(referencePrice);
+        fill.flags = flags;
+        fill.dateTime = now.GetAsDouble();
+        ApplyFill(pipeline, fill);
+        return orderId;
+    }
+
+    std::lock_guard<std::mutex> lock(m_ordersMutex);
+    OrderRecord* order = m_orders.Reserve<OrderRecord>(FRAME_ORDERS);
+    order->symbolId = pipeline.symbolId;
+    order->orderId = orderId;
+    order->side = side;
+    order->quantity = quantity;
+    order->flags = flags;
+    order->referencePrice = static_cast<float>(referencePrice);
+    order->stopOffset = stopOffset;
+    order->targetOffset = targetOffset;
+    order->dateTime = now.GetAsDouble();
+    return orderId;
+}
+
+void HeadlessEngine::ApplyFill(SymbolPipeline& pipeline, const FillRecord& fill)
+{
+    s_SCPositionData& position = pipeline.sc.Position;
+    double signedQuantity = static_cast<double>(fill.side) * fill.quantity;
+    double previous = position.PositionQuantity;
+
+    if (previous == 0 || (previous > 0) == (signedQuantity > 0))
+    {
+        double total = previous + signedQuantity;
+        position.AveragePrice = (position.AveragePrice * std::fabs(previous) + fill.price * std::fabs(signedQuantity)) /
+                                std::fabs(total);
+        position.PositionQuantity = total;
+    }
+    else
+    {
+        double closing = std::min(std::fabs(previous), std::fabs(signedQuantity));
+        double direction = (previous > 0) ? 1.0 : -1.0;
+        position.DailyProfitLoss += (fill.price - position.AveragePrice) * closing * direction * pipeline.pointValue;
+        position.PositionQuantity = previous + signedQuantity;
+        if (position.PositionQuantity != 0 && (position.PositionQuantity > 0) != (previous > 0))
+            position.AveragePrice = fill.price;     // Reversed through zero
+    }
+    pipeline.fills++;
+
+    s_SCTradeOrder& order = pipeline.recentOrders[fill.orderId % kRecentOrders];
+    if (order.InternalOrderID == static_cast<int>(fill.orderId))
+    {
+        double filled = order.FilledQuantity + fill.quantity;
+        order.AvgFillPrice = (order.AvgFillPrice * order.FilledQuantity + fill.price * fill.quantity) / filled;
+        order.FilledQuantity = filled;
+        if (filled >= order.OrderQuantity) order.OrderStatusCode = SCT_OSC_FILLED;
+    }
+
+    OpenBracket& bracket = pipeline.bracket;
+    if (position.PositionQuantity == 0)
+    {
+        bracket = OpenBracket();
+        position.AveragePrice = 0;
+        position.OpenProfitLoss = 0;
+    }
+    else if ((fill.flags & ORDER_ENTRY) && fill.orderId == bracket.entryOrderId)
+    {
+        double direction = (position.PositionQuantity > 0) ? 1.0 : -1.0;
+        bracket.stopPrice = fill.price - direction * bracket.stopOffset;
+        bracket.targetPrice = fill.price + direction * bracket.targetOffset;
+        bracket.armed = bracket.stopOffset > 0.0f || bracket.targetOffset > 0.0f;
+    }
+
+    SCString logMsg;
+    logMsg.Format("FILL order %u %s %d @ %.2f  position %.0f  daily P&L $%.2f", fill.orderId,
+                  fill.side > 0 ? "BUY" : "SELL", fill.quantity, fill.price,
+                  position.PositionQuantity, position.DailyProfitLoss);
+    pipeline.Log(pipeline.sc, logMsg);
+}
+
+void HeadlessEngine::DefineSymbol(const SymbolRecord& record)
+{
+    if (FindPipeline(record.symbolId)) return;
+
+    std::unique_ptr<SymbolPipeline> pipeline(new SymbolPipeline());
+    pipeline->engine = this;
+    pipeline->symbolId = record.symbolId;
+
+    SCStudyInterface& sc = pipeline->sc;
+    char symbol[sizeof(record.symbol) + 1] = {};
+    std::memcpy(symbol, record.symbol, sizeof(record.symbol));
+    sc.Symbol = symbol;
+    sc.TickSize = record.tickSize;
+    sc.CurrencyValuePerTick = record.currencyValuePerTick;
+    sc.OrderRouter = pipeline.get();
+    sc.ChartNumber = static_cast<int>(m_pipelines.size()) + 1;    // Each symbol stands in for its own chart
+    pipeline->homeWorker = static_cast<int>(m_pipelines.size());
+    pipeline->pointValue = (record.tickSize > 0.0f) ? record.currencyValuePerTick / record.tickSize : 0.0;
+
+    sc.SetDefaults = 1;
+    scsf_AdvancedOrderFlowBot(sc);
+    sc.SetDefaults = 0;
+
+    for (const InputOverride& input : inputOverrides)
+    {
+        if (input.index < 0 || input.index >= 128 || !sc.Input[input.index].SetFromText(input.value))
+            std::fprintf(stderr, "[%s] ignoring --input %d=%s\n", symbol, input.index, input.value.c_str());
+    }
+
+    std::fprintf(stderr, "[%s] defined: tick %.6g, $%.4g per tick\n", symbol, record.tickSize, record.currencyValuePerTick);
+    m_pipelines[record.symbolId] = std::move(pipeline);
+}
+
+void HeadlessEngine::Start()
+{
+    if (!replayClock && ::pipe(m_timerPipe) == 0)
+    {
+        ::fcntl(m_timerPipe[0], F_SETFL, O_NONBLOCK);
+        ::fcntl(m_timerPipe[1], F_SETFL, O_NONBLOCK);
+        m_timer = std::thread(&HeadlessEngine::TimerLoop, this);
+    }
+
+    if (workerCount <= 0) return;
+
+    std::vector<int> stealDomains;
+    for (int w = 0; tuning.numaLocal && !tuning.workerCpus.empty() && w < workerCount; w++)
+        stealDomains.push_back(NumaNodeOfCpu(tuning.workerCpus[w % tuning.workerCpus.size()]));
+
+    const std::vector<int> cpus = tuning.workerCpus;
+    m_scheduler.Start(workerCount, [cpus](int worker) {
+        if (cpus.empty()) return;
+        int cpu = cpus[worker % cpus.size()];
+        if (!PinCurrentThread(cpu)) std::fprintf(stderr, "worker %d: cannot pin to cpu %d\n", worker, cpu);
+    }, stealDomains);
+
+    for (int w = 0; w < workerCount && !tuning.workerCpus.empty(); w++)
+    {
+        int cpu = tuning.workerCpus[w % tuning.workerCpus.size()];
+        std::fprintf(stderr, "worker %d: cpu %d, node %d\n", w, cpu, NumaNodeOfCpu(cpu));
+    }
+}
+
+PipelineBatch& HeadlessEngine::BatchFor(SymbolPipeline* pipeline)
+{
+    for (std::pair<SymbolPipeline*, PipelineBatch>& entry : m_frameBatches)
+        if (entry.first == pipeline) return entry.second;
+    m_frameBatches.emplace_back(pipeline, PipelineBatch());
+    return m_frameBatches.back().second;
+}
+
+// Hands each symbol its part of the frame; inline mode drains it on this thread
+void HeadlessEngine::DispatchBatches()
+{
+    for (std::pair<SymbolPipeline*, PipelineBatch>& entry : m_frameBatches)
+    {
+        SymbolPipeline* pipeline = entry.first;
+        {
+            std::lock_guard<std::mutex> lock(pipeline->inboxMutex);
+            pipeline->inbox.push_back(std::move(entry.second));
+        }
+        if (workerCount > 0)
+            m_scheduler.Schedule(pipeline);
+        else
+            DrainPipeline(*pipeline);
+    }
+    m_frameBatches.clear();
+}
+
+void HeadlessEngine::HandleFrame(const FrameHeader* header)
+{
+    // The feed numbers its frames; the bars of lost frames are recovered per symbol in ApplyBar
+    if (m_feedSequenceKnown && header->sequence != m_nextFeedSequence)
+        std::fprintf(stderr, "feed: frames %u-%u lost\n", m_nextFeedSequence, header->sequence - 1);
+    m_feedSequenceKnown = true;
+    m_nextFeedSequence = header->sequence + 1;
+
+    if (header->type == FRAME_SYMBOL)
+    {
+        const SymbolRecord* records = FrameReader::Records<SymbolRecord>(header);
+        for (int r = 0; records && r < header->recordCount; r++)
+            DefineSymbol(records[r]);
+    }
+    else if (header->type == FRAME_BARS)
+    {
+        const BarRecord* records = FrameReader::Records<BarRecord>(header);
+        for (int r = 0; records && r < header->recordCount; r++)
+        {
+            SymbolPipeline* pipeline = FindPipeline(records[r].symbolId);
+            if (pipeline) BatchFor(pipeline).bars.push_back(records[r]);
+        }
+        DispatchBatches();
+    }
+    else if (header->type == FRAME_END)
+    {
+        s_StopRequested = 1;
+    }
+}
+
+void HeadlessEngine::HandleFills(const FrameHeader* header)
+{
+    if (header->type != FRAME_FILLS) return;
+
+    const FillRecord* records = FrameReader::Records<FillRecord>(header);
+    for (int r = 0; records && r < header->recordCount; r++)
+    {
+        SymbolPipeline* pipeline = FindPipeline(records[r].symbolId);
+        if (pipeline) BatchFor(pipeline).fills.push_back(records[r]);
+    }
+    DispatchBatches();
+}
+
+// Sierra's chart update timer. The thread only ticks a pipe; the feed thread owns the pipelines,
+// so it queues the timer calls like any other batch. A full pipe already holds a pending tick.
+void HeadlessEngine::TimerLoop()
+{
+    while (!m_timerStop)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(kTimerMillis));
+        char tick = 1;
+        ssize_t written = ::write(m_timerPipe[1], &tick, 1);
+        (void)written;
+    }
+}
+
+// Feed thread: one timer call for each idle symbol whose study asked for sc.UpdateAlways
+void HeadlessEngine::HandleTimer()
+{
+    char ticks[64];
+    while (::read(m_timerPipe[0], ticks, sizeof(ticks)) > 0) {}
+
+    for (std::unordered_map<uint32_t, std::unique_ptr<SymbolPipeline>>::iterator it = m_pipelines.begin();
+         it != m_pipelines.end(); ++it)
+    {
+        SymbolPipeline* pipeline = it->second.get();
+        if (pipeline->wantsTimer && !pipeline->HasPendingWork())
+            BatchFor(pipeline).timer = true;
+    }
+    DispatchBatches();
+}
+
+void HeadlessEngine::RequestTraceDump()
+{
+    for (std::unordered_map<uint32_t, std::unique_ptr<SymbolPipeline>>::iterator it = m_pipelines.begin();
+         it != m_pipelines.end(); ++it)
+        BatchFor(it->second.get()).dumpTrace = true;
+    DispatchBatches();
+}
+
+// Charges the calling thread's allocations since before to one study call whose newest bar is bar
+static void TallyAllocations(AllocationTally& tally, const ProbeAllocations& before, int bar)
+{
+    const ProbeAllocations& after = ThreadProbeState().allocations;
+    uint64_t callAllocations = 0;
+    uint64_t heaviest = 0;
+    int heaviestStage = -1;
+    for (int slot = 0; slot <= PROBE_STAGE_COUNT; slot++)
+    {
+        uint64_t count = after.count[slot] - before.count[slot];
+        if (count == 0) continue;
+        tally.totals.count[slot] += count;
+        tally.totals.bytes[slot] += after.bytes[slot] - before.bytes[slot];
+        callAllocations += count;
+        if (count > heaviest)
+        {
+            heaviest = count;
+            heaviestStage = slot;
+        }
+    }
+
+    tally.calls++;
+    if (callAllocations > tally.worstCall)
+    {
+        tally.worstCall = callAllocations;
+        tally.worstBar = bar;
+    }
+    if (callAllocations > 0 && tally.firstBar < 0)
+    {
+        tally.firstBar = bar;
+        tally.firstStage = heaviestStage;
+    }
+}
+
+// Runs on whichever worker holds the pipeline; nothing else touches its study meanwhile
+void HeadlessEngine::DrainPipeline(SymbolPipeline& pipeline)
+{
+    if (!pipeline.memoryReady) PreparePipelineMemory(pipeline);
+
+    for (;;)
+    {
+        PipelineBatch batch;
+        {
+            std::lock_guard<std::mutex> lock(pipeline.inboxMutex);
+            if (pipeline.inbox.empty()) return;
+            batch = std::move(pipeline.inbox.front());
+            pipeline.inbox.pop_front();
+        }
+
+        // Fills first, so the study sees the position they produce
+        for (const FillRecord& fill : batch.fills)
+            ApplyFill(pipeline, fill);
+        for (const BarRecord& bar : batch.bars)
+            ApplyBar(pipeline, bar);
+
+        if (!profilePath.empty())
+            SetProbeRecording(profileDate < 0 ||
+                              (pipeline.sc.ArraySize > 0 && pipeline.sc.BaseDateTimeIn[pipeline.sc.ArraySize - 1].GetDate() == profileDate));
+
+        // Steady state starts once the symbol is past its full recalculation and warm-up
+        bool countAllocations = allocationMode != ALLOCATIONS_OFF &&
+                                pipeline.studyCalls >= std::max(1, allocationWarmup);
+        ProbeAllocations allocationsBefore = ThreadProbeState().allocations;
+        SetAllocationCounting(countAllocations);
+
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        bool ran = RunPipeline(pipeline, batch.timer);
+        if (ran)
+            pipeline.loopLatency.Record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count()));
+
+        SetAllocationCounting(false);
+        if (ran)
+        {
+            pipeline.studyCalls++;
+            if (countAllocations) TallyAllocations(pipeline.allocations, allocationsBefore, pipeline.sc.ArraySize - 1);
+        }
+        if (!FlushOrders()) gatewayFailed = true;
+
+        // Only reads the trace ring: no study call, so no orders and no new trace records
+        const DecisionTraceRing* trace = (const DecisionTraceRing*)pipeline.sc.GetPersistentPointer(16);
+        if (batch.dumpTrace && trace)
+            DumpDecisionTrace(pipeline.sc, *trace, kDecisionTraceBars, "requested");
+    }
+}
+
+// Runs on the thread that first drains the symbol, so first touch puts the arena on its node
+void HeadlessEngine::PreparePipelineMemory(SymbolPipeline& pipeline)
+{
+    pipeline.memoryReady = true;
+    if (tuning.barCapacity <= 0) return;
+
+    SCStudyInterface& sc = pipeline.sc;
+    if (!pipeline.arena.Map(SCStudyInterface::ArrayBytes(tuning.barCapacity), tuning.hugePages))
+    {
+        pipeline.Log(sc, "cannot map chart arena, arrays stay on the heap");
+        return;
+    }
+    pipeline.arena.Prefault();
+    sc.ReserveArrays(&pipeline.arena, tuning.barCapacity);
+
+    SCString logMsg;
+    logMsg.Format("chart arena: %d bars, %.1f MB on %s", tuning.barCapacity,
+                  pipeline.arena.Size() / 1048576.0, ArenaPageKindName(pipeline.arena.PageKind()));
+    pipeline.Log(sc, logMsg);
+}
+
+void HeadlessEngine::ApplyBar(SymbolPipeline& pipeline, const BarRecord& record)
+{
+    SCStudyInterface& sc = pipeline.sc;
+    int index = record.barIndex - pipeline.feedIndexOffset;
+    if (index > sc.ArraySize)
+        index = RecoverGap(pipeline, record.barIndex);
+
+    if (index == sc.ArraySize)
+        sc.SetArraySize(sc.ArraySize + 1);
+    else if (index != sc.ArraySize - 1)
+        return;     // Only the forming bar may be revised
+    WriteBar(pipeline, index, record);
+    pipeline.lastDataTime = LastDataTime(pipeline, Now(pipeline));
+}
+
+void HeadlessEngine::WriteBar(SymbolPipeline& pipeline, int index, const BarRecord& record)
+{
+    SCStudyInterface& sc = pipeline.sc;
+    sc.BaseDateTimeIn[index] = SCDateTime(record.dateTime);
+    sc.Open[index] = record.open;
+    sc.High[index] = record.high;
+    sc.Low[index] = record.low;
+    sc.Close[index] = record.close;
+    sc.Volume[index] = record.volume;
+    sc.BidVolume[index] = record.bidVolume;
+    sc.AskVolume[index] = record.askVolume;
+    sc.NumberOfTrades[index] = static_cast<float>(record.numTrades);
+    pipeline.firstDirtyIndex = std::min(pipeline.firstDirtyIndex, index);
+}
+
+// Bars between the chart's last bar and feedIndex never arrived. Filled from the store, they
+// reach the study in this same call, which then runs as a catch-up batch over them, so delta,
+// profile and detector state are rebuilt without a reload. Returns feedIndex's chart index.
+int HeadlessEngine::RecoverGap(SymbolPipeline& pipeline, int feedIndex)
+{
+    SCStudyInterface& sc = pipeline.sc;
+    int firstMissing = sc.ArraySize + pipeline.feedIndexOffset;
+    int lastMissing = feedIndex - 1;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    pipeline.recovered.clear();
+    bool recovered = !storeDir.empty() &&
+                     (pipeline.store.IsOpen() || pipeline.store.Open(storeDir, sc.Symbol.GetChars())) &&
+                     pipeline.store.Read(firstMissing, lastMissing, pipeline.recovered);
+
+    SCString logMsg;
+    if (recovered)
+    {
+        for (const BarRecord& bar : pipeline.recovered)
+        {
+            sc.SetArraySize(sc.ArraySize + 1);
+            WriteBar(pipeline, sc.ArraySize - 1, bar);
+        }
+        pipeline.barsRecovered += static_cast<int>(pipeline.recovered.size());
+        double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        logMsg.Format("GAP RECOVERED: bars %d-%d read from the store in %.2f ms", firstMissing, lastMissing, millis);
+    }
+    else
+    {
+        // The chart closes the hole; later feed indexes are shifted onto it
+        pipeline.feedIndexOffset += lastMissing - firstMissing + 1;
+        logMsg.Format("GAP: bars %d-%d missing and not in the store, continuing without them", firstMissing, lastMissing);
+    }
+    pipeline.Log(sc, logMsg);
+    return feedIndex - pipeline.feedIndexOffset;
+}
+
+// Stops and targets are simulated on the new bars before the study sees them
+void HeadlessEngine::CheckBracket(SymbolPipeline& pipeline)
+{
+    OpenBracket& bracket = pipeline.bracket;
+    SCStudyInterface& sc = pipeline.sc;
+    if (!bracket.armed || bracket.exitPending || sc.Position.PositionQuantity == 0) return;
+
+    bool isLong = sc.Position.PositionQuantity > 0;
+    for (int i = pipeline.firstDirtyIndex; i < sc.ArraySize; i++)
+    {
+        bool stopHit = bracket.stopOffset > 0.0f && (isLong ? sc.Low[i] <= bracket.stopPrice : sc.High[i] >= bracket.stopPrice);
+        bool targetHit = bracket.targetOffset > 0.0f && (isLong ? sc.High[i] >= bracket.targetPrice : sc.Low[i] <= bracket.targetPrice);
+        if (!stopHit && !targetHit) continue;
+
+        // Both inside one bar: assume the stop traded first
+        double exitPrice = stopHit ? bracket.stopPrice : bracket.targetPrice;
+        int quantity = static_cast<int>(std::lround(std::fabs(sc.Position.PositionQuantity)));
+        bracket.exitPending = true;
+        SendOrder(pipeline, isLong ? -1 : 1, quantity, ORDER_EXIT, exitPrice, 0.0f, 0.0f);
+        return;
+    }
+}
+
+// Chart time, as sc.CurrentSystemDateTime is in Sierra: the bars are stamped in the chart's
+// time zone, so the wall clock is shifted into it before the two are compared
+SCDateTime HeadlessEngine::Now(const SymbolPipeline& pipeline) const
+{
+    const SCStudyInterface& sc = pipeline.sc;
+    if (replayClock && sc.ArraySize > 0)
+        return sc.BaseDateTimeIn[sc.ArraySize - 1];
+
+    std::time_t now = std::time(nullptr);
+    long offsetSeconds = static_cast<long>(chartUtcOffsetMinutes) * 60;
+    if (chartUtcOffsetMinutes == kHostTimeZone)
+    {
+        std::tm local = {};
+        offsetSeconds = ::localtime_r(&now, &local) ? local.tm_gmtoff : 0;
+    }
+    return SCDateTime(kUnixEpochInSCDays + static_cast<double>(now + offsetSeconds) / 86400.0);
+}
+
+// sc.LatestDateTimeForLastBar: the time of the last bar's newest data. Bar records only carry
+// the bar's start, and a bar's data is complete at its end, so the end is estimated from the
+// previous bar's length. A bar still forming cannot have data from the future: it is capped
+// at now, which leaves the watchdog's lag check the feed's delay, not the bar's length. It is
+// taken once, when the bar arrives; timer calls reuse it, so silence does not look like data.
+SCDateTime HeadlessEngine::LastDataTime(const SymbolPipeline& pipeline, const SCDateTime& now) const
+{
+    const SCStudyInterface& sc = pipeline.sc;
+    double start = sc.BaseDateTimeIn[sc.ArraySize - 1].GetAsDouble();
+    double length = (sc.ArraySize > 1) ? start - sc.BaseDateTimeIn[sc.ArraySize - 2].GetAsDouble() : 0.0;
+    if (length <= 0.0 || length >= 1.0) length = 0.0;   // First bar, or a session gap
+    return SCDateTime(std::max(start, std::min(start + length, now.GetAsDouble())));
+}
+
+// One study call per symbol per feed frame, however many bars the frame carried. A timer call
+// without new bars runs the last bar again, as Sierra's UpdateAlways calls do.
+bool HeadlessEngine::RunPipeline(SymbolPipeline& pipeline, bool timerCall)
+{
+    SCStudyInterface& sc = pipeline.sc;
+    if (sc.ArraySize == 0) return false;
+    if (pipeline.firstDirtyIndex == INT_MAX)
+    {
+        if (!timerCall || !pipeline.hasRun) return false;
+        pipeline.firstDirtyIndex = sc.ArraySize - 1;
+    }
+
+    // Daily P&L follows the trading day of the newest bar
+    int barDate = sc.BaseDateTimeIn[sc.ArraySize - 1].GetDate();
+    if (barDate != pipeline.tradingDate)
+    {
+        pipeline.tradingDate = barDate;
+        sc.Position.DailyProfitLoss = 0;
+    }
+
+    CheckBracket(pipeline);
+    if (sc.Position.PositionQuantity != 0)
+        sc.Position.OpenProfitLoss = (sc.Close[sc.ArraySize - 1] - sc.Position.AveragePrice) *
+                                     sc.Position.PositionQuantity * pipeline.pointValue;
+
+    sc.IsFullRecalculation = pipeline.hasRun ? 0 : 1;
+    sc.UpdateStartIndex = pipeline.hasRun ? pipeline.firstDirtyIndex : 0;
+    sc.NewBarIndex = pipeline.hasRun ? pipeline.priorArraySize : 0;
+    sc.Index = sc.ArraySize - 1;
+    sc.CurrentSystemDateTime = Now(pipeline);
+    sc.LatestDateTimeForLastBar = pipeline.lastDataTime;
+
+    scsf_AdvancedOrderFlowBot(sc);
+
+    pipeline.wantsTimer = sc.UpdateAlways != 0;
+    pipeline.hasRun = true;
+    pipeline.priorArraySize = sc.ArraySize;
+    pipeline.firstDirtyIndex = INT_MAX;
+    return true;
+}
+
+bool HeadlessEngine::FlushOrders()
+{
+    std::lock_guard<std::mutex> lock(m_ordersMutex);
+    if (m_orders.Empty() || gatewayFd < 0) return true;
+    return m_orders.Flush(gatewayFd);
+}
+
+void HeadlessEngine::Shutdown()
+{
+    if (m_timer.joinable())
+    {
+        m_timerStop = true;
+        m_timer.join();
+        ::close(m_timerPipe[0]);
+        ::close(m_timerPipe[1]);
+    }
+
+    if (workerCount > 0)
+    {
+        m_scheduler.WaitIdle();
+        m_scheduler.Stop();
+        for (int w = 0; w < workerCount; w++)
+        {
+            WorkStealingScheduler::WorkerStats stats = m_scheduler.Stats(w);
+            std::fprintf(stderr, "worker %d: %llu runs, %llu stolen\n", w, stats.executed, stats.stolen);
+        }
+    }
+
+    if (!profilePath.empty())
+    {
+        SetProbeRecording(false);
+        int stacks = WriteFoldedStacks(profilePath);
+        if (stacks < 0) std::fprintf(stderr, "cannot write stage profile '%s'\n", profilePath.c_str());
+        else std::fprintf(stderr, "stage profile: %d stacks written to %s\n", stacks, profilePath.c_str());
+    }
+
+    LatencyHistogram loopLatency;
+    for (std::unordered_map<uint32_t, std::unique_ptr<SymbolPipeline>>::iterator it = m_pipelines.begin();
+         it != m_pipelines.end(); ++it)
+        loopLatency.Merge(it->second->loopLatency);
+    std::fprintf(stderr, "strategy loop: %llu calls, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+                 static_cast<unsigned long long>(loopLatency.Count()), loopLatency.Percentile(0.50) / 1000.0,
+                 loopLatency.Percentile(0.99) / 1000.0, loopLatency.Percentile(0.999) / 1000.0, loopLatency.Max() / 1000.0);
+
+    for (std::unordered_map<uint32_t, std::unique_ptr<SymbolPipeline>>::iterator it = m_pipelines.begin();
+         it != m_pipelines.end(); ++it)
+    {
+        SymbolPipeline& pipeline = *it->second;
+        SCStudyInterface& sc = pipeline.sc;
+
+        SCString logMsg;
+        logMsg.Format("SHUTDOWN: %d bars (%d recovered), %d entries, %d fills, position %.0f, daily P&L $%.2f",
+                      sc.ArraySize, pipeline.barsRecovered, pipeline.entriesSent, pipeline.fills,
+                      sc.Position.PositionQuantity, sc.Position.DailyProfitLoss);
+        pipeline.Log(sc, logMsg);
+        if (allocationMode != ALLOCATIONS_OFF) ReportAllocations(pipeline);
+
+        sc.LastCallToFunction = 1;
+        scsf_AdvancedOrderFlowBot(sc);
+    }
+    m_pipelines.clear();
+
+    if (allocationMode == ALLOCATIONS_CHECK)
+        std::fprintf(stderr, "allocation check %s\n", allocationCheckFailed ? "FAILED" : "passed");
+}
+
+// Steady-state allocations by stage, heaviest first; in check mode a stage making more per call
+// than its baseline fails the run
+void HeadlessEngine::ReportAllocations(SymbolPipeline& pipeline)
+{
+    const AllocationTally& tally = pipeline.allocations;
+    uint64_t allocations = 0, bytes = 0;
+    int slots[PROBE_STAGE_COUNT + 1];
+    int slotCount = 0;
+    for (int slot = 0; slot <= PROBE_STAGE_COUNT; slot++)
+    {
+        allocations += tally.totals.count[slot];
+        bytes += tally.totals.bytes[slot];
+        if (tally.totals.count[slot] > 0) slots[slotCount++] = slot;
+    }
+    std::sort(slots, slots + slotCount, [&tally](int a, int b) { return tally.totals.count[a] > tally.totals.count[b]; });
+
+    double calls = tally.calls > 0 ? static_cast<double>(tally.calls) : 1.0;
+    SCString logMsg;
+    logMsg.Format("ALLOCATIONS: %llu steady-state calls, %llu allocations (%.2f per call, %.1f KB), worst bar %d with %llu",
+                  static_cast<unsigned long long>(tally.calls), static_cast<unsigned long long>(allocations),
+                  allocations / calls, bytes / 1024.0, tally.worstBar, static_cast<unsigned long long>(tally.worstCall));
+    pipeline.Log(pipeline.sc, logMsg);
+    for (int s = 0; s < slotCount; s++)
+    {
+        int slot = slots[s];
+        logMsg.Format("  %s: %llu (%.2f per call, %.1f KB)", ProbeSlotName(slot),
+                      static_cast<unsigned long long>(tally.totals.count[slot]), tally.totals.count[slot] / calls,
+                      tally.totals.bytes[slot] / 1024.0);
+        pipeline.Log(pipeline.sc, logMsg);
+    }
+
+    if (allocationMode != ALLOCATIONS_CHECK) return;
+    for (int s = 0; s < slotCount; s++)
+    {
+        int slot = slots[s];
+        double perCall = tally.totals.count[slot] / calls;
+        if (perCall <= allocationBaseline[slot]) continue;
+        allocationCheckFailed = true;
+        if (allocationBaseline[slot] > 0.0)
+            logMsg.Format("ALLOCATION CHECK FAILED: %s made %.2f per call, baseline %.2f",
+                          ProbeSlotName(slot), perCall, allocationBaseline[slot]);
+        else
+            logMsg.Format("ALLOCATION CHECK FAILED: %s allocated (%.2f per call), first at bar %d",
+                          ProbeSlotName(slot), perCall, tally.firstBar);
+        pipeline.Log(pipeline.sc, logMsg);
+    }
+}
+
+// ==================================================================================
+// MAIN
+// ==================================================================================
+
+static void RequestStop(int)
+{
+    s_StopRequested = 1;
+}
+
+static void RequestTraceDump(int)
+{
+    s_TraceDumpRequested = 1;
+}
+
+// "2025-09-15" -> SCDateTime date (days since 1899-12-30), -1 if malformed
+static int ParseSessionDate(const std::string& text)
+{
+    std::tm date = {};
+    if (std::sscanf(text.c_str(), "%d-%d-%d", &date.tm_year, &date.tm_mon, &date.tm_mday) != 3) return -1;
+    if (date.tm_year < 1900 || date.tm_mon < 1 || date.tm_mon > 12 || date.tm_mday < 1 || date.tm_mday > 31) return -1;
+    date.tm_year -= 1900;
+    date.tm_mon -= 1;
+    time_t seconds = ::timegm(&date);
+    if (seconds == static_cast<time_t>(-1)) return -1;
+    return static_cast<int>(seconds / 86400 + static_cast<time_t>(kUnixEpochInSCDays));
+}
+
+// "StageName perCall" lines, # comments; a stage not listed may not allocate
+static bool ReadAllocationBaseline(const std::string& path, double* perCall)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::fprintf(stderr, "cannot read allocation baseline '%s'\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++)
+    {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        size_t end = line.find_last_not_of(" \t\r");
+        if (end == std::string::npos) continue;
+        size_t valueStart = line.find_last_of(" \t", end);
+        size_t nameEnd = valueStart == std::string::npos ? std::string::npos : line.find_last_not_of(" \t", valueStart);
+        size_t nameStart = line.find_first_not_of(" \t");
+        if (nameEnd == std::string::npos)
+        {
+            std::fprintf(stderr, "%s:%d: expected a stage name and allocations per call\n", path.c_str(), lineNumber);
+            return false;
+        }
+
+        std::string name = line.substr(nameStart, nameEnd - nameStart + 1);
+        int slot = 0;
+        while (slot <= PROBE_STAGE_COUNT && name != ProbeSlotName(slot)) slot++;
+        if (slot > PROBE_STAGE_COUNT)
+        {
+            std::fprintf(stderr, "%s:%d: unknown stage '%s'\n", path.c_str(), lineNumber, name.c_str());
+            return false;
+        }
+        perCall[slot] = std::atof(line.substr(valueStart + 1, end - valueStart).c_str());
+    }
+    return true;
+}
+
+// Allocates once while counting; false if the replaced allocator did not see it, in which case
+// every check would pass
+static bool AllocationCounterWorks()
+{
+    ProbeThreadState& state = ThreadProbeState();
+    uint64_t before = state.allocations.count[state.stage];
+    SetAllocationCounting(true);
+    ::operator delete(::operator new(1));
+    SetAllocationCounting(false);
+    return state.allocations.count[state.stage] == before + 1;
+}
+
+static void PrintUsage()
+{
+    std::fprintf(stderr,
+        "usage: aofb_engine [--config <file>] --feed unix:<path>|replay:<file> [--gateway unix:<path>] [--workers N]\n"
+        "                   [--feed-cpu N] [--worker-cpus LIST] [--huge-pages on|off] [--numa-local on|off]\n"
+        "                   [--bar-capacity N] [--store <dir>] [--chart-utc-offset MINUTES] [--input N=value]...\n"
+        "                   [--profile-stages <file> [--profile-session YYYY-MM-DD]]\n"
+        "                   [--allocations report|check [--allocation-warmup N] [--allocation-baseline <file>]]\n");
+}
+
+int main(int argc, char** argv)
+{
+    std::string feed, gateway;
+    HeadlessEngine engine;
+    EngineTuning& tuning = engine.tuning;
+
+    // A config file is expanded in place, so options after it on the command line win
+    std::vector<std::string> args;
+    for (int a = 1; a < argc; a++)
+    {
+        if (std::strcmp(argv[a], "--config") == 0 && a + 1 < argc)
+        {
+            if (!ReadConfigFile(argv[++a], args))
+            {
+                std::fprintf(stderr, "cannot read config '%s'\n", argv[a]);
+                return 1;
+            }
+        }
+        else args.push_back(argv[a]);
+    }
+
+    for (size_t a = 0; a < args.size(); a++)
+    {
+        const std::string& arg = args[a];
+        bool hasValue = a + 1 < args.size();
+        if (arg == "--feed" && hasValue) feed = args[++a];
+        else if (arg == "--gateway" && hasValue) gateway = args[++a];
+        else if (arg == "--store" && hasValue) engine.storeDir = args[++a];
+        else if (arg == "--profile-stages" && hasValue) engine.profilePath = args[++a];
+        else if (arg == "--allocation-warmup" && hasValue) engine.allocationWarmup = std::max(1, std::atoi(args[++a].c_str()));
+        else if (arg == "--allocation-baseline" && hasValue)
+        {
+            if (!ReadAllocationBaseline(args[++a], engine.allocationBaseline)) return 2;
+        }
+        else if (arg == "--allocations" && hasValue)
+        {
+            const std::string& mode = args[++a];
+            if (mode == "report") engine.allocationMode = ALLOCATIONS_REPORT;
+            else if (mode == "check") engine.allocationMode = ALLOCATIONS_CHECK;
+            else if (mode == "off") engine.allocationMode = ALLOCATIONS_OFF;
+            else { PrintUsage(); return 2; }
+        }
+        else if (arg == "--profile-session" && hasValue)
+        {
+            engine.profileDate = ParseSessionDate(args[++a]);
+            if (engine.profileDate < 0) { PrintUsage(); return 2; }
+        }
+        else if (arg == "--workers" && hasValue) engine.workerCount = std::max(0, std::atoi(args[++a].c_str()));
+        else if (arg == "--chart-utc-offset" && hasValue) engine.chartUtcOffsetMinutes = std::atoi(args[++a].c_str());
+        else if (arg == "--feed-cpu" && hasValue) tuning.feedCpu = std::atoi(args[++a].c_str());
+        else if (arg == "--bar-capacity" && hasValue) tuning.barCapacity = std::max(0, std::atoi(args[++a].c_str()));
+        else if (arg == "--worker-cpus" && hasValue)
+        {
+            if (!ParseCpuList(args[++a], tuning.workerCpus)) { PrintUsage(); return 2; }
+        }
+        else if (arg == "--huge-pages" && hasValue)
+        {
+            if (!ParseSwitch(args[++a], tuning.hugePages)) { PrintUsage(); return 2; }
+        }
+        else if (arg == "--numa-local" && hasValue)
+        {
+            if (!ParseSwitch(args[++a], tuning.numaLocal)) { PrintUsage(); return 2; }
+        }
+        else if (arg == "--input" && hasValue)
+        {
+            const std::string& spec = args[++a];
+            size_t equals = spec.find('=');
+            if (equals == std::string::npos) { PrintUsage(); return 2; }
+            engine.inputOverrides.push_back({std::atoi(spec.substr(0, equals).c_str()), spec.substr(equals + 1)});
+        }
+        else { PrintUsage(); return 2; }
+    }
+    if (engine.allocationMode != ALLOCATIONS_OFF && !AllocationCounterWorks())
+    {
+        std::fprintf(stderr, "allocation counter missed a test allocation, cannot count\n");
+        return 3;
+    }
+
+    int feedFd = -1;
+    std::string path;
+    if (feed.compare(0, 7, "replay:") == 0)
+    {
+        feedFd = ::open(feed.c_str() + 7, O_RDONLY);
+        engine.replayClock = true;
+    }
+    else if (ParseUnixEndpoint(feed, path))
+    {
+        feedFd = ConnectUnixSocket(path);
+    }
+    if (feedFd < 0)
+    {
+        std::fprintf(stderr, "cannot open feed '%s'\n", feed.c_str());
+        PrintUsage();
+        return 1;
+    }
+
+    if (!gateway.empty())
+    {
+        if (!ParseUnixEndpoint(gateway, path) || (engine.gatewayFd = ConnectUnixSocket(path)) < 0)
+        {
+            std::fprintf(stderr, "cannot connect to gateway '%s'\n", gateway.c_str());
+            return 1;
+        }
+        engine.paperMode = false;
+    }
+
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+    std::signal(SIGUSR1, RequestTraceDump);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // This thread reads the feed and the gateway; its buffers are faulted in after pinning
+    if (tuning.feedCpu >= 0 && !PinCurrentThread(tuning.feedCpu))
+        std::fprintf(stderr, "feed: cannot pin to cpu %d\n", tuning.feedCpu);
+    MemoryArena ioArena;
+    bool ioArenaMapped = tuning.hugePages && ioArena.Map(2 * FrameReader::kStorageBytes, true);
+    if (ioArenaMapped)
+    {
+        ioArena.Prefault();
+        std::fprintf(stderr, "feed: buffers on %s\n", ArenaPageKindName(ioArena.PageKind()));
+    }
+
+    engine.Start();
+    std::unique_ptr<FrameReader> feedReader(new FrameReader(ioArenaMapped ? &ioArena : nullptr));
+    std::unique_ptr<FrameReader> gatewayReader(new FrameReader(ioArenaMapped ? &ioArena : nullptr));
+
+    while (!s_StopRequested)
+    {
+        if (s_TraceDumpRequested)
+        {
+            s_TraceDumpRequested = 0;
+            engine.RequestTraceDump();
+        }
+
+        // poll skips negative descriptors: no gateway in paper mode, no timer in replays
+        pollfd fds[3] = {{feedFd, POLLIN, 0}, {engine.gatewayFd, POLLIN, 0}, {engine.TimerFd(), POLLIN, 0}};
+        if (::poll(fds, 3, 1000) < 0)
+        {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Fills first, so the study sees the position they produce
+        if (fds[1].revents & (POLLIN | POLLHUP))
+        {
+            if (gatewayReader->Fill(engine.gatewayFd) <= 0)
+            {
+                std::fprintf(stderr, "gateway disconnected\n");
+                break;
+            }
+            while (const FrameHeader* header = gatewayReader->Next())
+                engine.HandleFills(header);
+        }
+
+        if (fds[0].revents & (POLLIN | POLLHUP))
+        {
+            ssize_t bytes = feedReader->Fill(feedFd);
+            if (bytes <= 0) s_StopRequested = 1;
+
+            // A frame is the batch: each touched symbol gets its bars and runs its study once
+            while (const FrameHeader* header = feedReader->Next())
+                engine.HandleFrame(header);
+            if (engine.gatewayFailed)
+            {
+                std::fprintf(stderr, "gateway write failed\n");
+                break;
+            }
+            if (feedReader->IsCorrupt())
+            {
+                std::fprintf(stderr, "feed framing error, stopping\n");
+                break;
+            }
+        }
+
+        if (fds[2].revents & POLLIN)
+            engine.HandleTimer();
+    }
+
+    engine.Shutdown();
+    ::close(feedFd);
+    if (engine.gatewayFd >= 0) ::close(engine.gatewayFd);
+    return engine.allocationCheckFailed ? 3 : 0;
+}
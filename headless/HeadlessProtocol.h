@@ -0,0 +1,279 @@
+// ==================================================================================
+// HEADLESS WIRE PROTOCOL
+// Binary framing shared by the headless engine, the replay feed and the gateway stub.
+// A frame is a FrameHeader followed by recordCount fixed-size records of one type, so
+// a whole batch of bars or orders travels in one write and is read in place.
+// Records are little-endian and naturally aligned; the layout is versioned by kFrameMagic.
+// ==================================================================================
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <vector>
+#include <string>
+#include "EngineMemory.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const uint32_t kFrameMagic = 0x41465031;        // "AFP1"
+static const uint32_t kMaxFramePayload = 1u << 20;
+
+enum FrameType : uint16_t {
+    FRAME_SYMBOL = 1,       // Feed -> engine: symbol definition, sent before its bars
+    FRAME_BARS,             // Feed -> engine: new or updated bars
+    FRAME_ORDERS,           // Engine -> gateway: entry, exit and flatten orders
+    FRAME_FILLS,            // Gateway -> engine: executions
+    FRAME_END               // Feed -> engine: replay finished
+};
+
+struct FrameHeader {
+    uint32_t magic;
+    uint16_t type;
+    uint16_t recordCount;
+    uint32_t payloadBytes;
+    uint32_t sequence;
+};
+
+struct SymbolRecord {
+    uint32_t symbolId;
+    float tickSize;
+    float currencyValuePerTick;
+    uint32_t reserved;
+    char symbol[32];
+};
+
+// barIndex equal to the symbol's bar count appends; the last index updates the forming bar
+struct BarRecord {
+    uint32_t symbolId;
+    int32_t barIndex;
+    double dateTime;        // SCDateTime days
+    float open;
+    float high;
+    float low;
+    float close;
+    float volume;
+    float bidVolume;
+    float askVolume;
+    uint32_t numTrades;
+};
+
+enum OrderFlags : uint32_t {
+    ORDER_ENTRY = 1,
+    ORDER_EXIT = 2,         // Stop or target of an open position
+    ORDER_FLATTEN = 4
+};
+
+struct OrderRecord {
+    uint32_t symbolId;
+    uint32_t orderId;
+    int32_t side;           // 1 = buy, -1 = sell
+    int32_t quantity;
+    uint32_t flags;
+    float referencePrice;   // Last trade, or the stop/target price for exits
+    float stopOffset;
+    float targetOffset;
+    double dateTime;
+};
+
+struct FillRecord {
+    uint32_t symbolId;
+    uint32_t orderId;
+    int32_t side;
+    int32_t quantity;
+    float price;
+    uint32_t flags;
+    double dateTime;
+};
+
+static_assert(sizeof(FrameHeader) == 16, "frame header layout");
+static_assert(sizeof(SymbolRecord) == 48, "symbol record layout");
+static_assert(sizeof(BarRecord) == 48, "bar record layout");
+static_assert(sizeof(OrderRecord) == 40, "order record layout");
+static_assert(sizeof(FillRecord) == 32, "fill record layout");
+
+// Accumulates records of one frame type directly in the output buffer. Reserve() hands out
+// the slot to fill, Flush() sends every pending frame with a single write.
+class FrameWriter {
+public:
+    template <typename Record>
+    Record* Reserve(FrameType type)
+    {
+        if (m_openHeader == SIZE_MAX || CurrentHeader()->type != type ||
+            CurrentHeader()->recordCount == UINT16_MAX ||
+            CurrentHeader()->payloadBytes + sizeof(Record) > kMaxFramePayload)
+        {
+            m_openHeader = m_buffer.size();
+            m_buffer.resize(m_buffer.size() + sizeof(FrameHeader));
+            FrameHeader* header = CurrentHeader();
+            header->magic = kFrameMagic;
+            header->type = type;
+            header->recordCount = 0;
+            header->payloadBytes = 0;
+            header->sequence = m_sequence++;
+        }
+        size_t offset = m_buffer.size();
+        m_buffer.resize(offset + sizeof(Record));
+        FrameHeader* header = CurrentHeader();
+        header->recordCount++;
+        header->payloadBytes += sizeof(Record);
+        std::memset(&m_buffer[offset], 0, sizeof(Record));
+        return reinterpret_cast<Record*>(&m_buffer[offset]);
+    }
+
+    // Header-only frame, e.g. FRAME_END
+    void AddEmptyFrame(FrameType type)
+    {
+        size_t offset = m_buffer.size();
+        m_buffer.resize(offset + sizeof(FrameHeader));
+        FrameHeader* header = reinterpret_cast<FrameHeader*>(&m_buffer[offset]);
+        header->magic = kFrameMagic;
+        header->type = type;
+        header->recordCount = 0;
+        header->payloadBytes = 0;
+        header->sequence = m_sequence++;
+        m_openHeader = SIZE_MAX;
+    }
+
+    // Starts a new frame on the next Reserve, e.g. to keep one frame per bar batch
+    void CloseFrame() { m_openHeader = SIZE_MAX; }
+
+    bool Empty() const { return m_buffer.empty(); }
+    const char* Data() const { return m_buffer.data(); }
+    size_t Size() const { return m_buffer.size(); }
+
+    bool Flush(int fd)
+    {
+        size_t sent = 0;
+        while (sent < m_buffer.size())
+        {
+            ssize_t n = ::write(fd, m_buffer.data() + sent, m_buffer.size() - sent);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        Clear();
+        return true;
+    }
+
+    void Clear()
+    {
+        m_buffer.clear();
+        m_openHeader = SIZE_MAX;
+    }
+
+private:
+    FrameHeader* CurrentHeader() { return reinterpret_cast<FrameHeader*>(&m_buffer[m_openHeader]); }
+
+    std::vector<char> m_buffer;
+    size_t m_openHeader = SIZE_MAX;
+    uint32_t m_sequence = 0;
+};
+
+// Reads a byte stream into one aligned buffer and returns complete frames in place.
+// Pointers returned by Next() stay valid until the following Fill().
+class FrameReader {
+public:
+    static const size_t kStorageBytes = 2 * (kMaxFramePayload + sizeof(FrameHeader));
+
+    // The buffer comes from the arena when one is given, e.g. pre-faulted by the reading thread
+    explicit FrameReader(MemoryArena* arena = nullptr)
+        : m_storage(kStorageBytes / sizeof(uint64_t), 0, ArenaAllocator<uint64_t>(arena)) {}
+
+    // Returns bytes read, 0 on end of stream, -1 on error (EAGAIN is reported as -1 with errno set)
+    ssize_t Fill(int fd)
+    {
+        Compact();
+        char* base = Base();
+        size_t capacity = m_storage.size() * sizeof(uint64_t);
+        ssize_t n;
+        do {
+            n = ::read(fd, base + m_end, capacity - m_end);
+        } while (n < 0 && errno == EINTR);
+        if (n > 0) m_end += static_cast<size_t>(n);
+        return n;
+    }
+
+    // Next complete frame, or nullptr when more bytes are needed. Sets m_corrupt on bad framing.
+    const FrameHeader* Next()
+    {
+        if (m_end - m_begin < sizeof(FrameHeader)) return nullptr;
+        const FrameHeader* header = reinterpret_cast<const FrameHeader*>(Base() + m_begin);
+        if (header->magic != kFrameMagic || header->payloadBytes > kMaxFramePayload)
+        {
+            m_corrupt = true;
+            return nullptr;
+        }
+        if (m_end - m_begin < sizeof(FrameHeader) + header->payloadBytes) return nullptr;
+        m_begin += sizeof(FrameHeader) + header->payloadBytes;
+        return header;
+    }
+
+    bool IsCorrupt() const { return m_corrupt; }
+
+    template <typename Record>
+    static const Record* Records(const FrameHeader* header)
+    {
+        if (header->payloadBytes != header->recordCount * sizeof(Record)) return nullptr;
+        return reinterpret_cast<const Record*>(header + 1);
+    }
+
+private:
+    char* Base() { return reinterpret_cast<char*>(m_storage.data()); }
+
+    // Moves the unread tail to the aligned start of the buffer so records can be read in place
+    void Compact()
+    {
+        if (m_begin == 0) return;
+        size_t remaining = m_end - m_begin;
+        if (remaining > 0)
+            std::memmove(Base(), Base() + m_begin, remaining);
+        m_begin = 0;
+        m_end = remaining;
+    }
+
+    std::vector<uint64_t, ArenaAllocator<uint64_t>> m_storage;
+    size_t m_begin = 0;
+    size_t m_end = 0;
+    bool m_corrupt = false;
+};
+
+// "unix:/path" endpoints for the feed and gateway sockets
+inline bool ParseUnixEndpoint(const std::string& endpoint, std::string& path)
+{
+    if (endpoint.compare(0, 5, "unix:") != 0 || endpoint.size() <= 5) return false;
+    path = endpoint.substr(5);
+    return path.size() < sizeof(sockaddr_un::sun_path);
+}
+
+inline int ConnectUnixSocket(const std::string& path)
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+inline int ListenUnixSocket(const std::string& path)
+{
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    ::unlink(path.c_str());
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 4) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -0,0 +1,236 @@
+// ==================================================================================
+// REPLAY FEED
+// Market-data stand-in for the headless engine. Converts a Sierra Chart bar export
+// (Date, Time, Open, High, Low, Last, Volume, NumberOfTrades, BidVolume, AskVolume)
+// into framed batches and either writes a replay file or serves it on a Unix socket.
+// Repeat the --csv group to replay several symbols, merged in bar-time order.
+//
+// Build:  g++ -std=c++17 -O2 -o aofb_feed headless/ReplayFeed.cpp
+// Run:    aofb_feed --csv ES.txt --symbol ESZ25 --tick 0.25 --tick-value 12.5 --out session.bin
+//         aofb_feed --csv ES.txt --symbol ESZ25 --tick 0.25 --tick-value 12.5
+//                   --csv NQ.txt --symbol NQZ25 --tick 0.25 --tick-value 5 --out session.bin
+//         aofb_feed --csv ES.txt --symbol ESZ25 --tick 0.25 --tick-value 12.5 --serve unix:/tmp/aofb_feed.sock
+// Options: --batch N bars per frame (default 1), --interval-ms N pause between frames when serving
+//          --store DIR records every bar to the engine's gap-recovery store before it is sent
+//          --drop-every N --drop-frames M loses M bar frames out of every N, to exercise recovery
+// ==================================================================================
+#include "HeadlessProtocol.h"
+#include "BarStore.h"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+
+// Days from 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+static long DaysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<long>(dayOfEra) - 719468;
+}
+
+static bool ParseBarLine(const std::string& line, BarRecord& bar)
+{
+    int year, month, day, hour, minute;
+    double second = 0.0;
+    char dateSeparator1, dateSeparator2;
+    std::istringstream in(line);
+    if (!(in >> year >> dateSeparator1 >> month >> dateSeparator2 >> day)) return false;
+
+    std::string field;
+    std::getline(in, field, ',');   // Rest of the date field
+    std::getline(in, field, ',');
+    if (std::sscanf(field.c_str(), " %d:%d:%lf", &hour, &minute, &second) < 2) return false;
+
+    float values[8] = {};
+    for (int v = 0; v < 8; v++)
+    {
+        if (!std::getline(in, field, ','))
+        {
+            if (v < 5) return false;    // Trade count and bid/ask volume columns are optional
+            break;
+        }
+        values[v] = static_cast<float>(std::atof(field.c_str()));
+    }
+
+    double secondsOfDay = hour * 3600.0 + minute * 60.0 + second;
+    bar.dateTime = 25569.0 + DaysFromCivil(year, month, day) + secondsOfDay / 86400.0;
+    bar.open = values[0];
+    bar.high = values[1];
+    bar.low = values[2];
+    bar.close = values[3];
+    bar.volume = values[4];
+    bar.numTrades = static_cast<uint32_t>(values[5]);
+    bar.bidVolume = values[6];
+    bar.askVolume = values[7];
+    return true;
+}
+
+// One --csv group: the symbol options that follow a --csv belong to it
+struct ReplaySource {
+    std::string csvPath, symbol;
+    float tickSize = 0.0f, tickValue = 0.0f;
+    std::ifstream csv;
+    BarRecord next = {};
+    bool hasNext = false;
+    int barIndex = 0;
+    BarStoreWriter store;
+
+    void Advance()
+    {
+        std::string line;
+        hasNext = false;
+        while (!hasNext && std::getline(csv, line))
+            hasNext = ParseBarLine(line, next);     // Skips header and malformed lines
+    }
+};
+
+int main(int argc, char** argv)
+{
+    std::vector<std::unique_ptr<ReplaySource>> sources;
+    std::string outPath, serve, storeDir;
+    int batch = 1, intervalMs = 0, dropEvery = 0, dropFrames = 0;
+
+    for (int a = 1; a + 1 < argc; a += 2)
+    {
+        std::string arg = argv[a];
+        const char* value = argv[a + 1];
+        if (arg == "--csv")
+        {
+            sources.emplace_back(new ReplaySource());
+            sources.back()->csvPath = value;
+        }
+        else if (sources.empty() && (arg == "--symbol" || arg == "--tick" || arg == "--tick-value")) continue;    // No --csv yet
+        else if (arg == "--symbol") sources.back()->symbol = value;
+        else if (arg == "--tick") sources.back()->tickSize = static_cast<float>(std::atof(value));
+        else if (arg == "--tick-value") sources.back()->tickValue = static_cast<float>(std::atof(value));
+        else if (arg == "--out") outPath = value;
+        else if (arg == "--serve") serve = value;
+        else if (arg == "--batch") batch = std::max(1, std::atoi(value));
+        else if (arg == "--interval-ms") intervalMs = std::max(0, std::atoi(value));
+        else if (arg == "--store") storeDir = value;
+        else if (arg == "--drop-every") dropEvery = std::max(0, std::atoi(value));
+        else if (arg == "--drop-frames") dropFrames = std::max(0, std::atoi(value));
+    }
+
+    bool sourcesValid = !sources.empty();
+    for (const std::unique_ptr<ReplaySource>& source : sources)
+        sourcesValid = sourcesValid && !source->symbol.empty() && source->tickSize > 0.0f;
+
+    std::string socketPath;
+    if (!sourcesValid || (outPath.empty() && !ParseUnixEndpoint(serve, socketPath)))
+    {
+        std::fprintf(stderr, "usage: aofb_feed (--csv <file> --symbol <symbol> --tick <size> --tick-value <value>)... "
+                             "(--out <file> | --serve unix:<path>) [--batch N] [--interval-ms N] [--store <dir>]\n"
+                             "                 [--drop-every N --drop-frames M]\n");
+        return 2;
+    }
+
+    for (const std::unique_ptr<ReplaySource>& source : sources)
+    {
+        source->csv.open(source->csvPath);
+        if (!source->csv)
+        {
+            std::fprintf(stderr, "cannot read '%s'\n", source->csvPath.c_str());
+            return 1;
+        }
+        source->Advance();
+        if (!storeDir.empty() && !source->store.Open(storeDir, source->symbol, source->tickSize))
+        {
+            std::fprintf(stderr, "cannot create store for '%s' in '%s'\n", source->symbol.c_str(), storeDir.c_str());
+            return 1;
+        }
+    }
+
+    int outFd = -1;
+    if (!outPath.empty())
+    {
+        outFd = ::open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    else
+    {
+        std::signal(SIGPIPE, SIG_IGN);
+        int listenFd = ListenUnixSocket(socketPath);
+        if (listenFd >= 0)
+        {
+            std::fprintf(stderr, "feed waiting for engine on %s\n", socketPath.c_str());
+            outFd = ::accept(listenFd, nullptr, nullptr);
+            ::close(listenFd);
+        }
+    }
+    if (outFd < 0)
+    {
+        std::fprintf(stderr, "cannot open output\n");
+        return 1;
+    }
+
+    FrameWriter writer;
+    for (size_t s = 0; s < sources.size(); s++)
+    {
+        SymbolRecord* definition = writer.Reserve<SymbolRecord>(FRAME_SYMBOL);
+        definition->symbolId = static_cast<uint32_t>(s + 1);
+        definition->tickSize = sources[s]->tickSize;
+        definition->currencyValuePerTick = sources[s]->tickValue;
+        std::strncpy(definition->symbol, sources[s]->symbol.c_str(), sizeof(definition->symbol) - 1);
+    }
+    writer.CloseFrame();
+
+    int barsSent = 0, barsDropped = 0, inBatch = 0, barFrames = 0;
+    for (;;)
+    {
+        // Earliest pending bar across sources; ties go to the first source
+        int earliest = -1;
+        for (size_t s = 0; s < sources.size(); s++)
+            if (sources[s]->hasNext && (earliest < 0 || sources[s]->next.dateTime < sources[earliest]->next.dateTime))
+                earliest = static_cast<int>(s);
+        if (earliest < 0) break;
+
+        ReplaySource& source = *sources[earliest];
+        BarRecord* bar = writer.Reserve<BarRecord>(FRAME_BARS);
+        *bar = source.next;
+        bar->symbolId = static_cast<uint32_t>(earliest + 1);
+        bar->barIndex = source.barIndex++;
+        source.store.Append(*bar);
+        source.Advance();
+
+        if (++inBatch == batch)
+        {
+            writer.CloseFrame();
+            for (const std::unique_ptr<ReplaySource>& recorded : sources)
+                recorded->store.Flush();
+
+            // A dropped frame keeps its sequence number, so the engine sees the hole
+            bool drop = dropEvery > 0 && barFrames >= dropEvery && barFrames % dropEvery < dropFrames;
+            barFrames++;
+            if (drop)
+            {
+                barsDropped += inBatch;
+                inBatch = 0;
+                writer.Clear();
+                continue;
+            }
+            barsSent += inBatch;
+            inBatch = 0;
+            if (!writer.Flush(outFd)) break;
+            if (!serve.empty() && intervalMs > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        }
+    }
+    barsSent += inBatch;
+    for (const std::unique_ptr<ReplaySource>& recorded : sources)
+        recorded->store.Close();
+    writer.AddEmptyFrame(FRAME_END);
+    writer.Flush(outFd);
+    ::close(outFd);
+
+    std::fprintf(stderr, "%d bars sent, %d dropped\n", barsSent, barsDropped);
+    return 0;
+}
@@ -0,0 +1,184 @@
+// ==================================================================================
+// WORK-STEALING SCHEDULER
+// Fixed pool of workers, one deque each. A task is queued at most once at a time and
+// goes to its home worker's deque; idle workers steal from the far end of busy deques.
+// Because a task can never be queued or running twice, everything a task does is
+// serialised, which is what keeps each symbol's bars and fills in order.
+// Workers can be split into steal domains (NUMA nodes) so a task never migrates to a
+// worker whose memory is remote to the one it was set up on.
+// ==================================================================================
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ScheduledTask {
+public:
+    virtual ~ScheduledTask() {}
+    virtual void Run() = 0;                 // Drain whatever work is pending
+    virtual bool HasPendingWork() = 0;      // Re-checked after Run to close the wake-up race
+
+    int homeWorker = 0;
+    std::atomic<bool> queued{false};
+};
+
+class WorkStealingScheduler {
+public:
+    struct WorkerStats {
+        unsigned long long executed = 0;
+        unsigned long long stolen = 0;
+    };
+
+    ~WorkStealingScheduler() { Stop(); }
+
+    // onWorkerStart runs first on each new worker thread (pinning, per-thread setup).
+    // stealDomains gives each worker's domain; workers only steal within their own.
+    void Start(int workerCount, std::function<void(int)> onWorkerStart = nullptr,
+               const std::vector<int>& stealDomains = std::vector<int>())
+    {
+        m_queues.clear();
+        for (int w = 0; w < workerCount; w++)
+        {
+            m_queues.emplace_back(new WorkerQueue());
+            m_queues.back()->domain = w < static_cast<int>(stealDomains.size()) ? stealDomains[w] : 0;
+        }
+        m_onWorkerStart = onWorkerStart;
+        m_stopping = false;
+        for (int w = 0; w < workerCount; w++) m_threads.emplace_back(&WorkStealingScheduler::WorkerLoop, this, w);
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_idleMutex);
+            m_stopping = true;
+        }
+        m_idleCondition.notify_all();
+        for (std::thread& thread : m_threads) thread.join();
+        m_threads.clear();
+    }
+
+    int WorkerCount() const { return static_cast<int>(m_queues.size()); }
+
+    // Safe from any thread; a task that is already queued or running is not queued again
+    void Schedule(ScheduledTask* task)
+    {
+        if (task->queued.exchange(true, std::memory_order_acq_rel)) return;
+
+        WorkerQueue& queue = *m_queues[task->homeWorker % m_queues.size()];
+        m_pendingTasks.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(task);
+        }
+        if (m_sleepers.load(std::memory_order_acquire) > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_idleMutex);     // Orders the wake-up after the sleeper's check
+            m_idleCondition.notify_one();
+        }
+    }
+
+    // Blocks until no task is queued or running
+    void WaitIdle()
+    {
+        while (m_pendingTasks.load(std::memory_order_acquire) != 0 || m_runningTasks.load(std::memory_order_acquire) != 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+
+    WorkerStats Stats(int worker) const { return m_queues[worker]->stats; }
+
+private:
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<ScheduledTask*> tasks;
+        WorkerStats stats;
+        int domain = 0;
+    };
+
+    // Own work oldest-first; stolen work is taken from the other end
+    ScheduledTask* TakeTask(int worker)
+    {
+        WorkerQueue& own = *m_queues[worker];
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                ScheduledTask* task = own.tasks.front();
+                own.tasks.pop_front();
+                return task;
+            }
+        }
+
+        int count = static_cast<int>(m_queues.size());
+        for (int offset = 1; offset < count; offset++)
+        {
+            WorkerQueue& victim = *m_queues[(worker + offset) % count];
+            if (victim.domain != own.domain) continue;
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                ScheduledTask* task = victim.tasks.back();
+                victim.tasks.pop_back();
+                own.stats.stolen++;
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    void WorkerLoop(int worker)
+    {
+        if (m_onWorkerStart) m_onWorkerStart(worker);
+        int idleSpins = 0;
+        for (;;)
+        {
+            ScheduledTask* task = (m_pendingTasks.load(std::memory_order_acquire) > 0) ? TakeTask(worker) : nullptr;
+            if (task)
+            {
+                m_runningTasks.fetch_add(1, std::memory_order_acq_rel);
+                m_pendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+                idleSpins = 0;
+
+                task->Run();
+                task->queued.store(false, std::memory_order_release);
+                if (task->HasPendingWork()) Schedule(task);
+
+                m_queues[worker]->stats.executed++;
+                m_runningTasks.fetch_sub(1, std::memory_order_acq_rel);
+                continue;
+            }
+
+            // Spin briefly so a burst is picked up without a wake-up, then sleep
+            if (++idleSpins < 64)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_idleMutex);
+            if (m_stopping && m_pendingTasks.load(std::memory_order_acquire) == 0) return;
+            m_sleepers.fetch_add(1, std::memory_order_acq_rel);
+            m_idleCondition.wait_for(lock, std::chrono::milliseconds(50), [this] {
+                return m_stopping || m_pendingTasks.load(std::memory_order_acquire) > 0;
+            });
+            m_sleepers.fetch_sub(1, std::memory_order_acq_rel);
+            if (m_stopping && m_pendingTasks.load(std::memory_order_acquire) == 0) return;
+            idleSpins = 0;
+        }
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::function<void(int)> m_onWorkerStart;
+    std::atomic<int> m_pendingTasks{0};
+    std::atomic<int> m_runningTasks{0};
+    std::atomic<int> m_sleepers{0};
+    std::mutex m_idleMutex;
+    std::condition_variable m_idleCondition;
+    bool m_stopping = false;
+};
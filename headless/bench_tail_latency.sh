@@ -0,0 +1,89 @@
+#!/bin/sh
+# Strategy-loop latency of the headless engine on one replay, default placement
+# against a tuning config, alternating runs so both see the same machine state.
+#
+# Usage: headless/bench_tail_latency.sh <engine> <replay.bin> <tuning.conf> [runs] [engine options...]
+#   e.g. headless/bench_tail_latency.sh ./aofb_engine multi.bin headless/engine.conf.example 5 --workers 4
+# Only the placement options of the config are used (feed-cpu, worker-cpus, huge-pages,
+# numa-local, bar-capacity), so both sides run the same study. The config must pin the
+# feed thread and the workers, otherwise the tuned side is not reproducible.
+#
+# WARMUP (default 2) runs of each side are made first and discarded, so page cache,
+# huge-page reservations and CPU frequency have settled before anything is recorded.
+# Each recorded run prints the engine's "strategy loop" line; the summary is the median
+# over the recorded runs of each percentile, in microseconds.
+
+engine=$1
+replay=$2
+config=$3
+runs=${4:-5}
+warmup=${WARMUP:-2}
+[ -x "$engine" ] && [ -f "$replay" ] && [ -f "$config" ] || {
+    echo "usage: $0 <engine> <replay.bin> <tuning.conf> [runs] [engine options...]" >&2
+    exit 2
+}
+if [ $# -gt 4 ]; then shift 4; else shift $#; fi
+
+tuning=$(mktemp)
+results=$(mktemp)
+trap 'rm -f "$tuning" "$results"' EXIT
+grep -E '^[[:space:]]*(feed-cpu|worker-cpus|huge-pages|numa-local|bar-capacity)[[:space:]=]' "$config" > "$tuning"
+grep -qE '^[[:space:]]*feed-cpu[[:space:]=]' "$tuning" && grep -qE '^[[:space:]]*worker-cpus[[:space:]=]' "$tuning" || {
+    echo "$config: set feed-cpu and worker-cpus so the tuned runs are pinned" >&2
+    exit 2
+}
+
+# Machine state that changes tail latency, so two reports can be compared
+echo "engine:   $engine $*"
+echo "replay:   $replay ($(wc -c < "$replay") bytes)"
+echo "host:     $(uname -srm), $(nproc) CPUs"
+for governor in /sys/devices/system/cpu/cpu0/cpufreq/scaling_governor; do
+    [ -r "$governor" ] && echo "governor: $(cat "$governor") (cpu0)"
+done
+echo "placement:"
+sed 's/^/    /' "$tuning"
+echo "runs:     $runs recorded after $warmup warm-up each"
+
+# side label, then the engine options shared by both sides
+run_side() {
+    label=$1
+    shift
+    if [ "$label" = tuned ]; then
+        line=$("$engine" --config "$tuning" --feed "replay:$replay" "$@" 2>&1 | grep '^strategy loop')
+    else
+        line=$("$engine" --feed "replay:$replay" "$@" 2>&1 | grep '^strategy loop')
+    fi
+    [ -n "$record" ] && printf 'run %d %-8s %s\n' "$run" "$label:" "$line"
+    [ -n "$record" ] && echo "$label $line" >> "$results"
+}
+
+record=
+run=1
+while [ "$run" -le "$warmup" ]; do
+    run_side default "$@"
+    run_side tuned "$@"
+    run=$((run + 1))
+done
+
+record=1
+run=1
+while [ "$run" -le "$runs" ]; do
+    run_side default "$@"
+    run_side tuned "$@"
+    run=$((run + 1))
+done
+
+# Median of each percentile per side
+for side in default tuned; do
+    for field in p50 p99 p99.9 max; do
+        grep "^$side " "$results" |
+            sed -n "s/.* $field \([0-9.]*\) us.*/\1/p" | sort -n |
+            awk -v side="$side" -v field="$field" '
+                { value[NR] = $1 }
+                END {
+                    if (NR == 0) exit
+                    median = (NR % 2) ? value[(NR + 1) / 2] : (value[NR / 2] + value[NR / 2 + 1]) / 2
+                    printf "%-8s %-6s median %.1f us (min %.1f, max %.1f, %d runs)\n", side, field, median, value[1], value[NR], NR
+                }'
+    done
+done
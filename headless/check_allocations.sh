@@ -0,0 +1,30 @@
+#!/bin/sh
+# Replay check of the live path's heap allocations: runs the study over a replay with
+# --allocations check against the per-stage baseline, and fails if any stage allocated more
+# per call than its baseline allows. The baseline only ever comes down (see the file).
+#
+# Usage: headless/check_allocations.sh <engine> <replay.bin> [baseline] [engine options...]
+#   e.g. headless/check_allocations.sh ./aofb_engine multi.bin headless/allocation_baseline.conf
+
+engine=$1
+replay=$2
+baseline=${3:-$(dirname "$0")/allocation_baseline.conf}
+[ -x "$engine" ] && [ -f "$replay" ] && [ -f "$baseline" ] || {
+    echo "usage: $0 <engine> <replay.bin> [baseline] [engine options...]" >&2
+    exit 2
+}
+if [ $# -gt 3 ]; then shift 3; else shift $#; fi
+
+log=$(mktemp)
+trap 'rm -f "$log"' EXIT
+
+"$engine" --feed "replay:$replay" --input 1=1 --allocations check --allocation-baseline "$baseline" "$@" > "$log" 2>&1
+status=$?
+
+grep -E '^(\[[^]]*\] )?(ALLOCATION|allocation)' "$log"
+case $status in
+    0) echo "OK: every stage within $baseline" ;;
+    3) echo "FAIL: allocations above $baseline" >&2 ;;
+    *) echo "FAIL: engine exited with status $status" >&2; tail -5 "$log" >&2 ;;
+esac
+exit $status
@@ -0,0 +1,68 @@
+#!/bin/sh
+# Live check of the feed watchdog's clock. First serves bars stamped with the current time in
+# the engine's chart time zone, one a second, and fails if the study ever calls the feed stale.
+# A wrong time zone or a lag measured from the bar's start shows up as hours or a bar's
+# length of lag. Then serves bars four seconds apart with a two-second silence limit, and
+# fails unless every gap between them is called stale and every next bar resumes the feed,
+# so timer calls during a silence cannot pass for new data.
+#
+# Usage: headless/check_feed_watchdog.sh <engine> <feed> [bars] [engine options...]
+#   e.g. TZ=America/New_York headless/check_feed_watchdog.sh ./aofb_engine ./aofb_feed 8
+
+engine=$1
+feed=$2
+bars=${3:-8}
+gapBars=4
+[ -x "$engine" ] && [ -x "$feed" ] || {
+    echo "usage: $0 <engine> <feed> [bars] [engine options...]" >&2
+    exit 2
+}
+if [ $# -gt 3 ]; then shift 3; else shift $#; fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# count bars spacing seconds apart from one second ago, in the local time zone the engine takes
+# as chart time, served at that pace; then the engine options
+serve_bars() {
+    count=$1
+    spacing=$2
+    shift 2
+    start=$(($(date +%s) - 1))
+    echo "Date, Time, Open, High, Low, Last, Volume, NumberOfTrades, BidVolume, AskVolume" > "$work/bars.txt"
+    bar=0
+    while [ "$bar" -lt "$count" ]; do
+        echo "$(date -d "@$((start + bar * spacing))" '+%Y/%-m/%-d, %H:%M:%S'), 5000.00, 5001.00, 4999.00, 5000.00, 100, 10, 50, 50" >> "$work/bars.txt"
+        bar=$((bar + 1))
+    done
+
+    rm -f "$work/feed.sock"
+    "$feed" --csv "$work/bars.txt" --symbol CHECK --tick 0.25 --tick-value 12.5 \
+        --serve "unix:$work/feed.sock" --interval-ms $((spacing * 1000)) > "$work/feed.log" 2>&1 &
+    sleep 0.2
+    "$engine" --feed "unix:$work/feed.sock" --input 115=1 --input 4=1 "$@" > "$work/engine.log" 2>&1
+    wait
+    grep -E 'FEED|SHUTDOWN' "$work/engine.log"
+}
+
+serve_bars "$bars" 1 "$@"
+if grep -q 'FEED STALE' "$work/engine.log"; then
+    echo "FAIL: feed read stale while bars arrived on time" >&2
+    exit 1
+fi
+grep -q "SHUTDOWN: $bars bars" "$work/engine.log" || {
+    echo "FAIL: engine did not receive all $bars bars" >&2
+    exit 1
+}
+echo "OK: feed read fresh for $bars bars"
+
+serve_bars "$gapBars" 4 --input 116=2 "$@"
+gaps=$((gapBars - 1))
+stale=$(grep -c 'FEED STALE: no data' "$work/engine.log")
+resumed=$(grep -c 'FEED RESUMED' "$work/engine.log")
+# The feed waits once more after its last bar, which may read stale as well
+[ "$stale" -ge "$gaps" ] && [ "$resumed" -eq "$gaps" ] || {
+    echo "FAIL: $gaps silences gave $stale stale and $resumed resumed" >&2
+    exit 1
+}
+echo "OK: each of $gaps silences read stale and resumed"
@@ -0,0 +1,499 @@
+// ==================================================================================
+// HEADLESS ACSIL STAND-IN
+// The subset of the Sierra Chart ACSIL interface used by MAN.cpp, implemented on plain
+// vectors so the study compiles unchanged into the headless engine. Bars, positions and
+// order routing are driven by HeadlessEngine.cpp; drawing calls are accepted and ignored.
+// Only add what the studies use, with the same names and semantics as ACSIL.
+// ==================================================================================
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include "EngineMemory.h"
+
+#define SCDLLName(name)
+#define SCSFExport extern "C" void
+
+typedef uint32_t COLORREF;
+typedef double t_MarketDataQuantity;
+#define RGB(r, g, b) ((COLORREF)(((uint32_t)(r) & 0xFF) | (((uint32_t)(g) & 0xFF) << 8) | (((uint32_t)(b) & 0xFF) << 16)))
+
+inline int HMS_TIME(int hour, int minute, int second) { return hour * 3600 + minute * 60 + second; }
+
+enum {
+    DRAWSTYLE_LINE, DRAWSTYLE_BAR, DRAWSTYLE_ARROWUP, DRAWSTYLE_ARROWDOWN, DRAWSTYLE_SQUARE,
+    DRAWSTYLE_DIAMOND, DRAWSTYLE_PLUS, DRAWSTYLE_DASH, DRAWSTYLE_DOT, DRAWSTYLE_POINT,
+    DRAWSTYLE_TRIANGLEUP, DRAWSTYLE_TRIANGLEDOWN, DRAWSTYLE_IGNORE, DRAWSTYLE_HIDDEN
+};
+enum { LOW_PREC_LEVEL = 1, STD_PREC_LEVEL = 2 };
+enum { SCT_ORDERTYPE_MARKET = 0, SCT_ORDERTYPE_LIMIT = 1 };
+enum { SCT_TIF_DAY = 0, SCT_TIF_GOOD_TILL_CANCELED = 1 };
+enum SCOrderStatusCodeEnum {
+    SCT_OSC_UNSPECIFIED = 0, SCT_OSC_ORDERSENT = 1, SCT_OSC_PENDINGOPEN = 2, SCT_OSC_PENDINGCHILD = 3,
+    SCT_OSC_OPEN = 4, SCT_OSC_PENDINGCANCELREPLACE = 5, SCT_OSC_PENDINGCANCEL = 6, SCT_OSC_FILLED = 7,
+    SCT_OSC_CANCELED = 8, SCT_OSC_ERROR = 9
+};
+enum { SCTRADING_ORDER_ERROR = -1 };
+enum { DRAWING_TEXT = 1, DRAWING_LINE = 2, DRAWING_HORIZONTALLINE = 3, DRAWING_RECTANGLEHIGHLIGHT = 4 };
+enum { UTAM_ADD_OR_ADJUST = 0, UTAM_ADD_ALWAYS = 1 };
+enum { SC_TS_MARKER = 0, SC_TS_BID = 1, SC_TS_ASK = 2 };
+
+// ==================================================================================
+// STRINGS AND TIME
+// ==================================================================================
+
+class SCString {
+public:
+    SCString() {}
+    SCString(const char* text) : m_text(text ? text : "") {}
+    SCString(const std::string& text) : m_text(text) {}
+
+    SCString& Format(const char* format, ...)
+    {
+        char buffer[2048];
+        va_list args;
+        va_start(args, format);
+        std::vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        m_text = buffer;
+        return *this;
+    }
+
+    const char* GetChars() const { return m_text.c_str(); }
+    int GetLength() const { return static_cast<int>(m_text.size()); }
+    bool IsEmpty() const { return m_text.empty(); }
+    operator const char*() const { return m_text.c_str(); }
+    SCString& operator=(const char* text) { m_text = text ? text : ""; return *this; }
+    SCString& operator+=(const char* text) { m_text += text; return *this; }
+
+private:
+    std::string m_text;
+};
+
+// Days since 1899-12-30 as a double, like ACSIL. An int converts as seconds of the day,
+// which is what sc.Input[].GetTime() returns.
+class SCDateTime {
+public:
+    SCDateTime() : m_days(0.0) {}
+    SCDateTime(double days) : m_days(days) {}
+    SCDateTime(int secondsOfDay) : m_days(secondsOfDay / 86400.0) {}
+
+    int GetDate() const { return static_cast<int>(TotalSeconds() / 86400); }
+    int GetTime() const { return static_cast<int>(TotalSeconds() % 86400); }
+    double GetAsDouble() const { return m_days; }
+
+    bool operator<(const SCDateTime& other) const { return m_days < other.m_days; }
+    bool operator>(const SCDateTime& other) const { return m_days > other.m_days; }
+    bool operator<=(const SCDateTime& other) const { return m_days <= other.m_days; }
+    bool operator>=(const SCDateTime& other) const { return m_days >= other.m_days; }
+    bool operator==(const SCDateTime& other) const { return m_days == other.m_days; }
+    SCDateTime operator-(const SCDateTime& other) const { return SCDateTime(m_days - other.m_days); }
+    SCDateTime operator+(const SCDateTime& other) const { return SCDateTime(m_days + other.m_days); }
+
+private:
+    long long TotalSeconds() const { return std::llround(m_days * 86400.0); }
+
+    double m_days;
+};
+
+// ==================================================================================
+// ARRAYS, SUBGRAPHS AND INPUTS
+// ==================================================================================
+
+// Out-of-range access returns a scratch element instead of faulting, as ACSIL arrays do
+template <typename T>
+class SCArray {
+public:
+    T& operator[](int index)
+    {
+        if (index < 0 || index >= static_cast<int>(m_values.size()))
+        {
+            m_scratch = T();
+            return m_scratch;
+        }
+        return m_values[index];
+    }
+    const T& operator[](int index) const { return const_cast<SCArray*>(this)->operator[](index); }
+
+    int GetArraySize() const { return static_cast<int>(m_values.size()); }
+    void Resize(int size) { m_values.resize(size > 0 ? size : 0); }
+
+    // Engine only: moves the values into a block of the arena with room for capacity bars
+    void Reserve(MemoryArena* arena, int capacity)
+    {
+        std::vector<T, ArenaAllocator<T>> values{ArenaAllocator<T>(arena)};
+        values.reserve(capacity > static_cast<int>(m_values.size()) ? capacity : m_values.size());
+        values.assign(m_values.begin(), m_values.end());
+        m_values.swap(values);
+    }
+    static size_t ReserveBytes(int capacity) { return ((capacity * sizeof(T) + 63) & ~size_t(63)); }
+
+private:
+    std::vector<T, ArenaAllocator<T>> m_values;
+    T m_scratch = T();
+};
+
+typedef SCArray<float> SCFloatArray;
+typedef SCFloatArray& SCFloatArrayRef;
+typedef SCArray<SCDateTime> SCDateTimeArray;
+
+struct SCSubgraph {
+    SCString Name;
+    int DrawStyle = DRAWSTYLE_LINE;
+    COLORREF PrimaryColor = 0;
+    COLORREF SecondaryColor = 0;
+    int LineWidth = 1;
+    bool DrawZeros = true;
+    SCFloatArray Data;
+    SCArray<COLORREF> DataColor;
+
+    float& operator[](int index) { return Data[index]; }
+    operator SCFloatArrayRef() { return Data; }
+    void Resize(int size) { Data.Resize(size); DataColor.Resize(size); }
+    void Reserve(MemoryArena* arena, int capacity) { Data.Reserve(arena, capacity); DataColor.Reserve(arena, capacity); }
+};
+
+enum HeadlessInputType { INPUT_NONE, INPUT_YESNO, INPUT_INT, INPUT_FLOAT, INPUT_TIME, INPUT_STRING, INPUT_PATH, INPUT_CUSTOM };
+
+struct SCInput {
+    SCString Name;
+    HeadlessInputType Type = INPUT_NONE;
+    int IntValue = 0;
+    float FloatValue = 0.0f;
+    std::string StringValue;
+
+    void SetDescription(const char*) {}
+    void SetYesNo(int value) { Type = INPUT_YESNO; IntValue = value ? 1 : 0; }
+    void SetInt(int value) { Type = INPUT_INT; IntValue = value; }
+    void SetIntLimits(int, int) {}
+    void SetFloat(float value) { Type = INPUT_FLOAT; FloatValue = value; }
+    void SetFloatLimits(float, float) {}
+    void SetTime(int secondsOfDay) { Type = INPUT_TIME; IntValue = secondsOfDay; }
+    void SetString(const char* value) { Type = INPUT_STRING; StringValue = value ? value : ""; }
+    void SetPathAndFileName(const char* value) { Type = INPUT_PATH; StringValue = value ? value : ""; }
+    void SetCustomInputStrings(const char*) { Type = INPUT_CUSTOM; }
+    void SetCustomInputIndex(int index) { Type = INPUT_CUSTOM; IntValue = index; }
+
+    int GetYesNo() const { return IntValue; }
+    int GetInt() const { return IntValue; }
+    float GetFloat() const { return FloatValue; }
+    int GetTime() const { return IntValue; }
+    int GetIndex() const { return IntValue; }
+    const char* GetString() const { return StringValue.c_str(); }
+    const char* GetPathAndFileName() const { return StringValue.c_str(); }
+
+    // Headless configuration: applies "value" according to the type set in SetDefaults
+    bool SetFromText(const std::string& value)
+    {
+        switch (Type)
+        {
+        case INPUT_YESNO:
+            IntValue = (value == "1" || value == "yes" || value == "Yes" || value == "true") ? 1 : 0;
+            return true;
+        case INPUT_INT:
+        case INPUT_CUSTOM:
+            IntValue = std::atoi(value.c_str());
+            return true;
+        case INPUT_FLOAT:
+            FloatValue = static_cast<float>(std::atof(value.c_str()));
+            return true;
+        case INPUT_TIME:
+        {
+            int hour = 0, minute = 0, second = 0;
+            if (std::sscanf(value.c_str(), "%d:%d:%d", &hour, &minute, &second) < 2) return false;
+            IntValue = HMS_TIME(hour, minute, second);
+            return true;
+        }
+        case INPUT_STRING:
+        case INPUT_PATH:
+            StringValue = value;
+            return true;
+        default:
+            return false;
+        }
+    }
+};
+
+typedef SCInput& SCInputRef;
+
+// ==================================================================================
+// TRADING AND DRAWING STRUCTURES
+// ==================================================================================
+
+struct s_SCPositionData {
+    double PositionQuantity = 0;
+    double AveragePrice = 0;
+    double OpenProfitLoss = 0;
+    double DailyProfitLoss = 0;
+};
+
+struct s_SCNewOrder {
+    int OrderQuantity = 0;
+    int OrderType = SCT_ORDERTYPE_MARKET;
+    int TimeInForce = SCT_TIF_DAY;
+    double Price1 = 0;
+    double Stop1Offset = 0;
+    double Target1Offset = 0;
+    SCString TextTag;
+    int InternalOrderID = 0;    // Set by BuyEntry/SellEntry
+};
+
+struct s_SCTradeOrder {
+    int InternalOrderID = 0;
+    SCOrderStatusCodeEnum OrderStatusCode = SCT_OSC_UNSPECIFIED;
+    double OrderQuantity = 0;
+    double FilledQuantity = 0;
+    double AvgFillPrice = 0;
+};
+
+struct s_UseTool {
+    int ChartNumber = 0;
+    int DrawingType = 0;
+    int LineNumber = 0;
+    int AddMethod = UTAM_ADD_OR_ADJUST;
+    int Region = 0;
+    int UseRelativeVerticalValues = 0;
+    int BeginIndex = 0;
+    int EndIndex = 0;
+    float BeginValue = 0;
+    float EndValue = 0;
+    SCDateTime BeginDateTime;
+    SCDateTime EndDateTime;
+    COLORREF Color = 0;
+    COLORREF SecondaryColor = 0;
+    int LineWidth = 1;
+    int FontSize = 0;
+    int FontBold = 0;
+    int TransparencyLevel = 0;
+    SCString Text;
+
+    void Clear() { *this = s_UseTool(); }
+};
+
+struct s_MarketDepthEntry {
+    float Price = 0;
+    t_MarketDataQuantity Quantity = 0;
+    unsigned int NumOrders = 0;
+};
+
+struct s_TimeAndSales {
+    SCDateTime DateTime;
+    int Type = SC_TS_MARKER;
+    float Price = 0;
+    t_MarketDataQuantity Volume = 0;
+    unsigned int Sequence = 0;
+};
+
+struct s_VolumeAtPriceV2 {
+    int PriceInTicks = 0;
+    unsigned int Volume = 0;
+    unsigned int BidVolume = 0;
+    unsigned int AskVolume = 0;
+    unsigned int NumberOfTrades = 0;
+};
+
+// Volume at price per bar; frames carry bar totals only, so every bar is empty
+class c_VAPContainer {
+public:
+    int GetSizeAtBarIndex(int) const { return 0; }
+    bool GetVAPElementAtIndex(int, int, s_VolumeAtPriceV2** element) const { *element = nullptr; return false; }
+};
+
+class c_SCTimeAndSalesArray {
+public:
+    int Size() const { return static_cast<int>(m_records.size()); }
+    const s_TimeAndSales& operator[](int index) const { return m_records[index]; }
+    void Clear() { m_records.clear(); }
+
+private:
+    std::vector<s_TimeAndSales> m_records;
+};
+
+struct SCStudyInterface;
+
+// Where BuyEntry/SellEntry/FlattenPosition go in the headless build. Returns an order id > 0.
+class HeadlessOrderRouter {
+public:
+    virtual ~HeadlessOrderRouter() {}
+    virtual int SubmitEntry(SCStudyInterface& sc, int side, const s_SCNewOrder& order) = 0;
+    virtual int Flatten(SCStudyInterface& sc) = 0;
+    virtual bool GetOrder(int orderId, s_SCTradeOrder& order) = 0;     // Recent orders only
+    virtual void Log(SCStudyInterface& sc, const char* message) = 0;
+};
+
+// ==================================================================================
+// STUDY INTERFACE
+// ==================================================================================
+
+enum { SC_OPEN, SC_HIGH, SC_LOW, SC_LAST, SC_VOLUME, SC_NUM_TRADES, SC_BIDVOL, SC_ASKVOL, SC_BASE_DATA_COUNT };
+
+struct SCStudyInterface {
+    // Study configuration
+    int SetDefaults = 0;
+    int LastCallToFunction = 0;
+    int IsFullRecalculation = 0;
+    SCString GraphName;
+    SCString StudyDescription;
+    int AutoLoop = 0;
+    int GraphRegion = 0;
+    int IsAutoTradingEnabled = 0;
+    int MaintainVolumeAtPriceData = 0;
+    int UsesMarketDepthData = 0;
+    c_VAPContainer* VolumeAtPriceForBars = nullptr;
+    int CalculationPrecedence = 0;
+    int FreeDLL = 0;
+    int ChartNumber = 1;
+    int StudyGraphInstanceID = 1;
+
+    // Symbol
+    SCString Symbol;
+    float TickSize = 0.0f;
+    float CurrencyValuePerTick = 0.0f;
+
+    // Bars
+    int ArraySize = 0;
+    int UpdateStartIndex = 0;
+    int Index = 0;
+    int IndexOfFirstVisibleBar = 0;
+    int IndexOfLastVisibleBar = 0;
+    int UpdateAlways = 0;
+    SCDateTime CurrentSystemDateTime;
+    SCDateTime LatestDateTimeForLastBar;
+    SCDateTime TimeScaleAdjustment;         // Added to Time & Sales times (UTC) for chart time
+    SCFloatArray BaseData[SC_BASE_DATA_COUNT];
+    SCFloatArray& Open = BaseData[SC_OPEN];
+    SCFloatArray& High = BaseData[SC_HIGH];
+    SCFloatArray& Low = BaseData[SC_LOW];
+    SCFloatArray& Close = BaseData[SC_LAST];
+    SCFloatArray& Volume = BaseData[SC_VOLUME];
+    SCFloatArray& NumberOfTrades = BaseData[SC_NUM_TRADES];
+    SCFloatArray& BidVolume = BaseData[SC_BIDVOL];
+    SCFloatArray& AskVolume = BaseData[SC_ASKVOL];
+    SCDateTimeArray BaseDateTimeIn;
+
+    SCSubgraph Subgraph[60];
+    SCInput Input[128];
+
+    // Headless engine state
+    HeadlessOrderRouter* OrderRouter = nullptr;
+    s_SCPositionData Position;
+    int NewBarIndex = 0;        // Bars at or after this index are new since the previous call
+
+    SCStudyInterface() {}
+    SCStudyInterface(const SCStudyInterface&) = delete;
+    SCStudyInterface& operator=(const SCStudyInterface&) = delete;
+
+    void SetArraySize(int size)
+    {
+        for (SCFloatArray& array : BaseData) array.Resize(size);
+        BaseDateTimeIn.Resize(size);
+        for (SCSubgraph& subgraph : Subgraph) subgraph.Resize(size);
+        ArraySize = size;
+    }
+
+    // Engine only: places every bar and subgraph array in one arena, sized for capacity bars
+    void ReserveArrays(MemoryArena* arena, int capacity)
+    {
+        for (SCFloatArray& array : BaseData) array.Reserve(arena, capacity);
+        BaseDateTimeIn.Reserve(arena, capacity);
+        for (SCSubgraph& subgraph : Subgraph) subgraph.Reserve(arena, capacity);
+    }
+
+    static size_t ArrayBytes(int capacity)
+    {
+        return SC_BASE_DATA_COUNT * SCFloatArray::ReserveBytes(capacity) + SCDateTimeArray::ReserveBytes(capacity) +
+               60 * (SCFloatArray::ReserveBytes(capacity) + SCArray<COLORREF>::ReserveBytes(capacity));
+    }
+
+    // Persistent storage
+    void SetPersistentPointer(int key, void* pointer) { m_persistentPointers[key] = pointer; }
+    void* GetPersistentPointer(int key) { return m_persistentPointers[key]; }
+    void SetPersistentInt(int key, int value) { m_persistentInts[key] = value; }
+    int& GetPersistentInt(int key) { return m_persistentInts[key]; }
+    void SetPersistentFloat(int key, float value) { m_persistentFloats[key] = value; }
+    float& GetPersistentFloat(int key) { return m_persistentFloats[key]; }
+    void SetPersistentDouble(int key, double value) { m_persistentDoubles[key] = value; }
+    double& GetPersistentDouble(int key) { return m_persistentDoubles[key]; }
+
+    // Bar state
+    int IsNewBar(int index) { return index >= NewBarIndex; }
+    int IsNewTradingDay(int index)
+    {
+        if (index <= 0 || index >= ArraySize) return index == 0;
+        return BaseDateTimeIn[index].GetDate() != BaseDateTimeIn[index - 1].GetDate();
+    }
+    int GetTradingDayDate(const SCDateTime& dateTime) { return dateTime.GetDate(); }    // Sessions are calendar days
+    int GetBarHasClosedStatus(int index) { return index < ArraySize - 1; }
+
+    // Auto-loop form: calculates at sc.Index
+    void SimpleMovAvg(SCFloatArrayRef in, SCFloatArrayRef out, int length) { SimpleMovAvg(in, out, Index, length); }
+    void SimpleMovAvg(SCFloatArrayRef in, SCFloatArrayRef out, int index, int length)
+    {
+        if (length <= 0 || index < length - 1) return;
+        float sum = 0.0f;
+        for (int i = index - length + 1; i <= index; i++) sum += in[i];
+        out[index] = sum / length;
+    }
+
+    int GetIndexOfHighestValue(SCFloatArrayRef in, int startIndex, int endIndex)
+    {
+        int best = startIndex;
+        for (int i = startIndex + 1; i <= endIndex; i++)
+            if (in[i] > in[best]) best = i;
+        return best;
+    }
+
+    int GetIndexOfLowestValue(SCFloatArrayRef in, int startIndex, int endIndex)
+    {
+        int best = startIndex;
+        for (int i = startIndex + 1; i <= endIndex; i++)
+            if (in[i] < in[best]) best = i;
+        return best;
+    }
+
+    // Market depth: the framed feed carries bars only, so the book is always empty
+    int GetBidMarketDepthEntryAtLevel(s_MarketDepthEntry& entry, int) { entry = s_MarketDepthEntry(); return 0; }
+    int GetAskMarketDepthEntryAtLevel(s_MarketDepthEntry& entry, int) { entry = s_MarketDepthEntry(); return 0; }
+
+    // Time & Sales: likewise empty, the study sees bar totals only
+    int GetTimeAndSales(c_SCTimeAndSalesArray& records) { records.Clear(); return 1; }
+
+    // Trading
+    int GetTradePosition(s_SCPositionData& position) { position = Position; return 1; }
+    int BuyEntry(s_SCNewOrder& order) { return SubmitEntry(1, order); }
+    int SellEntry(s_SCNewOrder& order) { return SubmitEntry(-1, order); }
+    int FlattenPosition() { return OrderRouter ? OrderRouter->Flatten(*this) : 0; }
+    int GetOrderByOrderID(int orderId, s_SCTradeOrder& order)
+    {
+        return (OrderRouter && OrderRouter->GetOrder(orderId, order)) ? 1 : SCTRADING_ORDER_ERROR;
+    }
+
+    // Output
+    void AddMessageToLog(const char* message, int)
+    {
+        if (OrderRouter) OrderRouter->Log(*this, message);
+        else std::fprintf(stderr, "%s\n", message);
+    }
+    int UseTool(s_UseTool&) { return 1; }
+
+private:
+    int SubmitEntry(int side, s_SCNewOrder& order)
+    {
+        int orderId = OrderRouter ? OrderRouter->SubmitEntry(*this, side, order) : 0;
+        if (orderId > 0) order.InternalOrderID = orderId;
+        return orderId;
+    }
+
+    std::map<int, void*> m_persistentPointers;
+    std::map<int, int> m_persistentInts;
+    std::map<int, float> m_persistentFloats;
+    std::map<int, double> m_persistentDoubles;
+};
+
+typedef SCStudyInterface& SCStudyInterfaceRef;